@@ -5,9 +5,35 @@
 #include "display.h"
 #include "axlib.h"
 
+#include <atomic>
+
 #define internal static
 #define AX_APPLICATION_RETRIES 10
 
+/* NOTE: Every window with a valid ID, across all applications, is also stored in an
+         open addressed hash table so that it can be found without knowing which
+         application it belongs to. Writers are serialized by WindowTableLock and
+         bump WindowTableSequence around each change. Readers take no lock: they
+         probe the table and retry if the sequence moved while they were reading.
+         Entries are removed by shifting the rest of the probe chain back, so no
+         tombstones build up as windows come and go. A table that is replaced by a
+         larger one is never freed, as a reader may still be probing it. Tables
+         double in size, so this costs less memory than the live table itself. */
+#define AX_WINDOW_TABLE_BITS 8
+
+struct ax_window_table
+{
+    uint32_t Bits;
+    uint32_t Mask;
+    std::atomic<uint32_t> *Keys;
+    std::atomic<ax_window *> *Values;
+};
+
+internal std::atomic<ax_window_table *> WindowTable;
+internal std::atomic<uint32_t> WindowTableSequence;
+internal pthread_mutex_t WindowTableLock = PTHREAD_MUTEX_INITIALIZER;
+internal uint32_t WindowTableCount;
+
 enum ax_application_notifications
 {
     AXApplication_Notification_WindowCreated,
@@ -48,6 +74,190 @@ AXNotificationFromEnum(int Type)
     }
 }
 
+internal ax_window_table *
+AXLibCreateWindowTable(uint32_t Bits)
+{
+    ax_window_table *Table = (ax_window_table *) malloc(sizeof(ax_window_table));
+    Table->Bits = Bits;
+    Table->Mask = (1 << Bits) - 1;
+    Table->Keys = new std::atomic<uint32_t>[1 << Bits];
+    Table->Values = new std::atomic<ax_window *>[1 << Bits];
+    for(uint32_t Index = 0; Index <= Table->Mask; ++Index)
+    {
+        Table->Keys[Index].store(0, std::memory_order_relaxed);
+        Table->Values[Index].store(NULL, std::memory_order_relaxed);
+    }
+
+    return Table;
+}
+
+internal inline uint32_t
+AXLibWindowTableSlot(ax_window_table *Table, uint32_t WID)
+{
+    return (WID * 0x9E3779B1) >> (32 - Table->Bits);
+}
+
+internal ax_window *
+AXLibWindowTableLookup(ax_window_table *Table, uint32_t WID)
+{
+    uint32_t Slot = AXLibWindowTableSlot(Table, WID);
+    for(uint32_t Probe = 0; Probe <= Table->Mask; ++Probe)
+    {
+        uint32_t Key = Table->Keys[Slot].load(std::memory_order_relaxed);
+        if(Key == 0)
+            break;
+
+        if(Key == WID)
+            return Table->Values[Slot].load(std::memory_order_relaxed);
+
+        Slot = (Slot + 1) & Table->Mask;
+    }
+
+    return NULL;
+}
+
+internal void
+AXLibWindowTableInsert(ax_window_table *Table, uint32_t WID, ax_window *Window)
+{
+    uint32_t Slot = AXLibWindowTableSlot(Table, WID);
+    while(true)
+    {
+        uint32_t Key = Table->Keys[Slot].load(std::memory_order_relaxed);
+        if(Key == 0 || Key == WID)
+        {
+            Table->Values[Slot].store(Window, std::memory_order_relaxed);
+            Table->Keys[Slot].store(WID, std::memory_order_relaxed);
+            return;
+        }
+
+        Slot = (Slot + 1) & Table->Mask;
+    }
+}
+
+internal void
+AXLibWindowTableErase(ax_window_table *Table, uint32_t WID)
+{
+    uint32_t Hole = AXLibWindowTableSlot(Table, WID);
+    while(Table->Keys[Hole].load(std::memory_order_relaxed) != WID)
+    {
+        if(Table->Keys[Hole].load(std::memory_order_relaxed) == 0)
+            return;
+
+        Hole = (Hole + 1) & Table->Mask;
+    }
+
+    uint32_t Slot = Hole;
+    while(true)
+    {
+        Slot = (Slot + 1) & Table->Mask;
+        uint32_t Key = Table->Keys[Slot].load(std::memory_order_relaxed);
+        if(Key == 0)
+            break;
+
+        /* NOTE: An entry can only move back into the hole if its home slot
+                 is not in the cyclic range (Hole, Slot]. */
+        uint32_t Home = AXLibWindowTableSlot(Table, Key);
+        bool Reachable = Hole <= Slot ? (Hole < Home && Home <= Slot) : (Hole < Home || Home <= Slot);
+        if(Reachable)
+            continue;
+
+        Table->Keys[Hole].store(Key, std::memory_order_relaxed);
+        Table->Values[Hole].store(Table->Values[Slot].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        Hole = Slot;
+    }
+
+    Table->Keys[Hole].store(0, std::memory_order_relaxed);
+    Table->Values[Hole].store(NULL, std::memory_order_relaxed);
+}
+
+internal inline void
+AXLibBeginWindowTableWrite()
+{
+    pthread_mutex_lock(&WindowTableLock);
+    WindowTableSequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+internal inline void
+AXLibEndWindowTableWrite()
+{
+    WindowTableSequence.fetch_add(1, std::memory_order_release);
+    pthread_mutex_unlock(&WindowTableLock);
+}
+
+internal void
+AXLibAddWindowToTable(ax_window *Window)
+{
+    if(Window->ID == 0)
+        return;
+
+    AXLibBeginWindowTableWrite();
+    ax_window_table *Table = WindowTable.load(std::memory_order_relaxed);
+    if(!Table)
+    {
+        Table = AXLibCreateWindowTable(AX_WINDOW_TABLE_BITS);
+        WindowTable.store(Table, std::memory_order_release);
+    }
+    else if((WindowTableCount + 1) * 4 > (Table->Mask + 1) * 3)
+    {
+        ax_window_table *Grown = AXLibCreateWindowTable(Table->Bits + 1);
+        for(uint32_t Index = 0; Index <= Table->Mask; ++Index)
+        {
+            uint32_t Key = Table->Keys[Index].load(std::memory_order_relaxed);
+            if(Key != 0)
+                AXLibWindowTableInsert(Grown, Key, Table->Values[Index].load(std::memory_order_relaxed));
+        }
+
+        WindowTable.store(Grown, std::memory_order_release);
+        Table = Grown;
+    }
+
+    if(!AXLibWindowTableLookup(Table, Window->ID))
+        ++WindowTableCount;
+
+    AXLibWindowTableInsert(Table, Window->ID, Window);
+    AXLibEndWindowTableWrite();
+}
+
+internal void
+AXLibRemoveWindowFromTable(uint32_t WID)
+{
+    if(WID == 0)
+        return;
+
+    AXLibBeginWindowTableWrite();
+    ax_window_table *Table = WindowTable.load(std::memory_order_relaxed);
+    if(Table && AXLibWindowTableLookup(Table, WID))
+    {
+        AXLibWindowTableErase(Table, WID);
+        --WindowTableCount;
+    }
+    AXLibEndWindowTableWrite();
+}
+
+/* NOTE: Must be thread-safe! Lock-free lookup of a window by its ID, in any application. */
+ax_window *AXLibFindWindow(uint32_t WID)
+{
+    if(WID == 0)
+        return NULL;
+
+    while(true)
+    {
+        uint32_t Sequence = WindowTableSequence.load(std::memory_order_acquire);
+        if(Sequence & 1)
+            continue;
+
+        ax_window *Result = NULL;
+        ax_window_table *Table = WindowTable.load(std::memory_order_acquire);
+        if(Table)
+            Result = AXLibWindowTableLookup(Table, WID);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(WindowTableSequence.load(std::memory_order_relaxed) == Sequence)
+            return Result;
+    }
+}
+
 internal inline ax_window *
 AXLibGetWindowByRef(ax_application *Application, AXUIElementRef WindowRef)
 {
@@ -68,6 +278,11 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
 
     if(CFEqual(Notification, kAXWindowCreatedNotification))
     {
+        /* NOTE: Notifications are queued until the observer is started, so a window that was
+                 created during AXLibDiscoverApplication may already have been added. */
+        if(AXLibGetWindowByRef(Application, Element))
+            return;
+
         ax_window *Window = AXLibConstructWindow(Application, Element);
         if(AXLibAddObserverNotification(&Application->Observer, Window->Ref, kAXUIElementDestroyedNotification, Window) == kAXErrorSuccess)
         {
@@ -199,6 +414,7 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
 
                 Window->ID = AXLibGetWindowID(Window->Ref);
                 Window->Application->Windows[Window->ID] = Window;
+                AXLibAddWindowToTable(Window);
             }
 
             /* NOTE(koekeishiya): kAXWindowDeminiaturized is sent before didActiveSpaceChange, when a deminimized
@@ -226,11 +442,17 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
     }
     else if(CFEqual(Notification, kAXWindowMovedNotification))
     {
-        /* NOTE(koekeishiya): Triggers an AXEvent_WindowMoved and passes a pointer to the ax_window */
+        /* NOTE(koekeishiya): Triggers an AXEvent_WindowMoved and passes a pointer to the ax_window,
+                              unless this is the echo of a position that we set ourselves. */
         ax_window *Window = AXLibGetWindowByRef(Application, Element);
         if(Window)
         {
             Window->Position = AXLibGetWindowPosition(Window->Ref);
+            if(AXLibIsExpectedWindowFrame(Window, AXWindow_MoveIntrinsic))
+            {
+                AXLibClearFlags(Window, AXWindow_MoveIntrinsic);
+                return;
+            }
 
             bool Intrinsic = AXLibHasFlags(Window, AXWindow_MoveIntrinsic);
             uint32_t *WindowID = (uint32_t *) malloc(sizeof(uint32_t));
@@ -242,12 +464,23 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
     }
     else if(CFEqual(Notification, kAXWindowResizedNotification))
     {
-        /* NOTE(koekeishiya): Triggers an AXEvent_WindowResized and passes a pointer to the ax_window */
+        /* NOTE(koekeishiya): Triggers an AXEvent_WindowResized and passes a pointer to the ax_window,
+                              unless this is the echo of a size that we set ourselves. */
         ax_window *Window = AXLibGetWindowByRef(Application, Element);
         if(Window)
         {
             Window->Position = AXLibGetWindowPosition(Window->Ref);
             Window->Size = AXLibGetWindowSize(Window->Ref);
+            if(AXLibIsWindowFullscreen(Window->Ref))
+                AXLibAddFlags(Window, AXWindow_Fullscreen);
+            else
+                AXLibClearFlags(Window, AXWindow_Fullscreen);
+
+            if(AXLibIsExpectedWindowFrame(Window, AXWindow_SizeIntrinsic))
+            {
+                AXLibClearFlags(Window, AXWindow_SizeIntrinsic);
+                return;
+            }
 
             bool Intrinsic = AXLibHasFlags(Window, AXWindow_SizeIntrinsic);
             uint32_t *WindowID = (uint32_t *) malloc(sizeof(uint32_t));
@@ -298,7 +531,6 @@ AXLibAddApplicationObserver(ax_application *Application)
             }
         }
 
-        AXLibStartObserver(&Application->Observer);
         return AXLibHasApplicationObserverNotification(Application);
     }
 
@@ -329,12 +561,39 @@ ax_application *AXLibConstructApplication(pid_t PID, std::string Name)
 
     Application->Ref = AXUIElementCreateApplication(PID);
     GetProcessForPID(PID, &Application->PSN);
-    Application->Name = Name;
+    Application->Name = AXLibInternString(Name.c_str());
     Application->PID = PID;
+    AXLibStartApplicationWorker(Application);
 
     return Application;
 }
 
+internal void
+AXLibRetryInitializeApplication(ax_application *Application)
+{
+    pid_t PID = Application->PID;
+    if(++Application->Retries < AX_APPLICATION_RETRIES)
+    {
+#ifdef DEBUG_BUILD
+        printf("AX: %s - Not responding, retry %d\n", Application->Name->Text, Application->Retries);
+#endif
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 1 * NSEC_PER_SEC), dispatch_get_main_queue(),
+        ^{
+            if(AXLibInitializeApplication(PID))
+                AXLibInitializedApplication(Application);
+        });
+    }
+    else
+    {
+#ifdef DEBUG_BUILD
+        printf("AX: %s did not respond, remove application reference\n", Application->Name->Text);
+#endif
+        pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
+        *ApplicationPID = Application->PID;
+        AXLibConstructEvent(AXEvent_ApplicationTerminated, ApplicationPID, false);
+    }
+}
+
 bool AXLibInitializeApplication(pid_t PID)
 {
     BeginAXLibApplications();
@@ -348,30 +607,12 @@ bool AXLibInitializeApplication(pid_t PID)
         {
             AXLibAddApplicationWindows(Application);
             Application->Focus = AXLibGetFocusedWindow(Application);
+            AXLibStartObserver(&Application->Observer);
         }
         else
         {
             AXLibRemoveApplicationObserver(Application);
-            if(++Application->Retries < AX_APPLICATION_RETRIES)
-            {
-#ifdef DEBUG_BUILD
-                printf("AX: %s - Not responding, retry %d\n", Application->Name.c_str(), Application->Retries);
-#endif
-                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 1 * NSEC_PER_SEC), dispatch_get_main_queue(),
-                ^{
-                    if(AXLibInitializeApplication(PID))
-                        AXLibInitializedApplication(Application);
-                });
-            }
-            else
-            {
-#ifdef DEBUG_BUILD
-                printf("AX: %s did not respond, remove application reference\n", Application->Name.c_str());
-#endif
-                pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
-                *ApplicationPID = Application->PID;
-                AXLibConstructEvent(AXEvent_ApplicationTerminated, ApplicationPID, false);
-            }
+            AXLibRetryInitializeApplication(Application);
         }
 
         return Result;
@@ -380,6 +621,38 @@ bool AXLibInitializeApplication(pid_t PID)
     return false;
 }
 
+/* NOTE: Initializes an application that is not yet in the application map, and so can be called
+         from any thread. Windows are added until the deadline passes; any that remain are picked up
+         by the next call to AXLibAddApplicationWindows. The deadline is only checked between
+         windows, so it does not bound a single AX call that hangs.
+         The observer is registered but not started, so that no notification can touch the windows
+         of the application while they are added. The caller starts it with
+         AXLibStartApplicationObserver once the application is in the map. On failure a retry is
+         scheduled, which also requires the caller to add the application to the map before
+         returning to the run loop. */
+bool AXLibDiscoverApplication(ax_application *Application, uint64_t Deadline)
+{
+    bool Result = AXLibAddApplicationObserver(Application);
+    if(Result)
+    {
+        AXLibAddApplicationWindowsUntil(Application, Deadline);
+        Application->Focus = AXLibGetFocusedWindow(Application);
+    }
+    else
+    {
+        AXLibRemoveApplicationObserver(Application);
+        AXLibRetryInitializeApplication(Application);
+    }
+
+    return Result;
+}
+
+void AXLibStartApplicationObserver(ax_application *Application)
+{
+    if(Application->Observer.Valid)
+        AXLibStartObserver(&Application->Observer);
+}
+
 void AXLibInitializedApplication(ax_application *Application)
 {
     pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
@@ -401,12 +674,26 @@ void AXLibInitializedApplication(ax_application *Application)
 
 void AXLibAddApplicationWindows(ax_application *Application)
 {
+    AXLibAddApplicationWindowsUntil(Application, 0);
+}
+
+/* NOTE: A deadline of zero means no deadline. Returns false if the deadline passed
+         before every window was added. */
+bool AXLibAddApplicationWindowsUntil(ax_application *Application, uint64_t Deadline)
+{
+    bool Result = true;
     CFArrayRef Windows = (CFArrayRef) AXLibGetWindowProperty(Application->Ref, kAXWindowsAttribute);
     if(Windows)
     {
         CFIndex Count = CFArrayGetCount(Windows);
         for(CFIndex Index = 0; Index < Count; ++Index)
         {
+            if((Deadline) && (AXLibCurrentTime() >= Deadline))
+            {
+                Result = false;
+                break;
+            }
+
             AXUIElementRef Ref = (AXUIElementRef) CFArrayGetValueAtIndex(Windows, Index);
             if(!AXLibGetWindowByRef(Application, Ref))
             {
@@ -423,6 +710,8 @@ void AXLibAddApplicationWindows(ax_application *Application)
         }
         CFRelease(Windows);
     }
+
+    return Result;
 }
 
 void AXLibRemoveApplicationWindows(ax_application *Application)
@@ -435,6 +724,7 @@ void AXLibRemoveApplicationWindows(ax_application *Application)
         ++It)
     {
         ax_window *Window = It->second;
+        AXLibRemoveWindowFromTable(Window->ID);
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXUIElementDestroyedNotification);
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXWindowMiniaturizedNotification);
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXWindowDeminiaturizedNotification);
@@ -461,7 +751,10 @@ void AXLibAddApplicationWindow(ax_application *Application, ax_window *Window)
         if(Window->ID == 0)
             Application->NullWindows.push_back(Window);
         else
+        {
             Application->Windows[Window->ID] = Window;
+            AXLibAddWindowToTable(Window);
+        }
     }
 }
 
@@ -474,6 +767,7 @@ void AXLibRemoveApplicationWindow(ax_application *Application, uint32_t WID)
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXWindowMiniaturizedNotification);
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXWindowDeminiaturizedNotification);
         Application->Windows.erase(WID);
+        AXLibRemoveWindowFromTable(WID);
     }
 }
 
@@ -496,7 +790,9 @@ void AXLibDestroyApplication(ax_application *Application)
 {
     AXLibRemoveApplicationWindows(Application);
     AXLibRemoveApplicationObserver(Application);
+    AXLibStopApplicationWorker(Application);
     CFRelease(Application->Ref);
     Application->Ref = NULL;
+    AXLibReleaseString(Application->Name);
     delete Application;
 }
@@ -10,6 +10,7 @@
 
 #include "window.h"
 #include "observer.h"
+#include "worker.h"
 
 typedef std::map<uint32_t, ax_window *> ax_window_map;
 typedef std::map<uint32_t, ax_window *>::iterator ax_window_map_iter;
@@ -25,7 +26,7 @@ enum ax_application_flags
 struct ax_application
 {
     AXUIElementRef Ref;
-    std::string Name;
+    ax_string *Name;
     pid_t PID;
 
     ProcessSerialNumber PSN;
@@ -34,6 +35,8 @@ struct ax_application
     uint32_t Notifications;
     unsigned int Retries;
 
+    ax_application_worker *Worker;
+
     ax_window *Focus;
     ax_window_map Windows;
     std::vector<ax_window *> NullWindows;
@@ -62,11 +65,15 @@ ax_application *AXLibConstructApplication(pid_t PID, std::string Name);
 void AXLibDestroyApplication(ax_application *Application);
 
 bool AXLibInitializeApplication(pid_t PID);
+bool AXLibDiscoverApplication(ax_application *Application, uint64_t Deadline);
+void AXLibStartApplicationObserver(ax_application *Application);
 void AXLibInitializedApplication(ax_application *Application);
 
 void AXLibAddApplicationWindows(ax_application *Application);
+bool AXLibAddApplicationWindowsUntil(ax_application *Application, uint64_t Deadline);
 void AXLibRemoveApplicationWindows(ax_application *Application);
 
+ax_window *AXLibFindWindow(uint32_t WID);
 ax_window *AXLibFindApplicationWindow(ax_application *Application, uint32_t WID);
 void AXLibAddApplicationWindow(ax_application *Application, ax_window *Window);
 void AXLibRemoveApplicationWindow(ax_application *Application, uint32_t WID);
@@ -1,6 +1,12 @@
 #include "axlib.h"
 #include <pthread.h>
 #include <vector>
+#include <atomic>
+#include <set>
+
+#ifdef DEBUG_BUILD
+#include <stdio.h>
+#endif
 
 #define internal static
 #define local_persist static
@@ -14,11 +20,33 @@ extern "C" CGError CGSGetOnScreenWindowList(const CGSConnectionID CID, CGSConnec
 internal ax_state AXState;
 internal carbon_event_handler *Carbon;
 
+/* NOTE: Most users of the application map only read it, so it is guarded by a
+         reader/writer lock and readers on different threads do not block each
+         other. Wait and hold times are recorded separately for readers and writers. */
+struct ax_lock_counters
+{
+    std::atomic<uint64_t> Acquired;
+    std::atomic<uint64_t> TotalWait;
+    std::atomic<uint64_t> MaxWait;
+    std::atomic<uint64_t> TotalHold;
+    std::atomic<uint64_t> MaxHold;
+};
+
 internal ax_application_map *AXApplications;
-internal pthread_mutex_t AXApplicationsMutex;
+internal pthread_rwlock_t AXApplicationsLock = PTHREAD_RWLOCK_INITIALIZER;
+internal ax_lock_counters AXApplicationsReadCounters;
+internal ax_lock_counters AXApplicationsWriteCounters;
+internal __thread uint64_t AXApplicationsLockTime;
+internal __thread ax_lock_counters *AXApplicationsLockCounters;
 
 internal std::map<CGDirectDisplayID, ax_display> *AXDisplays;
 
+/* NOTE: Applications that are being initialized at startup are not in the application
+         map until they are done, so AXLibRunningApplications() must skip them. */
+internal ax_startup_stats StartupStats;
+internal std::set<pid_t> StartupApplications;
+internal pthread_mutex_t StartupLock = PTHREAD_MUTEX_INITIALIZER;
+
 internal inline AXUIElementRef
 AXLibSystemWideElement()
 {
@@ -277,6 +305,15 @@ uint32_t AXLibGetWindowBelowCursor()
 }
 
 /* NOTE(koekeishiya): Update state of known applications and their windows, stored inside the ax_state passed to AXLibInit(..). */
+internal inline bool
+AXLibIsStartupApplication(pid_t PID)
+{
+    pthread_mutex_lock(&StartupLock);
+    bool Result = StartupApplications.find(PID) != StartupApplications.end();
+    pthread_mutex_unlock(&StartupLock);
+    return Result;
+}
+
 void AXLibRunningApplications()
 {
     shared_ws_map List = SharedWorkspaceRunningApplications();
@@ -284,6 +321,9 @@ void AXLibRunningApplications()
         It != List.end();
         ++It)
     {
+        if(AXLibIsStartupApplication(It->first))
+            continue;
+
         BeginAXLibApplications();
         ax_application *Application = AXLibGetApplicationByPID(It->first);
         EndAXLibApplications();
@@ -296,7 +336,7 @@ void AXLibRunningApplications()
         {
             Application = AXLibConstructApplication(It->first, It->second);
 
-            BeginAXLibApplications();
+            BeginAXLibApplicationsWrite();
             (*AXApplications)[Application->PID] = Application;
             EndAXLibApplications();
 
@@ -306,15 +346,183 @@ void AXLibRunningApplications()
     }
 }
 
+internal inline void
+AXLibUpdateMax(std::atomic<uint64_t> *Max, uint64_t Value)
+{
+    uint64_t Current = Max->load(std::memory_order_relaxed);
+    while((Value > Current) &&
+          (!Max->compare_exchange_weak(Current, Value, std::memory_order_relaxed)));
+}
+
+internal inline void
+AXLibLockedApplications(ax_lock_counters *Counters, uint64_t RequestTime)
+{
+    AXApplicationsLockTime = AXLibCurrentTime();
+    AXApplicationsLockCounters = Counters;
+
+    uint64_t Wait = AXApplicationsLockTime - RequestTime;
+    Counters->Acquired.fetch_add(1, std::memory_order_relaxed);
+    Counters->TotalWait.fetch_add(Wait, std::memory_order_relaxed);
+    AXLibUpdateMax(&Counters->MaxWait, Wait);
+}
+
+/* NOTE: Use for lookups and iteration only. Anything that inserts or erases
+         applications, or changes their state, must use BeginAXLibApplicationsWrite(). */
 ax_application_map *BeginAXLibApplications()
 {
-    pthread_mutex_lock(&AXApplicationsMutex);
+    uint64_t RequestTime = AXLibCurrentTime();
+    pthread_rwlock_rdlock(&AXApplicationsLock);
+    AXLibLockedApplications(&AXApplicationsReadCounters, RequestTime);
+    return AXApplications;
+}
+
+ax_application_map *BeginAXLibApplicationsWrite()
+{
+    uint64_t RequestTime = AXLibCurrentTime();
+    pthread_rwlock_wrlock(&AXApplicationsLock);
+    AXLibLockedApplications(&AXApplicationsWriteCounters, RequestTime);
     return AXApplications;
 }
 
 void EndAXLibApplications()
 {
-    pthread_mutex_unlock(&AXApplicationsMutex);
+    ax_lock_counters *Counters = AXApplicationsLockCounters;
+    uint64_t Hold = AXLibCurrentTime() - AXApplicationsLockTime;
+    pthread_rwlock_unlock(&AXApplicationsLock);
+
+    Counters->TotalHold.fetch_add(Hold, std::memory_order_relaxed);
+    AXLibUpdateMax(&Counters->MaxHold, Hold);
+}
+
+internal void
+AXLibCopyLockStats(ax_lock_counters *Counters, ax_lock_stats *Stats)
+{
+    Stats->Acquired = Counters->Acquired.load(std::memory_order_relaxed);
+    Stats->TotalWait = Counters->TotalWait.load(std::memory_order_relaxed);
+    Stats->MaxWait = Counters->MaxWait.load(std::memory_order_relaxed);
+    Stats->TotalHold = Counters->TotalHold.load(std::memory_order_relaxed);
+    Stats->MaxHold = Counters->MaxHold.load(std::memory_order_relaxed);
+}
+
+/* NOTE: Must be thread-safe! Times are in nanoseconds. */
+void AXLibApplicationsLockStats(ax_lock_stats *Read, ax_lock_stats *Write)
+{
+    AXLibCopyLockStats(&AXApplicationsReadCounters, Read);
+    AXLibCopyLockStats(&AXApplicationsWriteCounters, Write);
+}
+
+/* NOTE: Runs on a background thread. The application is published to the map when it is done, so
+         the rest of AXLib never sees a partially initialized application. Its observer is started
+         last, after which the windows of the application belong to the main run loop. */
+internal void
+AXLibStartupApplication(ax_application *Application)
+{
+    uint64_t StartTime = AXLibCurrentTime();
+    bool Initialized = AXLibDiscoverApplication(Application, StartTime + AX_STARTUP_APPLICATION_TIMEOUT);
+    uint64_t Elapsed = AXLibCurrentTime() - StartTime;
+    std::size_t Windows = Application->Windows.size();
+
+    BeginAXLibApplicationsWrite();
+    (*AXApplications)[Application->PID] = Application;
+    EndAXLibApplications();
+
+    pthread_mutex_lock(&StartupLock);
+    StartupApplications.erase(Application->PID);
+    StartupStats.Windows += Windows;
+    StartupStats.ApplicationTime += Elapsed;
+    if(Elapsed > StartupStats.MaxApplicationTime)
+        StartupStats.MaxApplicationTime = Elapsed;
+    if(Initialized)
+        ++StartupStats.Initialized;
+    if(Elapsed >= AX_STARTUP_APPLICATION_TIMEOUT)
+        ++StartupStats.TimedOut;
+    pthread_mutex_unlock(&StartupLock);
+
+    if(Initialized)
+    {
+        AXLibInitializedApplication(Application);
+        AXLibStartApplicationObserver(Application);
+    }
+}
+
+/* NOTE: Startup is dominated by AX round trips that are serialized per application,
+         but independent across applications. At most AX_STARTUP_CONCURRENCY of them
+         are initialized at the same time. The barrier gives up after AX_STARTUP_TIMEOUT,
+         so that a hung application can not hold up the initial layout. */
+internal void
+AXLibStartupApplications()
+{
+    uint64_t StartTime = AXLibCurrentTime();
+    uint64_t Deadline = StartTime + AX_STARTUP_TIMEOUT;
+    shared_ws_map List = SharedWorkspaceRunningApplications();
+    uint64_t ListTime = AXLibCurrentTime();
+
+    std::vector<ax_application *> Applications;
+    for(shared_ws_map_iter It = List.begin();
+        It != List.end();
+        ++It)
+    {
+        Applications.push_back(AXLibConstructApplication(It->first, It->second));
+    }
+
+    pthread_mutex_lock(&StartupLock);
+    for(std::size_t Index = 0; Index < Applications.size(); ++Index)
+        StartupApplications.insert(Applications[Index]->PID);
+
+    StartupStats.Applications = Applications.size();
+    StartupStats.ListTime = ListTime - StartTime;
+    StartupStats.ConstructTime = AXLibCurrentTime() - ListTime;
+    pthread_mutex_unlock(&StartupLock);
+
+    uint64_t InitializeTime = AXLibCurrentTime();
+    dispatch_queue_t Queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
+    dispatch_semaphore_t Slots = dispatch_semaphore_create(AX_STARTUP_CONCURRENCY);
+    dispatch_group_t Group = dispatch_group_create();
+
+    for(std::size_t Index = 0; Index < Applications.size(); ++Index)
+    {
+        /* NOTE: Once the barrier has expired, the remaining applications are no
+                 longer throttled, as nobody is waiting for them anyway. */
+        uint64_t Now = AXLibCurrentTime();
+        dispatch_semaphore_wait(Slots, dispatch_time(DISPATCH_TIME_NOW, Now < Deadline ? Deadline - Now : 0));
+
+        ax_application *Application = Applications[Index];
+        dispatch_group_async(Group, Queue,
+        ^{
+            AXLibStartupApplication(Application);
+            dispatch_semaphore_signal(Slots);
+        });
+    }
+
+    uint64_t Now = AXLibCurrentTime();
+    bool Completed = dispatch_group_wait(Group, dispatch_time(DISPATCH_TIME_NOW, Now < Deadline ? Deadline - Now : 0)) == 0;
+
+    pthread_mutex_lock(&StartupLock);
+    StartupStats.InitializeTime = AXLibCurrentTime() - InitializeTime;
+    StartupStats.Stragglers = StartupApplications.size();
+    pthread_mutex_unlock(&StartupLock);
+
+    /* NOTE: Stragglers still signal these, so they are only released when everyone
+             is done. Otherwise they are leaked, which only happens with a hung application. */
+    if(Completed)
+    {
+        dispatch_release(Group);
+        dispatch_release(Slots);
+    }
+
+#ifdef DEBUG_BUILD
+    printf("AX: startup %d applications, %d windows, %d stragglers in %llu ms\n",
+           StartupStats.Applications, StartupStats.Windows, StartupStats.Stragglers,
+           (AXLibCurrentTime() - StartTime) / (1000 * 1000));
+#endif
+}
+
+/* NOTE: Must be thread-safe! Stragglers keep adding to the counters after AXLibInit(..). */
+void AXLibStartupStats(ax_startup_stats *Stats)
+{
+    pthread_mutex_lock(&StartupLock);
+    *Stats = StartupStats;
+    pthread_mutex_unlock(&StartupLock);
 }
 
 /* NOTE(koekeishiya): This function is responsible for initializing internal variables used by AXLib, and must be
@@ -328,11 +536,6 @@ bool AXLibInit()
     AXDisplays = &AXState.Displays;
     AXApplications = &AXState.Applications;
 
-    if(pthread_mutex_init(&AXApplicationsMutex, NULL) != 0)
-    {
-        return false;
-    }
-
     if(!AXLibInitializeCarbonEventHandler(Carbon))
     {
         return false;
@@ -340,6 +543,6 @@ bool AXLibInit()
 
     SharedWorkspaceInitialize();
     AXLibInitializeDisplays(AXDisplays);
-    AXLibRunningApplications();
+    AXLibStartupApplications();
     return true;
 }
@@ -9,6 +9,8 @@
 #include "sharedworkspace.h"
 #include "event.h"
 #include "carbon.h"
+#include "worker.h"
+#include "intern.h"
 
 /*
  * NOTE(koekeishiya):
@@ -37,6 +39,38 @@
 typedef std::map<pid_t, ax_application *> ax_application_map;
 typedef std::map<pid_t, ax_application *>::iterator ax_application_map_iter;
 
+struct ax_lock_stats
+{
+    uint64_t Acquired;
+    uint64_t TotalWait;
+    uint64_t MaxWait;
+    uint64_t TotalHold;
+    uint64_t MaxHold;
+};
+
+/* NOTE: AXLibInit(..) initializes the running applications on a bounded number of
+         threads. Each application has AX_STARTUP_APPLICATION_TIMEOUT to add its windows,
+         and AXLibInit(..) waits at most AX_STARTUP_TIMEOUT for all of them. Applications
+         that are not done by then finish in the background. Times are in nanoseconds. */
+#define AX_STARTUP_CONCURRENCY 8
+#define AX_STARTUP_APPLICATION_TIMEOUT (1000 * 1000 * 1000ULL)
+#define AX_STARTUP_TIMEOUT (3 * 1000 * 1000 * 1000ULL)
+
+struct ax_startup_stats
+{
+    uint32_t Applications;
+    uint32_t Initialized;
+    uint32_t Windows;
+    uint32_t TimedOut;
+    uint32_t Stragglers;
+
+    uint64_t ListTime;
+    uint64_t ConstructTime;
+    uint64_t InitializeTime;
+    uint64_t ApplicationTime;
+    uint64_t MaxApplicationTime;
+};
+
 struct ax_state
 {
     carbon_event_handler Carbon;
@@ -57,6 +91,9 @@ bool AXLibInit();
 
 
 ax_application_map *BeginAXLibApplications();
+ax_application_map *BeginAXLibApplicationsWrite();
 void EndAXLibApplications();
+void AXLibApplicationsLockStats(ax_lock_stats *Read, ax_lock_stats *Write);
+void AXLibStartupStats(ax_startup_stats *Stats);
 
 #endif
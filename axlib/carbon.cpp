@@ -78,7 +78,7 @@ CarbonApplicationLaunched(ProcessSerialNumber PSN)
 
     ax_application *Application = AXLibConstructApplication(PID, Name);
 
-    ax_application_map *Applications = BeginAXLibApplications();
+    ax_application_map *Applications = BeginAXLibApplicationsWrite();
     (*Applications)[PID] = Application;
     EndAXLibApplications();
 
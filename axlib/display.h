@@ -3,7 +3,10 @@
 
 #include <Carbon/Carbon.h>
 #include <string>
+#include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
 
 /* NOTE(koekeishiya): User controlled spaces */
 #define kCGSSpaceUser 0
@@ -25,20 +28,50 @@ typedef int CGSSpaceID;
 typedef int CGSSpaceType;
 
 struct ax_window;
+struct ax_window_display;
 enum ax_space_flags
 {
     AXSpace_FastTransition = (1 << 0),
 };
 
+/* NOTE: Handle is a small integer that is unique per space identifier and stays the
+         same for as long as the process runs. They are handed out densely from 0,
+         so they can be used to index arrays of per-space state. */
 struct ax_space
 {
     std::string Identifier;
+    uint32_t Handle;
     CGSSpaceID ID;
     CGSSpaceType Type;
     uint32_t Flags;
     uint32_t FocusedWindow;
 };
 
+/* NOTE: The window-server does not tell us when a space transition ends, so it is
+         polled: at a short interval while a transition is known to be in progress,
+         and at a long interval otherwise, to catch transitions we were not told about. */
+#define AX_SPACE_TRANSITION_POLL (10 * 1000 * 1000ULL)
+#define AX_SPACE_TRANSITION_IDLE_POLL (100 * 1000 * 1000ULL)
+
+/* NOTE: The order of the spaces of a display, as shown in Mission Control. SpaceIDs is
+         indexed by desktop id - 1, and DesktopIDs maps back. The table is rebuilt
+         lazily, when Generation no longer matches AXLibInvalidateSpaceTopology(). */
+struct ax_space_topology
+{
+    uint32_t Generation;
+    std::vector<CGSSpaceID> SpaceIDs;
+    std::map<CGSSpaceID, unsigned int> DesktopIDs;
+};
+
+/* NOTE: Which windows of a set are on SpaceID, and which of those are also on any other space,
+         see AXLibSpacesForWindows. */
+struct ax_window_spaces
+{
+    CGSSpaceID SpaceID;
+    std::set<uint32_t> Windows;
+    std::set<uint32_t> Sticky;
+};
+
 struct ax_display
 {
     unsigned int ArrangementID;
@@ -49,6 +82,18 @@ struct ax_display
     ax_space *Space;
     ax_space *PrevSpace;
     std::map<CGSSpaceID, ax_space> Spaces;
+    ax_space_topology Topology;
+};
+
+/* NOTE: Lookup tables that point into the map of displays, see AXLibBuildDisplayIndex. Generation
+         is bumped on every rebuild, SpaceGeneration is the space topology the table of spaces was
+         built for. Guarded by SpaceTopologyLock in display.mm. */
+struct ax_display_index
+{
+    uint32_t Generation;
+    uint32_t SpaceGeneration;
+    std::vector<ax_display *> Arrangement;
+    std::unordered_map<CGSSpaceID, ax_display *> Spaces;
 };
 
 inline bool
@@ -85,16 +130,30 @@ ax_display *AXLibArrangementDisplay(unsigned int ArrangementID);
 ax_space *AXLibGetActiveSpace(ax_display *Display);
 void AXLibSpaceTransition(ax_display *Display, CGSSpaceID SpaceID);
 
+void AXLibBeginSpaceTransition();
 bool AXLibIsSpaceTransitionInProgress();
 bool AXLibDisplayHasSeparateSpaces();
 
+void AXLibInvalidateSpaceTopology();
 unsigned int AXLibDisplaySpacesCount(ax_display *Display);
 unsigned int AXLibDesktopIDFromCGSSpaceID(ax_display *Display, CGSSpaceID SpaceID);
 CGSSpaceID AXLibCGSSpaceIDFromDesktopID(ax_display *Display, unsigned int DesktopID);
 
+void AXLibBuildDisplayIndex(ax_display_index *Index, std::map<CGDirectDisplayID, ax_display> *Displays,
+                            unsigned int DisplayCount, uint32_t SpaceGeneration);
+ax_display *AXLibIndexArrangementDisplay(ax_display_index *Index, unsigned int ArrangementID);
+ax_display *AXLibIndexSpaceDisplay(ax_display_index *Index, std::map<CGDirectDisplayID, ax_display> *Displays,
+                                   CGSSpaceID SpaceID, uint32_t SpaceGeneration);
+ax_display *AXLibIndexFrameDisplay(ax_display_index *Index, std::map<CGDirectDisplayID, ax_display> *Displays,
+                                   ax_window_display *Cache, CGRect Frame);
+
 bool AXLibStickyWindow(ax_window *Window);
 bool AXLibSpaceHasWindow(ax_window *Window, CGSSpaceID SpaceID);
 void AXLibSpaceAddWindow(CGSSpaceID SpaceID, uint32_t WindowID);
 void AXLibSpaceRemoveWindow(CGSSpaceID SpaceID, uint32_t WindowID);
 
+ax_window_spaces AXLibSpacesForWindows(CGSSpaceID SpaceID, std::vector<ax_window *> *Windows);
+bool AXLibWindowSpacesHasWindow(ax_window_spaces *WindowSpaces, uint32_t WindowID);
+bool AXLibWindowSpacesSticky(ax_window_spaces *WindowSpaces, uint32_t WindowID);
+
 #endif
@@ -4,6 +4,9 @@
 #include "element.h"
 #include <Cocoa/Cocoa.h>
 #include <stdio.h>
+#include <algorithm>
+#include <unordered_map>
+#include <atomic>
 
 #define internal static
 #define CGSDefaultConnection _CGSDefaultConnection()
@@ -13,6 +16,7 @@ extern "C" CGSConnectionID _CGSDefaultConnection(void);
 extern "C" CGSSpaceType CGSSpaceGetType(CGSConnectionID CID, CGSSpaceID SID);
 extern "C" CFArrayRef CGSCopyManagedDisplaySpaces(const CGSConnectionID CID);
 extern "C" CFArrayRef CGSCopySpacesForWindows(CGSConnectionID CID, CGSSpaceSelector Type, CFArrayRef Windows);
+extern "C" CFArrayRef CGSCopyWindowsWithOptionsAndTags(CGSConnectionID CID, uint32_t Owner, CFArrayRef Spaces, uint32_t Options, uint64_t *SetTags, uint64_t *ClearTags);
 extern "C" bool CGSManagedDisplayIsAnimating(CGSConnectionID CID, CFStringRef DisplayIdentifier);
 
 extern "C" void CGSHideSpaces(CGSConnectionID CID, CFArrayRef Spaces);
@@ -26,6 +30,12 @@ extern "C" void CGSAddWindowsToSpaces(CGSConnectionID CID, CFArrayRef Windows, C
 internal std::map<CGDirectDisplayID, ax_display> *Displays;
 internal unsigned int MaxDisplayCount = 5;
 internal unsigned int ActiveDisplayCount = 0;
+internal std::map<std::string, uint32_t> SpaceHandles;
+internal ax_display_index DisplayIndex = { 1 };
+internal std::atomic<bool> SpaceTransitionActive(false);
+internal std::atomic<uint64_t> SpaceTransitionNextPoll(0);
+internal pthread_mutex_t SpaceTopologyLock = PTHREAD_MUTEX_INITIALIZER;
+internal uint32_t SpaceTopologyGeneration = 1;
 
 /* NOTE(koekeishiya): If the display UUID is stored, return the corresponding
                       CGDirectDisplayID. Otherwise we return 0 */
@@ -131,6 +141,19 @@ AXLibGetActiveSpaceID(ax_display *Display)
     return ActiveSpace;
 }
 
+/* NOTE: This is the only place a space identifier is turned into a handle. */
+internal uint32_t
+AXLibSpaceHandle(std::string Identifier)
+{
+    std::map<std::string, uint32_t>::iterator It = SpaceHandles.find(Identifier);
+    if(It != SpaceHandles.end())
+        return It->second;
+
+    uint32_t Handle = SpaceHandles.size();
+    SpaceHandles[Identifier] = Handle;
+    return Handle;
+}
+
 internal ax_space
 AXLibConstructSpace(CFStringRef Identifier, CGSSpaceID SpaceID, CGSSpaceType SpaceType)
 {
@@ -146,6 +169,7 @@ AXLibConstructSpace(CFStringRef Identifier, CGSSpaceID SpaceID, CGSSpaceType Spa
         free(IdentifierC);
     }
 
+    Space.Handle = AXLibSpaceHandle(Space.Identifier);
     Space.ID = SpaceID;
     Space.Type = SpaceType;
 
@@ -161,6 +185,7 @@ ax_space *AXLibGetActiveSpace(ax_display *Display)
                           AXLib was initialized. Create ax_space struct and add to the displays space list. */
     if(!AXLibDisplayHasSpace(Display, SpaceID))
     {
+        AXLibInvalidateSpaceTopology();
         CFStringRef SpaceUUID = AXLibGetActiveSpaceIdentifier(Display);
         CGSSpaceType SpaceType = CGSSpaceGetType(CGSDefaultConnection, SpaceID);
         Display->Spaces[SpaceID] = AXLibConstructSpace(SpaceUUID, SpaceID, SpaceType);
@@ -213,6 +238,7 @@ AXLibChangeDisplayID(CGDirectDisplayID OldDisplayID, CGDirectDisplayID NewDispla
     ax_display *Display = &(*Displays)[NewDisplayID];
     Display->ID = NewDisplayID;
     Display->Spaces.clear();
+    AXLibInvalidateSpaceTopology();
     AXLibConstructSpacesForDisplay(Display);
     Display->Space = AXLibGetActiveSpace(Display);
     Display->PrevSpace = Display->Space;
@@ -243,10 +269,23 @@ AXLibRefreshDisplay(ax_display *Display, CGDirectDisplayID DisplayID, unsigned i
     Display->Frame = CGDisplayBounds(DisplayID);
 }
 
+/* NOTE: Rebuild the lookup tables that point into the map of displays. Must be called
+         whenever a display is added, removed or rearranged, as this also invalidates
+         the display cached by every window. */
+internal void
+AXLibIndexDisplays()
+{
+    pthread_mutex_lock(&SpaceTopologyLock);
+    AXLibBuildDisplayIndex(&DisplayIndex, Displays, ActiveDisplayCount, SpaceTopologyGeneration);
+    pthread_mutex_unlock(&SpaceTopologyLock);
+}
+
 /* NOTE(koekeishiya): Repopulate map with information about all connected displays. */
 internal void
 AXLibRefreshDisplays()
 {
+    AXLibInvalidateSpaceTopology();
+
     CGDirectDisplayID *CGDirectDisplayList = (CGDirectDisplayID *) malloc(sizeof(CGDirectDisplayID) * MaxDisplayCount);
     CGGetActiveDisplayList(MaxDisplayCount, CGDirectDisplayList, &ActiveDisplayCount);
 
@@ -264,6 +303,7 @@ AXLibRefreshDisplays()
     }
 
     free(CGDirectDisplayList);
+    AXLibIndexDisplays();
 }
 
 internal inline void
@@ -454,6 +494,7 @@ AXLibActiveDisplays()
     }
 
     free(CGDirectDisplayList);
+    AXLibIndexDisplays();
     CGDisplayRegisterReconfigurationCallback(AXDisplayReconfigurationCallBack, NULL);
 }
 
@@ -491,173 +532,151 @@ ax_display *AXLibCursorDisplay()
     return Result;
 }
 
-/* NOTE(koekeishiya): The display that holds the largest portion of the given window. */
+/* NOTE(koekeishiya): The display that holds the largest portion of the given window. The result is
+                      cached on the window, as this is called several times for the same window
+                      while handling a single event. */
 ax_display *AXLibWindowDisplay(ax_window *Window)
 {
     CGRect Frame = { Window->Position, Window->Size };
-    CGFloat HighestVolume = 0;
-    ax_display *BestDisplay = NULL;
-
-    std::map<CGDirectDisplayID, ax_display>::iterator It;
-    for(It = Displays->begin(); It != Displays->end(); ++It)
-    {
-        ax_display *Display = &It->second;
-        CGRect Intersection = CGRectIntersection(Frame, Display->Frame);
-        CGFloat Volume = Intersection.size.width * Intersection.size.height;
-
-        if(Volume > HighestVolume)
-        {
-            HighestVolume = Volume;
-            BestDisplay = Display;
-        }
-    }
+    pthread_mutex_lock(&SpaceTopologyLock);
+    ax_display *Result = AXLibIndexFrameDisplay(&DisplayIndex, Displays, &Window->DisplayCache, Frame);
+    pthread_mutex_unlock(&SpaceTopologyLock);
 
-    return BestDisplay ? BestDisplay : AXLibMainDisplay();
+    /* NOTE: A window that is not on any display falls back to the main display, which
+             depends on focus and so is never cached. */
+    return Result ? Result : AXLibMainDisplay();
 }
 
-
 ax_display *AXLibNextDisplay(ax_display *Display)
 {
     unsigned int NextDisplayID = Display->ArrangementID + 1 >= ActiveDisplayCount ? 0 : Display->ArrangementID + 1;
-    std::map<CGDirectDisplayID, ax_display>::iterator DisplayIt;
-    for(DisplayIt = Displays->begin(); DisplayIt != Displays->end(); ++DisplayIt)
-    {
-        ax_display *CurrentDisplay = &DisplayIt->second;
-        if(CurrentDisplay->ArrangementID == NextDisplayID)
-            return CurrentDisplay;
-    }
-
-    return NULL;
+    return AXLibArrangementDisplay(NextDisplayID);
 }
 
 ax_display *AXLibPreviousDisplay(ax_display *Display)
 {
     unsigned int PrevDisplayID = Display->ArrangementID == 0 ? ActiveDisplayCount - 1 : Display->ArrangementID - 1;
-    std::map<CGDirectDisplayID, ax_display>::iterator DisplayIt;
-    for(DisplayIt = Displays->begin(); DisplayIt != Displays->end(); ++DisplayIt)
-    {
-        ax_display *CurrentDisplay = &DisplayIt->second;
-        if(CurrentDisplay->ArrangementID == PrevDisplayID)
-            return CurrentDisplay;
-    }
-
-    return NULL;
+    return AXLibArrangementDisplay(PrevDisplayID);
 }
 
 ax_display *AXLibArrangementDisplay(unsigned int ArrangementID)
 {
-    std::map<CGDirectDisplayID, ax_display>::iterator DisplayIt;
-    for(DisplayIt = Displays->begin(); DisplayIt != Displays->end(); ++DisplayIt)
-    {
-        ax_display *Display = &DisplayIt->second;
-        if(Display->ArrangementID == ArrangementID)
-            return Display;
-    }
+    pthread_mutex_lock(&SpaceTopologyLock);
+    ax_display *Result = AXLibIndexArrangementDisplay(&DisplayIndex, ArrangementID);
+    pthread_mutex_unlock(&SpaceTopologyLock);
 
-    return NULL;
+    return Result;
 }
 
-unsigned int AXLibDesktopIDFromCGSSpaceID(ax_display *Display, CGSSpaceID SpaceID)
+/* NOTE: Must be thread-safe! Called when spaces or displays may have been added, removed or
+         reordered. The topology of every display is rebuilt on its next lookup. */
+void AXLibInvalidateSpaceTopology()
 {
-    unsigned int Result = 0;
-    NSString *CurrentIdentifier = (__bridge NSString *)Display->Identifier;
+    pthread_mutex_lock(&SpaceTopologyLock);
+    ++SpaceTopologyGeneration;
+    pthread_mutex_unlock(&SpaceTopologyLock);
+}
 
+/* NOTE: Must be called with SpaceTopologyLock held. */
+internal void
+AXLibBuildSpaceTopology(ax_display *Display)
+{
+    ax_space_topology *Topology = &Display->Topology;
+    Topology->Generation = SpaceTopologyGeneration;
+    Topology->SpaceIDs.clear();
+    Topology->DesktopIDs.clear();
+
+    NSString *CurrentIdentifier = (__bridge NSString *)Display->Identifier;
     CFArrayRef ScreenDictionaries = CGSCopyManagedDisplaySpaces(CGSDefaultConnection);
     for(NSDictionary *ScreenDictionary in (__bridge NSArray *)ScreenDictionaries)
     {
-        int SpaceIndex = 1;
         NSString *ScreenIdentifier = ScreenDictionary[@"Display Identifier"];
         if([ScreenIdentifier isEqualToString:CurrentIdentifier])
         {
             NSArray *SpaceDictionaries = ScreenDictionary[@"Spaces"];
             for(NSDictionary *SpaceDictionary in (__bridge NSArray *)SpaceDictionaries)
             {
-                if(SpaceID == [SpaceDictionary[@"id64"] intValue])
-                {
-                    Result = SpaceIndex;
-                    break;
-                }
-
-                ++SpaceIndex;
+                CGSSpaceID SpaceID = [SpaceDictionary[@"id64"] intValue];
+                Topology->SpaceIDs.push_back(SpaceID);
+                Topology->DesktopIDs[SpaceID] = Topology->SpaceIDs.size();
             }
             break;
         }
     }
 
     CFRelease(ScreenDictionaries);
+}
+
+/* NOTE: Must be called with SpaceTopologyLock held. A lookup that misses forces a rebuild,
+         so that a space created since the last invalidation is still found. */
+internal ax_space_topology *
+AXLibSpaceTopology(ax_display *Display, bool Missed)
+{
+    if((Missed) || (Display->Topology.Generation != SpaceTopologyGeneration))
+        AXLibBuildSpaceTopology(Display);
+
+    return &Display->Topology;
+}
+
+unsigned int AXLibDesktopIDFromCGSSpaceID(ax_display *Display, CGSSpaceID SpaceID)
+{
+    unsigned int Result = 0;
+
+    pthread_mutex_lock(&SpaceTopologyLock);
+    ax_space_topology *Topology = AXLibSpaceTopology(Display, false);
+    std::map<CGSSpaceID, unsigned int>::iterator It = Topology->DesktopIDs.find(SpaceID);
+    if(It == Topology->DesktopIDs.end())
+    {
+        Topology = AXLibSpaceTopology(Display, true);
+        It = Topology->DesktopIDs.find(SpaceID);
+    }
+
+    if(It != Topology->DesktopIDs.end())
+        Result = It->second;
+    pthread_mutex_unlock(&SpaceTopologyLock);
+
     return Result;
 }
 
 CGSSpaceID AXLibCGSSpaceIDFromDesktopID(ax_display *Display, unsigned int DesktopID)
 {
     CGSSpaceID Result = 0;
-    NSString *CurrentIdentifier = (__bridge NSString *)Display->Identifier;
 
-    CFArrayRef ScreenDictionaries = CGSCopyManagedDisplaySpaces(CGSDefaultConnection);
-    for(NSDictionary *ScreenDictionary in (__bridge NSArray *)ScreenDictionaries)
-    {
-        int SpaceIndex = 1;
-        NSString *ScreenIdentifier = ScreenDictionary[@"Display Identifier"];
-        if([ScreenIdentifier isEqualToString:CurrentIdentifier])
-        {
-            NSArray *SpaceDictionaries = ScreenDictionary[@"Spaces"];
-            for(NSDictionary *SpaceDictionary in (__bridge NSArray *)SpaceDictionaries)
-            {
-                if(SpaceIndex == DesktopID)
-                {
-                    Result = [SpaceDictionary[@"id64"] intValue];
-                    break;
-                }
-                ++SpaceIndex;
-            }
-            break;
-        }
-    }
+    pthread_mutex_lock(&SpaceTopologyLock);
+    ax_space_topology *Topology = AXLibSpaceTopology(Display, false);
+    if((DesktopID > 0) && (DesktopID > Topology->SpaceIDs.size()))
+        Topology = AXLibSpaceTopology(Display, true);
+
+    if((DesktopID > 0) && (DesktopID <= Topology->SpaceIDs.size()))
+        Result = Topology->SpaceIDs[DesktopID - 1];
+    pthread_mutex_unlock(&SpaceTopologyLock);
 
-    CFRelease(ScreenDictionaries);
     return Result;
 }
 
 unsigned int AXLibDisplaySpacesCount(ax_display *Display)
 {
-    unsigned int Result = 0;
-    NSString *CurrentIdentifier = (__bridge NSString *)Display->Identifier;
+    pthread_mutex_lock(&SpaceTopologyLock);
+    unsigned int Result = AXLibSpaceTopology(Display, false)->SpaceIDs.size();
+    pthread_mutex_unlock(&SpaceTopologyLock);
 
-    CFArrayRef ScreenDictionaries = CGSCopyManagedDisplaySpaces(CGSDefaultConnection);
-    for(NSDictionary *ScreenDictionary in (__bridge NSArray *)ScreenDictionaries)
-    {
-        NSString *ScreenIdentifier = ScreenDictionary[@"Display Identifier"];
-        if ([ScreenIdentifier isEqualToString:CurrentIdentifier])
-        {
-            NSArray *Spaces = ScreenDictionary[@"Spaces"];
-            Result = CFArrayGetCount((__bridge CFArrayRef)Spaces);
-        }
-    }
-
-    CFRelease(ScreenDictionaries);
     return Result;
 }
 
-/* NOTE(koekeishiya): Given an abitrary CGSSpaceID, return the ax_display it belongs to. */
+/* NOTE(koekeishiya): Given an abitrary CGSSpaceID, return the ax_display it belongs to. The table is
+                      shared with AXLibIndexDisplays, and re-indexed after the space topology has
+                      been invalidated. */
 ax_display * AXLibSpaceDisplay(CGSSpaceID SpaceID)
 {
-    ax_display *Result = NULL;
-
-    std::map<CGDirectDisplayID, ax_display>::iterator It;
-    for(It = Displays->begin(); It != Displays->end(); ++It)
-    {
-        ax_display *Display = &It->second;
-        if(Display->Spaces.find(SpaceID) != Display->Spaces.end())
-        {
-            Result = Display;
-            break;
-        }
-    }
+    pthread_mutex_lock(&SpaceTopologyLock);
+    ax_display *Result = AXLibIndexSpaceDisplay(&DisplayIndex, Displays, SpaceID, SpaceTopologyGeneration);
+    pthread_mutex_unlock(&SpaceTopologyLock);
 
     return Result;
 }
 
-bool AXLibIsSpaceTransitionInProgress()
+internal bool
+AXLibPollSpaceTransition()
 {
     bool Result = false;
 
@@ -671,11 +690,36 @@ bool AXLibIsSpaceTransitionInProgress()
     return Result;
 }
 
+/* NOTE: Must be thread-safe! The transition is considered in progress for at least one
+         poll interval, after which the window-server decides when it has completed. */
+void AXLibBeginSpaceTransition()
+{
+    SpaceTransitionActive.store(true, std::memory_order_relaxed);
+    SpaceTransitionNextPoll.store(AXLibCurrentTime() + AX_SPACE_TRANSITION_POLL, std::memory_order_relaxed);
+}
+
+/* NOTE: Must be thread-safe! Only asks the window-server once the poll interval of the
+         current state has passed, the answer is cached in between. */
+bool AXLibIsSpaceTransitionInProgress()
+{
+    uint64_t Now = AXLibCurrentTime();
+    bool Result = SpaceTransitionActive.load(std::memory_order_relaxed);
+    if(Now < SpaceTransitionNextPoll.load(std::memory_order_relaxed))
+        return Result;
+
+    Result = AXLibPollSpaceTransition();
+    SpaceTransitionActive.store(Result, std::memory_order_relaxed);
+    SpaceTransitionNextPoll.store(Now + (Result ? AX_SPACE_TRANSITION_POLL : AX_SPACE_TRANSITION_IDLE_POLL),
+                                  std::memory_order_relaxed);
+    return Result;
+}
+
 /* NOTE(koekeishiya): Performs a space transition without the animation. */
 void AXLibSpaceTransition(ax_display *Display, CGSSpaceID SpaceID)
 {
     NSArray *NSArraySourceSpace = @[ @(Display->Space->ID) ];
     NSArray *NSArrayDestinationSpace = @[ @(SpaceID) ];
+    AXLibBeginSpaceTransition();
     CGSManagedDisplaySetIsAnimating(CGSDefaultConnection, Display->Identifier, true);
 
     CGSShowSpaces(CGSDefaultConnection, (__bridge CFArrayRef)NSArrayDestinationSpace);
@@ -705,6 +749,89 @@ void AXLibSpaceRemoveWindow(CGSSpaceID SpaceID, uint32_t WindowID)
     [NSArraySourceSpace release];
 }
 
+/* NOTE: Adds the windows of Filter that are on any of the given spaces to Result, in a single
+         window-server request. */
+internal void
+AXLibWindowsOnSpaces(std::vector<CGSSpaceID> *SpaceIDs, std::set<uint32_t> *Filter, std::set<uint32_t> *Result)
+{
+    std::vector<CFNumberRef> Numbers;
+    for(std::size_t Index = 0; Index < SpaceIDs->size(); ++Index)
+        Numbers.push_back(CFNumberCreate(NULL, kCFNumberIntType, &(*SpaceIDs)[Index]));
+
+    CFArrayRef Spaces = CFArrayCreate(NULL, (const void **) Numbers.data(), Numbers.size(), &kCFTypeArrayCallBacks);
+    for(std::size_t Index = 0; Index < Numbers.size(); ++Index)
+        CFRelease(Numbers[Index]);
+
+    uint64_t SetTags = 0, ClearTags = 0;
+    CFArrayRef SpaceWindows = CGSCopyWindowsWithOptionsAndTags(CGSDefaultConnection, 0, Spaces, 0x2, &SetTags, &ClearTags);
+    CFRelease(Spaces);
+    if(!SpaceWindows)
+        return;
+
+    int NumberOfWindows = CFArrayGetCount(SpaceWindows);
+    for(int Index = 0; Index < NumberOfWindows; ++Index)
+    {
+        NSNumber *ID = (__bridge NSNumber *)CFArrayGetValueAtIndex(SpaceWindows, Index);
+        uint32_t WindowID = [ID unsignedIntValue];
+        if(Filter->find(WindowID) != Filter->end())
+            Result->insert(WindowID);
+    }
+
+    CFRelease(SpaceWindows);
+}
+
+/* NOTE: Resolves the space membership of a whole set of windows with two requests, regardless of
+         the number of windows or spaces. CGSCopySpacesForWindows returns the union of spaces for
+         all windows passed to it, so it can only answer for one window at a time. Instead we ask
+         for the windows on SpaceID, and then for the windows on every other space of every
+         display. A window that is on both is on more than one space, which is what
+         AXLibStickyWindow asks through kCGSSpaceAll. */
+ax_window_spaces AXLibSpacesForWindows(CGSSpaceID SpaceID, std::vector<ax_window *> *Windows)
+{
+    ax_window_spaces Result;
+    Result.SpaceID = SpaceID;
+    if(Windows->empty())
+        return Result;
+
+    std::set<uint32_t> Requested;
+    for(std::size_t Index = 0; Index < Windows->size(); ++Index)
+        Requested.insert((*Windows)[Index]->ID);
+
+    std::vector<CGSSpaceID> SpaceIDs(1, SpaceID);
+    AXLibWindowsOnSpaces(&SpaceIDs, &Requested, &Result.Windows);
+    if(Result.Windows.empty())
+        return Result;
+
+    SpaceIDs.clear();
+    pthread_mutex_lock(&SpaceTopologyLock);
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays->begin(); It != Displays->end(); ++It)
+    {
+        ax_space_topology *Topology = AXLibSpaceTopology(&It->second, false);
+        for(std::size_t Index = 0; Index < Topology->SpaceIDs.size(); ++Index)
+        {
+            if(Topology->SpaceIDs[Index] != SpaceID)
+                SpaceIDs.push_back(Topology->SpaceIDs[Index]);
+        }
+    }
+    pthread_mutex_unlock(&SpaceTopologyLock);
+
+    if(!SpaceIDs.empty())
+        AXLibWindowsOnSpaces(&SpaceIDs, &Result.Windows, &Result.Sticky);
+
+    return Result;
+}
+
+bool AXLibWindowSpacesHasWindow(ax_window_spaces *WindowSpaces, uint32_t WindowID)
+{
+    return WindowSpaces->Windows.find(WindowID) != WindowSpaces->Windows.end();
+}
+
+bool AXLibWindowSpacesSticky(ax_window_spaces *WindowSpaces, uint32_t WindowID)
+{
+    return WindowSpaces->Sticky.find(WindowID) != WindowSpaces->Sticky.end();
+}
+
 bool AXLibSpaceHasWindow(ax_window *Window, CGSSpaceID SpaceID)
 {
     bool Result = false;
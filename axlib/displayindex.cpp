@@ -0,0 +1,106 @@
+#include "display.h"
+#include "window.h"
+
+#define internal static
+
+internal void
+AXLibIndexDisplaySpaces(ax_display_index *Index, std::map<CGDirectDisplayID, ax_display> *Displays, uint32_t SpaceGeneration)
+{
+    Index->Spaces.clear();
+    Index->SpaceGeneration = SpaceGeneration;
+
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays->begin(); It != Displays->end(); ++It)
+    {
+        ax_display *Display = &It->second;
+        std::map<CGSSpaceID, ax_space>::iterator SpaceIt;
+        for(SpaceIt = Display->Spaces.begin(); SpaceIt != Display->Spaces.end(); ++SpaceIt)
+            Index->Spaces[SpaceIt->first] = Display;
+    }
+}
+
+/* NOTE: Must be called whenever a display is added, removed or rearranged. Bumping Generation also
+         invalidates the display cached by every window. */
+void AXLibBuildDisplayIndex(ax_display_index *Index, std::map<CGDirectDisplayID, ax_display> *Displays,
+                            unsigned int DisplayCount, uint32_t SpaceGeneration)
+{
+    ++Index->Generation;
+    Index->Arrangement.assign(DisplayCount, NULL);
+
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays->begin(); It != Displays->end(); ++It)
+    {
+        ax_display *Display = &It->second;
+        if(Display->ArrangementID < Index->Arrangement.size())
+            Index->Arrangement[Display->ArrangementID] = Display;
+    }
+
+    AXLibIndexDisplaySpaces(Index, Displays, SpaceGeneration);
+}
+
+ax_display *AXLibIndexArrangementDisplay(ax_display_index *Index, unsigned int ArrangementID)
+{
+    return ArrangementID < Index->Arrangement.size() ? Index->Arrangement[ArrangementID] : NULL;
+}
+
+/* NOTE: The table is rebuilt when the space topology has changed since it was built. A space that is
+         still missing was created since, and is looked up the slow way once. */
+ax_display *AXLibIndexSpaceDisplay(ax_display_index *Index, std::map<CGDirectDisplayID, ax_display> *Displays,
+                                   CGSSpaceID SpaceID, uint32_t SpaceGeneration)
+{
+    if(Index->SpaceGeneration != SpaceGeneration)
+        AXLibIndexDisplaySpaces(Index, Displays, SpaceGeneration);
+
+    std::unordered_map<CGSSpaceID, ax_display *>::iterator Cached = Index->Spaces.find(SpaceID);
+    if(Cached != Index->Spaces.end())
+        return Cached->second;
+
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays->begin(); It != Displays->end(); ++It)
+    {
+        ax_display *Display = &It->second;
+        if(Display->Spaces.find(SpaceID) != Display->Spaces.end())
+        {
+            Index->Spaces[SpaceID] = Display;
+            return Display;
+        }
+    }
+
+    return NULL;
+}
+
+/* NOTE: The display that holds the largest portion of the given frame, or NULL if the frame is not on
+         any display. The result is cached, see ax_window_display. */
+ax_display *AXLibIndexFrameDisplay(ax_display_index *Index, std::map<CGDirectDisplayID, ax_display> *Displays,
+                                   ax_window_display *Cache, CGRect Frame)
+{
+    if((Cache->Generation == Index->Generation) &&
+       (CGRectEqualToRect(Cache->Frame, Frame)))
+        return Cache->Display;
+
+    CGFloat HighestVolume = 0;
+    ax_display *BestDisplay = NULL;
+
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays->begin(); It != Displays->end(); ++It)
+    {
+        ax_display *Display = &It->second;
+        CGRect Intersection = CGRectIntersection(Frame, Display->Frame);
+        CGFloat Volume = Intersection.size.width * Intersection.size.height;
+
+        if(Volume > HighestVolume)
+        {
+            HighestVolume = Volume;
+            BestDisplay = Display;
+        }
+    }
+
+    if(BestDisplay)
+    {
+        Cache->Display = BestDisplay;
+        Cache->Frame = Frame;
+        Cache->Generation = Index->Generation;
+    }
+
+    return BestDisplay;
+}
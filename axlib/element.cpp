@@ -133,17 +133,15 @@ uint32_t AXLibGetWindowID(AXUIElementRef WindowRef)
     return WindowID;
 }
 
-char *AXLibGetWindowTitle(AXUIElementRef WindowRef)
+/* NOTE: The caller owns a reference to the returned string. */
+ax_string *AXLibGetWindowTitle(AXUIElementRef WindowRef)
 {
     CFStringRef WindowTitleRef = (CFStringRef) AXLibGetWindowProperty(WindowRef, kAXTitleAttribute);
-    char *WindowTitle = NULL;
+    ax_string *WindowTitle = NULL;
 
     if(WindowTitleRef)
     {
-        WindowTitle = CopyCFStringToC(WindowTitleRef, true);
-        if(!WindowTitle)
-            WindowTitle = CopyCFStringToC(WindowTitleRef, false);
-
+        WindowTitle = AXLibInternCFString(WindowTitleRef);
         CFRelease(WindowTitleRef);
     }
 
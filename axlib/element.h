@@ -2,6 +2,7 @@
 #define AXLIB_ELEMENT_H
 
 #include <Carbon/Carbon.h>
+#include "intern.h"
 
 #define kAXFullscreenAttribute CFSTR("AXFullScreen")
 
@@ -19,7 +20,7 @@ bool AXLibSetWindowSize(AXUIElementRef WindowRef, int Width, int Height);
 CFTypeRef AXLibGetWindowProperty(AXUIElementRef WindowRef, CFStringRef Property);
 AXError AXLibSetWindowProperty(AXUIElementRef WindowRef, CFStringRef Property, CFTypeRef Value);
 
-char *AXLibGetWindowTitle(AXUIElementRef WindowRef);
+ax_string *AXLibGetWindowTitle(AXUIElementRef WindowRef);
 CGPoint AXLibGetWindowPosition(AXUIElementRef WindowRef);
 CGSize AXLibGetWindowSize(AXUIElementRef WindowRef);
 
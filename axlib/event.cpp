@@ -1,12 +1,64 @@
 #include "event.h"
 #include "display.h"
 
+#include <mach/mach_time.h>
+
 #ifdef DEBUG_BUILD
 #include <stdio.h>
 #endif
 
 #define internal static
 internal ax_event_loop EventLoop = {};
+internal mach_timebase_info_data_t EventTimebase;
+
+/* NOTE: Number of events a lane may dispatch per round. */
+internal const uint32_t EventLaneWeights[AXEventLane_Count] = { 8, 4, 1 };
+
+/* NOTE: Monotonic time in nanoseconds. */
+uint64_t AXLibCurrentTime()
+{
+    if(EventTimebase.denom == 0)
+        mach_timebase_info(&EventTimebase);
+
+    return mach_absolute_time() * EventTimebase.numer / EventTimebase.denom;
+}
+
+/* NOTE: User input is interactive. Events that change the set of applications, windows,
+         displays or spaces are lifecycle events. Everything else is mostly an echo of
+         geometry changes we made ourselves, and goes to the background lane. */
+ax_event_lane AXLibEventLane(ax_event_type Type)
+{
+    switch(Type)
+    {
+        case AXEvent_LeftMouseDragged:
+        case AXEvent_LeftMouseDown:
+        case AXEvent_LeftMouseUp:
+        case AXEvent_RightMouseDragged:
+        case AXEvent_RightMouseDown:
+        case AXEvent_RightMouseUp:
+        case AXEvent_MouseDragCommit:
+            return AXEventLane_Interactive;
+
+        case AXEvent_ApplicationLaunched:
+        case AXEvent_ApplicationTerminated:
+        case AXEvent_ApplicationActivated:
+        case AXEvent_ApplicationVisible:
+        case AXEvent_ApplicationHidden:
+        case AXEvent_WindowCreated:
+        case AXEvent_WindowDestroyed:
+        case AXEvent_WindowFocused:
+        case AXEvent_WindowMinimized:
+        case AXEvent_WindowDeminimized:
+        case AXEvent_DisplayAdded:
+        case AXEvent_DisplayRemoved:
+        case AXEvent_DisplayChanged:
+        case AXEvent_SpaceChanged:
+            return AXEventLane_Lifecycle;
+
+        default:
+            return AXEventLane_Background;
+    }
+}
 
 /* NOTE(koekeishiya): Must be thread-safe! Called through AXLibConstructEvent macro */
 void AXLibAddEvent(ax_event Event)
@@ -14,13 +66,82 @@ void AXLibAddEvent(ax_event Event)
     if(EventLoop.Running && Event.Handle)
     {
         pthread_mutex_lock(&EventLoop.WorkerLock);
-        EventLoop.Queue.push(Event);
+        Event.Timestamp = AXLibCurrentTime();
+        std::queue<ax_event> *Queue = &EventLoop.Queue[Event.Lane];
+        Queue->push(Event);
+
+        ax_event_lane_stats *Stats = &EventLoop.Stats[Event.Lane];
+        if(Queue->size() > Stats->MaxDepth)
+            Stats->MaxDepth = Queue->size();
 
         pthread_cond_signal(&EventLoop.State);
         pthread_mutex_unlock(&EventLoop.WorkerLock);
     }
 }
 
+/* NOTE: The callback runs on the event-loop thread every time the queue has been
+         emptied, i.e. once per batch of events rather than once per event. */
+void AXLibSetEventQueueDrainedCallback(EventQueueDrainedCallback *Callback)
+{
+    EventLoop.Drained = Callback;
+}
+
+/* NOTE: Must be thread-safe! Copies the stats of every lane into Stats,
+         which must have room for AXEventLane_Count entries. */
+void AXLibEventLoopStats(ax_event_lane_stats *Stats)
+{
+    pthread_mutex_lock(&EventLoop.WorkerLock);
+    for(int Lane = 0; Lane < AXEventLane_Count; ++Lane)
+    {
+        Stats[Lane] = EventLoop.Stats[Lane];
+        Stats[Lane].Depth = EventLoop.Queue[Lane].size();
+    }
+    pthread_mutex_unlock(&EventLoop.WorkerLock);
+}
+
+internal bool
+AXLibEventQueueIsEmpty()
+{
+    for(int Lane = 0; Lane < AXEventLane_Count; ++Lane)
+    {
+        if(!EventLoop.Queue[Lane].empty())
+            return false;
+    }
+
+    return true;
+}
+
+/* NOTE: Picks the highest priority lane that has pending events and credits left.
+         When no such lane exists, every lane gets its credits back and a new round
+         starts. Must hold WorkerLock, and at least one lane must be non-empty. */
+internal ax_event_lane
+AXLibSelectEventLane()
+{
+    while(true)
+    {
+        for(int Lane = 0; Lane < AXEventLane_Count; ++Lane)
+        {
+            if(!EventLoop.Queue[Lane].empty() && EventLoop.Credits[Lane] > 0)
+            {
+                --EventLoop.Credits[Lane];
+                return (ax_event_lane) Lane;
+            }
+        }
+
+        for(int Lane = 0; Lane < AXEventLane_Count; ++Lane)
+            EventLoop.Credits[Lane] = EventLaneWeights[Lane];
+    }
+}
+
+/* NOTE: Parks the event-loop for one poll interval while a space transition is in
+         progress. New events wake it up early. Must hold StateLock. */
+internal void
+AXLibWaitForSpaceTransition()
+{
+    struct timespec Timeout = { 0, (long) AX_SPACE_TRANSITION_POLL };
+    pthread_cond_timedwait_relative_np(&EventLoop.State, &EventLoop.StateLock, &Timeout);
+}
+
 /* NOTE(koekeishiya): Uses dynamic dispatch to process events of any type. */
 internal void *
 AXLibProcessEventQueue(void *)
@@ -28,20 +149,46 @@ AXLibProcessEventQueue(void *)
     while(EventLoop.Running)
     {
         pthread_mutex_lock(&EventLoop.StateLock);
-        while(!EventLoop.Queue.empty())
+        bool Processed = false;
+        while(!AXLibEventQueueIsEmpty())
         {
-            if(!AXLibIsSpaceTransitionInProgress())
+            if(AXLibIsSpaceTransitionInProgress())
             {
-                pthread_mutex_lock(&EventLoop.WorkerLock);
-                ax_event Event = EventLoop.Queue.front();
-                EventLoop.Queue.pop();
-                pthread_mutex_unlock(&EventLoop.WorkerLock);
-
-                (*Event.Handle)(&Event);
+                AXLibWaitForSpaceTransition();
+                continue;
             }
+
+            pthread_mutex_lock(&EventLoop.WorkerLock);
+            ax_event_lane Lane = AXLibSelectEventLane();
+            ax_event Event = EventLoop.Queue[Lane].front();
+            EventLoop.Queue[Lane].pop();
+
+            uint64_t Wait = AXLibCurrentTime() - Event.Timestamp;
+            ax_event_lane_stats *Stats = &EventLoop.Stats[Lane];
+            ++Stats->Dispatched;
+            Stats->TotalWait += Wait;
+            if(Wait > Stats->MaxWait)
+                Stats->MaxWait = Wait;
+            pthread_mutex_unlock(&EventLoop.WorkerLock);
+
+            (*Event.Handle)(&Event);
+            Processed = true;
+        }
+
+        pthread_mutex_unlock(&EventLoop.StateLock);
+
+        /* NOTE: The drained callback runs outside StateLock, so it is not part of the dispatch
+                 critical section. It still reads display state, which AXLibPauseEventLoop
+                 excludes through DrainLock. */
+        if(Processed && EventLoop.Drained)
+        {
+            pthread_mutex_lock(&EventLoop.DrainLock);
+            (*EventLoop.Drained)();
+            pthread_mutex_unlock(&EventLoop.DrainLock);
         }
 
-        while(EventLoop.Queue.empty() && EventLoop.Running)
+        pthread_mutex_lock(&EventLoop.StateLock);
+        while(AXLibEventQueueIsEmpty() && EventLoop.Running)
             pthread_cond_wait(&EventLoop.State, &EventLoop.StateLock);
 
         pthread_mutex_unlock(&EventLoop.StateLock);
@@ -65,10 +212,18 @@ AXLibInitializeEventLoop()
        return false;
    }
 
+   if(pthread_mutex_init(&EventLoop.DrainLock, NULL) != 0)
+   {
+       pthread_mutex_destroy(&EventLoop.WorkerLock);
+       pthread_mutex_destroy(&EventLoop.StateLock);
+       return false;
+   }
+
    if(pthread_cond_init(&EventLoop.State, NULL) != 0)
    {
         pthread_mutex_destroy(&EventLoop.WorkerLock);
         pthread_mutex_destroy(&EventLoop.StateLock);
+        pthread_mutex_destroy(&EventLoop.DrainLock);
         return false;
    }
 
@@ -80,6 +235,7 @@ internal void
 AXLibTerminateEventLoop()
 {
     pthread_cond_destroy(&EventLoop.State);
+    pthread_mutex_destroy(&EventLoop.DrainLock);
     pthread_mutex_destroy(&EventLoop.StateLock);
     pthread_mutex_destroy(&EventLoop.WorkerLock);
 }
@@ -89,6 +245,7 @@ void AXLibPauseEventLoop()
     if(EventLoop.Running)
     {
         pthread_mutex_lock(&EventLoop.StateLock);
+        pthread_mutex_lock(&EventLoop.DrainLock);
 #ifdef DEBUG_BUILD
         printf("EventLoop: PAUSE\n");
 #endif
@@ -102,6 +259,7 @@ void AXLibResumeEventLoop()
 #ifdef DEBUG_BUILD
         printf("EventLoop: RESUME\n");
 #endif
+        pthread_mutex_unlock(&EventLoop.DrainLock);
         pthread_mutex_unlock(&EventLoop.StateLock);
     }
 }
@@ -2,6 +2,7 @@
 #define AXLIB_EVENT_H
 
 #include <pthread.h>
+#include <stdint.h>
 #include <queue>
 
 struct ax_event;
@@ -9,6 +10,9 @@ struct ax_event;
 #define EVENT_CALLBACK(name) void name(ax_event *Event)
 typedef EVENT_CALLBACK(EventCallback);
 
+#define EVENT_QUEUE_DRAINED_CALLBACK(name) void name()
+typedef EVENT_QUEUE_DRAINED_CALLBACK(EventQueueDrainedCallback);
+
 /* NOTE(koekeishiya): Declare ax_event_type callbacks as external functions.
  *                    These callbacks should be defined in user-code as necessary. */
 extern EVENT_CALLBACK(Callback_AXEvent_ApplicationLaunched);
@@ -25,6 +29,7 @@ extern EVENT_CALLBACK(Callback_AXEvent_WindowResized);
 extern EVENT_CALLBACK(Callback_AXEvent_WindowMinimized);
 extern EVENT_CALLBACK(Callback_AXEvent_WindowDeminimized);
 extern EVENT_CALLBACK(Callback_AXEvent_WindowTitleChanged);
+extern EVENT_CALLBACK(Callback_AXEvent_WindowFrameCorrected);
 
 extern EVENT_CALLBACK(Callback_AXEvent_DisplayAdded);
 extern EVENT_CALLBACK(Callback_AXEvent_DisplayRemoved);
@@ -41,6 +46,7 @@ extern EVENT_CALLBACK(Callback_AXEvent_LeftMouseUp);
 extern EVENT_CALLBACK(Callback_AXEvent_RightMouseDragged);
 extern EVENT_CALLBACK(Callback_AXEvent_RightMouseDown);
 extern EVENT_CALLBACK(Callback_AXEvent_RightMouseUp);
+extern EVENT_CALLBACK(Callback_AXEvent_MouseDragCommit);
 
 enum ax_event_type
 {
@@ -59,6 +65,7 @@ enum ax_event_type
     AXEvent_WindowMinimized,
     AXEvent_WindowDeminimized,
     AXEvent_WindowTitleChanged,
+    AXEvent_WindowFrameCorrected,
 
     AXEvent_DisplayAdded,
     AXEvent_DisplayRemoved,
@@ -75,6 +82,30 @@ enum ax_event_type
     AXEvent_RightMouseDragged,
     AXEvent_RightMouseDown,
     AXEvent_RightMouseUp,
+    AXEvent_MouseDragCommit,
+};
+
+/* NOTE: Events are dispatched from one queue per lane. Lanes are served in order of
+ *       priority, but every lane only gets a fixed number of events per round, so that
+ *       a busy lane can never starve the ones below it. */
+enum ax_event_lane
+{
+    AXEventLane_Interactive,
+    AXEventLane_Lifecycle,
+    AXEventLane_Background,
+
+    AXEventLane_Count
+};
+
+struct ax_event_lane_stats
+{
+    uint64_t Depth;
+    uint64_t MaxDepth;
+    uint64_t Dispatched;
+
+    /* NOTE: Time between AXLibAddEvent and dispatch, in nanoseconds. */
+    uint64_t TotalWait;
+    uint64_t MaxWait;
 };
 
 struct ax_event
@@ -82,16 +113,23 @@ struct ax_event
     EventCallback *Handle;
     bool Intrinsic;
     void *Context;
+
+    ax_event_lane Lane;
+    uint64_t Timestamp;
 };
 
 struct ax_event_loop
 {
     pthread_cond_t State;
     pthread_mutex_t StateLock;
+    pthread_mutex_t DrainLock;
     pthread_mutex_t WorkerLock;
     pthread_t Worker;
     bool Running;
-    std::queue<ax_event> Queue;
+    std::queue<ax_event> Queue[AXEventLane_Count];
+    uint32_t Credits[AXEventLane_Count];
+    ax_event_lane_stats Stats[AXEventLane_Count];
+    EventQueueDrainedCallback *Drained;
 };
 
 bool AXLibStartEventLoop();
@@ -101,6 +139,11 @@ void AXLibPauseEventLoop();
 void AXLibResumeEventLoop();
 
 void AXLibAddEvent(ax_event Event);
+void AXLibSetEventQueueDrainedCallback(EventQueueDrainedCallback *Callback);
+
+ax_event_lane AXLibEventLane(ax_event_type Type);
+void AXLibEventLoopStats(ax_event_lane_stats *Stats);
+uint64_t AXLibCurrentTime();
 
 /* NOTE(koekeishiya): Construct an ax_event with the appropriate callback through macro expansion. */
 #define AXLibConstructEvent(EventType, EventContext, EventIntrinsic) \
@@ -108,6 +151,7 @@ void AXLibAddEvent(ax_event Event);
          Event.Context = EventContext; \
          Event.Intrinsic = EventIntrinsic; \
          Event.Handle = &Callback_##EventType; \
+         Event.Lane = AXLibEventLane(EventType); \
          AXLibAddEvent(Event); \
        } while(0)
 
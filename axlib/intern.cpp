@@ -0,0 +1,204 @@
+#include "intern.h"
+#include "element.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define internal static
+
+/* NOTE: Chained hash table that grows when the number of strings exceeds the number of
+         buckets. A lookup of a string that already exists does not allocate. */
+struct ax_string_table
+{
+    ax_string **Buckets;
+    uint32_t Capacity;
+    uint32_t Count;
+    uint32_t NextID;
+};
+
+internal ax_string_table StringTable = { NULL, 0, 0, 1 };
+internal pthread_mutex_t StringTableLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* NOTE: 32-bit FNV-1a. */
+internal inline uint32_t
+AXLibHashString(const char *Text, size_t Length)
+{
+    uint32_t Hash = 2166136261u;
+    for(size_t Index = 0; Index < Length; ++Index)
+    {
+        Hash ^= (unsigned char) Text[Index];
+        Hash *= 16777619u;
+    }
+
+    return Hash;
+}
+
+/* NOTE: Must be called with StringTableLock held. */
+internal void
+AXLibGrowStringTable()
+{
+    uint32_t Capacity = StringTable.Capacity ? StringTable.Capacity * 2 : 256;
+    ax_string **Buckets = (ax_string **) calloc(Capacity, sizeof(ax_string *));
+
+    for(uint32_t Index = 0; Index < StringTable.Capacity; ++Index)
+    {
+        ax_string *String = StringTable.Buckets[Index];
+        while(String)
+        {
+            ax_string *Next = String->Next;
+            uint32_t Bucket = String->Hash & (Capacity - 1);
+            String->Next = Buckets[Bucket];
+            Buckets[Bucket] = String;
+            String = Next;
+        }
+    }
+
+    free(StringTable.Buckets);
+    StringTable.Buckets = Buckets;
+    StringTable.Capacity = Capacity;
+}
+
+/* NOTE: Must be called with StringTableLock held. */
+internal ax_string *
+AXLibLookupString(const char *Text, size_t Length, uint32_t Hash)
+{
+    if(!StringTable.Capacity)
+        return NULL;
+
+    ax_string *String = StringTable.Buckets[Hash & (StringTable.Capacity - 1)];
+    while(String)
+    {
+        if((String->Hash == Hash) &&
+           (String->Length == Length) &&
+           (memcmp(String->Text, Text, Length) == 0))
+            return String;
+
+        String = String->Next;
+    }
+
+    return NULL;
+}
+
+/* NOTE: Must be thread-safe! */
+ax_string *AXLibInternString(const char *Text, size_t Length)
+{
+    if(!Text)
+        return NULL;
+
+    uint32_t Hash = AXLibHashString(Text, Length);
+
+    pthread_mutex_lock(&StringTableLock);
+    ax_string *String = AXLibLookupString(Text, Length, Hash);
+    if(String)
+    {
+        ++String->References;
+    }
+    else
+    {
+        if(StringTable.Count >= StringTable.Capacity)
+            AXLibGrowStringTable();
+
+        String = (ax_string *) malloc(sizeof(ax_string) + Length + 1);
+        String->Text = (char *) (String + 1);
+        memcpy(String->Text, Text, Length);
+        String->Text[Length] = '\0';
+        String->Length = Length;
+        String->Hash = Hash;
+        String->ID = StringTable.NextID++;
+        String->References = 1;
+
+        uint32_t Bucket = Hash & (StringTable.Capacity - 1);
+        String->Next = StringTable.Buckets[Bucket];
+        StringTable.Buckets[Bucket] = String;
+        ++StringTable.Count;
+    }
+    pthread_mutex_unlock(&StringTableLock);
+
+    return String;
+}
+
+ax_string *AXLibInternString(const char *Text)
+{
+    return Text ? AXLibInternString(Text, strlen(Text)) : NULL;
+}
+
+/* NOTE: Short strings are converted on the stack, so that interning a title we have
+         already seen does not allocate. */
+ax_string *AXLibInternCFString(CFStringRef String)
+{
+    if(!String)
+        return NULL;
+
+    const char *Direct = CFStringGetCStringPtr(String, kCFStringEncodingUTF8);
+    if(Direct)
+        return AXLibInternString(Direct);
+
+    char Buffer[512];
+    if(CFStringGetCString(String, Buffer, sizeof(Buffer), kCFStringEncodingUTF8))
+        return AXLibInternString(Buffer);
+
+    ax_string *Result = NULL;
+    char *Copy = CopyCFStringToC(String, true);
+    if(!Copy)
+        Copy = CopyCFStringToC(String, false);
+
+    if(Copy)
+    {
+        Result = AXLibInternString(Copy);
+        free(Copy);
+    }
+
+    return Result;
+}
+
+/* NOTE: Must be thread-safe! Does not take a reference; the result may only be used for
+         comparisons, unless the caller knows that the string is kept alive elsewhere. */
+ax_string *AXLibFindString(const char *Text)
+{
+    if(!Text)
+        return NULL;
+
+    size_t Length = strlen(Text);
+    uint32_t Hash = AXLibHashString(Text, Length);
+
+    pthread_mutex_lock(&StringTableLock);
+    ax_string *Result = AXLibLookupString(Text, Length, Hash);
+    pthread_mutex_unlock(&StringTableLock);
+
+    return Result;
+}
+
+/* NOTE: Must be thread-safe! */
+ax_string *AXLibRetainString(ax_string *String)
+{
+    if(String)
+    {
+        pthread_mutex_lock(&StringTableLock);
+        ++String->References;
+        pthread_mutex_unlock(&StringTableLock);
+    }
+
+    return String;
+}
+
+/* NOTE: Must be thread-safe! The string is removed from the table together with its last
+         reference, under the same lock that lookups take. */
+void AXLibReleaseString(ax_string *String)
+{
+    if(!String)
+        return;
+
+    pthread_mutex_lock(&StringTableLock);
+    if(--String->References == 0)
+    {
+        ax_string **Link = &StringTable.Buckets[String->Hash & (StringTable.Capacity - 1)];
+        while(*Link != String)
+            Link = &(*Link)->Next;
+
+        *Link = String->Next;
+        --StringTable.Count;
+        free(String);
+    }
+    pthread_mutex_unlock(&StringTableLock);
+}
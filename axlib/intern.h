@@ -0,0 +1,41 @@
+#ifndef AXLIB_INTERN_H
+#define AXLIB_INTERN_H
+
+#include <Carbon/Carbon.h>
+
+/* NOTE: Every distinct string is stored once. Interned strings are equal if and only if
+         their pointers (or ids) are equal. Ids are never reused, so they are safe to use
+         as keys in caches that outlive the string. Every call that returns an ax_string
+         holds a reference, which must be given back with AXLibReleaseString, unless the
+         string is meant to live for the rest of the program. */
+struct ax_string
+{
+    ax_string *Next;
+    uint32_t ID;
+    uint32_t Hash;
+    uint32_t References;
+    uint32_t Length;
+    char *Text;
+};
+
+ax_string *AXLibInternString(const char *Text, size_t Length);
+ax_string *AXLibInternString(const char *Text);
+ax_string *AXLibInternCFString(CFStringRef String);
+ax_string *AXLibFindString(const char *Text);
+
+ax_string *AXLibRetainString(ax_string *String);
+void AXLibReleaseString(ax_string *String);
+
+inline const char *
+AXLibStringText(ax_string *String)
+{
+    return String ? String->Text : NULL;
+}
+
+inline uint32_t
+AXLibStringID(ax_string *String)
+{
+    return String ? String->ID : 0;
+}
+
+#endif
@@ -130,6 +130,13 @@ bool SharedWorkspaceIsApplicationHidden(pid_t PID)
 
 - (void)activeSpaceDidChange:(NSNotification *)notification
 {
+    /* NOTE: The notification arrives while the transition animation is still running. */
+    AXLibBeginSpaceTransition();
+
+    /* NOTE: Spaces can only be added, removed or reordered through Mission Control,
+             which does not tell us about it. Switching spaces is our best hint. */
+    AXLibInvalidateSpaceTopology();
+
     /* NOTE(koekeishiya): OSX APIs are horrible, so we need to detect which display
                           this event was triggered for. */
     ax_display *MainDisplay = AXLibMainDisplay();
@@ -151,7 +158,7 @@ bool SharedWorkspaceIsApplicationHidden(pid_t PID)
 - (void)didActivateApplication:(NSNotification *)notification
 {
     pid_t PID = [[notification.userInfo objectForKey:NSWorkspaceApplicationKey] processIdentifier];
-    ax_application_map *Applications = BeginAXLibApplications();
+    ax_application_map *Applications = BeginAXLibApplicationsWrite();
     if(Applications->find(PID) != Applications->end())
     {
         ax_application *Application = (*Applications)[PID];
@@ -184,9 +191,10 @@ bool SharedWorkspaceIsApplicationHidden(pid_t PID)
 {
     pid_t PID = [[notification.userInfo objectForKey:NSWorkspaceApplicationKey] processIdentifier];
     ax_application_map *Applications = BeginAXLibApplications();
-    if(Applications->find(PID) != Applications->end())
+    ax_application_map_iter It = Applications->find(PID);
+    if(It != Applications->end())
     {
-        ax_application *Application = (*Applications)[PID];
+        ax_application *Application = It->second;
 
         pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
         *ApplicationPID = Application->PID;
@@ -199,9 +207,10 @@ bool SharedWorkspaceIsApplicationHidden(pid_t PID)
 {
     pid_t PID = [[notification.userInfo objectForKey:NSWorkspaceApplicationKey] processIdentifier];
     ax_application_map *Applications = BeginAXLibApplications();
-    if(Applications->find(PID) != Applications->end())
+    ax_application_map_iter It = Applications->find(PID);
+    if(It != Applications->end())
     {
-        ax_application *Application = (*Applications)[PID];
+        ax_application *Application = It->second;
 
         pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
         *ApplicationPID = Application->PID;
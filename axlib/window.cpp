@@ -1,5 +1,194 @@
 #include "window.h"
 #include "element.h"
+#include "event.h"
+#include "worker.h"
+
+#include <map>
+#include <math.h>
+
+#define internal static
+#define local_persist static
+
+/* NOTE: Frames that we have requested for a window, but that the application has not
+         yet confirmed through a kAXWindowMoved or kAXWindowResized notification.
+         A notification that matches the expected frame is our own echo, and is
+         dropped by the observer before an event is ever constructed. Expectations
+         that are not confirmed within AX_EXPECTED_FRAME_TIMEOUT are discarded. */
+#define AX_EXPECTED_FRAME_TIMEOUT (500 * 1000 * 1000ULL)
+
+struct ax_expected_frame
+{
+    uint32_t Pending;
+    CGPoint Position;
+    CGSize Size;
+    uint64_t Deadline;
+};
+
+internal std::map<uint32_t, ax_expected_frame> ExpectedFrames;
+internal pthread_mutex_t ExpectedFramesLock = PTHREAD_MUTEX_INITIALIZER;
+internal uint64_t SuppressedEchoes;
+
+/* NOTE: Must be thread-safe! Called by the application workers when they correct a frame. */
+void AXLibExpectWindowFrame(uint32_t WID, uint32_t Flag, CGPoint Position, CGSize Size)
+{
+    pthread_mutex_lock(&ExpectedFramesLock);
+    ax_expected_frame *Frame = &ExpectedFrames[WID];
+    Frame->Pending |= Flag;
+    if(Flag == AXWindow_MoveIntrinsic)
+        Frame->Position = Position;
+    else
+        Frame->Size = Size;
+
+    Frame->Deadline = AXLibCurrentTime() + AX_EXPECTED_FRAME_TIMEOUT;
+    pthread_mutex_unlock(&ExpectedFramesLock);
+}
+
+/* NOTE: Must be thread-safe! Called by the application workers when a request fails. */
+void AXLibForgetWindowFrame(uint32_t WID, uint32_t Flag)
+{
+    pthread_mutex_lock(&ExpectedFramesLock);
+    std::map<uint32_t, ax_expected_frame>::iterator It = ExpectedFrames.find(WID);
+    if(It != ExpectedFrames.end())
+    {
+        It->second.Pending &= ~Flag;
+        if(It->second.Pending == 0)
+            ExpectedFrames.erase(It);
+    }
+    pthread_mutex_unlock(&ExpectedFramesLock);
+}
+
+/* NOTE: Must be thread-safe! Called from the observer callbacks with the frame that was
+         just reported for the window. Returns true if the notification is the echo of a
+         frame that we requested ourselves. A frame that does not match is left pending,
+         because an application may report intermediate frames before our final one. */
+bool AXLibIsExpectedWindowFrame(ax_window *Window, uint32_t Flag)
+{
+    bool Result = false;
+
+    pthread_mutex_lock(&ExpectedFramesLock);
+    std::map<uint32_t, ax_expected_frame>::iterator It = ExpectedFrames.find(Window->ID);
+    if(It != ExpectedFrames.end())
+    {
+        ax_expected_frame *Frame = &It->second;
+        if(AXLibCurrentTime() > Frame->Deadline)
+        {
+            ExpectedFrames.erase(It);
+        }
+        else if(Frame->Pending & Flag)
+        {
+            if(Flag == AXWindow_MoveIntrinsic)
+                Result = ((fabs(Frame->Position.x - Window->Position.x) < 1.0) &&
+                          (fabs(Frame->Position.y - Window->Position.y) < 1.0));
+            else
+                Result = ((fabs(Frame->Size.width - Window->Size.width) < 1.0) &&
+                          (fabs(Frame->Size.height - Window->Size.height) < 1.0));
+
+            if(Result)
+            {
+                ++SuppressedEchoes;
+                Frame->Pending &= ~Flag;
+                if(Frame->Pending == 0)
+                    ExpectedFrames.erase(It);
+            }
+        }
+    }
+    pthread_mutex_unlock(&ExpectedFramesLock);
+
+    return Result;
+}
+
+uint64_t AXLibSuppressedWindowEchoes()
+{
+    pthread_mutex_lock(&ExpectedFramesLock);
+    uint64_t Result = SuppressedEchoes;
+    pthread_mutex_unlock(&ExpectedFramesLock);
+    return Result;
+}
+
+/* NOTE: Moves the window and records the new position as expected, so that the echo
+         of this change is suppressed. The request is performed by the worker of the
+         application, and the window is assumed to be at the requested position until
+         the application reports otherwise. A request that fails only forgets the
+         expected frame; the next notification for the window corrects the rest. */
+bool AXLibMoveWindow(ax_window *Window, int X, int Y)
+{
+    AXLibExpectWindowFrame(Window->ID, AXWindow_MoveIntrinsic, CGPointMake(X, Y), CGSizeZero);
+    AXLibAddFlags(Window, AXWindow_MoveIntrinsic);
+
+    Window->Position = CGPointMake(X, Y);
+    AXLibQueueWindowFrame(Window, AXWindow_MoveIntrinsic, Window->Position, CGSizeZero);
+    return true;
+}
+
+/* NOTE: Resizes the window, see AXLibMoveWindow(..). */
+bool AXLibResizeWindow(ax_window *Window, int Width, int Height)
+{
+    AXLibExpectWindowFrame(Window->ID, AXWindow_SizeIntrinsic, CGPointZero, CGSizeMake(Width, Height));
+    AXLibAddFlags(Window, AXWindow_SizeIntrinsic);
+
+    Window->Size = CGSizeMake(Width, Height);
+    AXLibQueueWindowFrame(Window, AXWindow_SizeIntrinsic, CGPointZero, Window->Size);
+    return true;
+}
+
+/* NOTE: Must be thread-safe! Returns the interned id of the given role, which is the
+         same for every window and rule that refers to it. There are only a handful of
+         distinct roles, so their strings are never released. */
+uint32_t AXLibRoleID(const char *Role)
+{
+    if(!Role || !*Role)
+        return 0;
+
+    return AXLibInternString(Role)->ID;
+}
+
+internal uint32_t
+AXLibRoleID(CFTypeRef Role)
+{
+    uint32_t Result = 0;
+    if(Role && CFGetTypeID(Role) == CFStringGetTypeID())
+    {
+        char *RoleC = CopyCFStringToC((CFStringRef) Role, true);
+        Result = AXLibRoleID(RoleC);
+        free(RoleC);
+    }
+
+    return Result;
+}
+
+/* NOTE: Resolves the role class and role flags of a window once, so that the predicates
+         used while filtering windows only have to test bits. */
+internal void
+AXLibClassifyWindow(ax_window *Window)
+{
+    local_persist uint32_t WindowRoleID = AXLibRoleID(CFSTR("AXWindow"));
+    local_persist uint32_t StandardSubroleID = AXLibRoleID(CFSTR("AXStandardWindow"));
+    local_persist uint32_t DialogSubroleID = AXLibRoleID(CFSTR("AXDialog"));
+    local_persist uint32_t SystemDialogSubroleID = AXLibRoleID(CFSTR("AXSystemDialog"));
+    local_persist uint32_t FloatingSubroleID = AXLibRoleID(CFSTR("AXFloatingWindow"));
+
+    ax_window_role *Type = &Window->Type;
+    Type->RoleID = AXLibRoleID(Type->Role);
+    Type->SubroleID = AXLibRoleID(Type->Subrole);
+
+    Type->Class = AXWindowClass_Unknown;
+    if(Type->RoleID == WindowRoleID)
+    {
+        if(Type->SubroleID == StandardSubroleID)
+            Type->Class = AXWindowClass_Standard;
+        else if(Type->SubroleID == DialogSubroleID)
+            Type->Class = AXWindowClass_Dialog;
+        else if(Type->SubroleID == SystemDialogSubroleID)
+            Type->Class = AXWindowClass_SystemDialog;
+        else if(Type->SubroleID == FloatingSubroleID)
+            Type->Class = AXWindowClass_Floating;
+    }
+
+    if(Type->Class == AXWindowClass_Standard)
+        AXLibAddFlags(Window, AXWindow_Standard);
+
+    AXLibSetWindowCustomRole(Window, Type->CustomRoleID);
+}
 
 ax_window *AXLibConstructWindow(ax_application *Application, AXUIElementRef WindowRef)
 {
@@ -8,6 +197,7 @@ ax_window *AXLibConstructWindow(ax_application *Application, AXUIElementRef Wind
 
     Window->Ref = (AXUIElementRef) CFRetain(WindowRef);
     Window->Application = Application;
+    AXUIElementSetMessagingTimeout(Window->Ref, AXLibApplicationDeadline());
     Window->ID = AXLibGetWindowID(Window->Ref);
     Window->Name = AXLibGetWindowTitle(Window->Ref);
     Window->Position = AXLibGetWindowPosition(Window->Ref);
@@ -22,43 +212,55 @@ ax_window *AXLibConstructWindow(ax_application *Application, AXUIElementRef Wind
     if(AXLibIsWindowMinimized(Window->Ref))
         AXLibAddFlags(Window, AXWindow_Minimized);
 
+    if(AXLibIsWindowFullscreen(Window->Ref))
+        AXLibAddFlags(Window, AXWindow_Fullscreen);
+
     AXLibGetWindowRole(Window->Ref, &Window->Type.Role);
     AXLibGetWindowSubrole(Window->Ref, &Window->Type.Subrole);
+    AXLibClassifyWindow(Window);
 
     return Window;
 }
 
 bool AXLibIsWindowStandard(ax_window *Window)
 {
-    bool Result = ((Window->Type.Role && CFEqual(Window->Type.Role, kAXWindowRole)) &&
-                   (Window->Type.Subrole && CFEqual(Window->Type.Subrole, kAXStandardWindowSubrole)));
-    return Result;
+    return AXLibHasFlags(Window, AXWindow_Standard);
 }
 
 bool AXLibIsWindowCustom(ax_window *Window)
 {
-    bool Result = ((Window->Type.CustomRole) &&
-                   ((Window->Type.Role && CFEqual(Window->Type.Role, Window->Type.CustomRole)) ||
-                    (Window->Type.Subrole && CFEqual(Window->Type.Subrole, Window->Type.CustomRole))));
-    return Result;
+    return AXLibHasFlags(Window, AXWindow_Custom);
 }
 
-bool AXLibWindowHasRole(ax_window *Window, CFTypeRef Role)
+bool AXLibWindowHasRole(ax_window *Window, uint32_t RoleID)
 {
-    bool Result = ((Window->Type.Role && CFEqual(Window->Type.Role, Role)) ||
-                   (Window->Type.Subrole && CFEqual(Window->Type.Subrole, Role)));
+    bool Result = ((RoleID) &&
+                   ((Window->Type.RoleID == RoleID) ||
+                    (Window->Type.SubroleID == RoleID)));
     return Result;
 }
 
-bool AXLibWindowHasCustomRole(ax_window *Window, CFTypeRef Role)
+bool AXLibWindowHasCustomRole(ax_window *Window, uint32_t RoleID)
 {
-    bool Result = ((Window->Type.CustomRole) &&
-                   (CFEqual(Role, Window->Type.CustomRole)));
+    bool Result = ((RoleID) &&
+                   (Window->Type.CustomRoleID == RoleID));
     return Result;
 }
 
+/* NOTE: A window is custom when its role or subrole is the custom role assigned to it. */
+void AXLibSetWindowCustomRole(ax_window *Window, uint32_t RoleID)
+{
+    Window->Type.CustomRoleID = RoleID;
+    if(AXLibWindowHasRole(Window, RoleID))
+        AXLibAddFlags(Window, AXWindow_Custom);
+    else
+        AXLibClearFlags(Window, AXWindow_Custom);
+}
+
 void AXLibDestroyWindow(ax_window *Window)
 {
+    AXLibForgetWindowFrame(Window->ID, AXWindow_MoveIntrinsic | AXWindow_SizeIntrinsic);
+
     if(Window->Ref)
         CFRelease(Window->Ref);
 
@@ -68,11 +270,7 @@ void AXLibDestroyWindow(ax_window *Window)
     if(Window->Type.Subrole)
         CFRelease(Window->Type.Subrole);
 
-    if(Window->Type.CustomRole)
-        CFRelease(Window->Type.CustomRole);
-
-    if(Window->Name)
-        free(Window->Name);
+    AXLibReleaseString(Window->Name);
 
     free(Window);
 }
@@ -2,6 +2,7 @@
 #define AXLIB_WINDOW_H
 
 #include <Carbon/Carbon.h>
+#include "intern.h"
 
 enum ax_window_flags
 {
@@ -12,16 +13,49 @@ enum ax_window_flags
 
     AXWindow_MoveIntrinsic = (1 << 4),
     AXWindow_SizeIntrinsic = (1 << 5),
+
+    AXWindow_Standard = (1 << 6),
+    AXWindow_Custom = (1 << 7),
+
+    /* NOTE: Native fullscreen, refreshed whenever the application reports a new size. */
+    AXWindow_Fullscreen = (1 << 8),
+};
+
+/* NOTE: Classification of the role and subrole of a window, resolved once when
+         the window is constructed. */
+enum ax_window_class
+{
+    AXWindowClass_Unknown,
+    AXWindowClass_Standard,
+    AXWindowClass_Dialog,
+    AXWindowClass_SystemDialog,
+    AXWindowClass_Floating,
 };
 
+/* NOTE: Roles are interned, so that they can be compared as integers. Zero is
+         never a valid role id. */
 struct ax_window_role
 {
     CFTypeRef Role;
     CFTypeRef Subrole;
-    CFTypeRef CustomRole;
+
+    ax_window_class Class;
+    uint32_t RoleID;
+    uint32_t SubroleID;
+    uint32_t CustomRoleID;
 };
 
 struct ax_application;
+struct ax_display;
+
+/* NOTE: The display resolved by AXLibWindowDisplay for the given frame. It is only
+         valid while the frame is unchanged and the display configuration is the same. */
+struct ax_window_display
+{
+    ax_display *Display;
+    CGRect Frame;
+    uint32_t Generation;
+};
 struct ax_window
 {
     ax_application *Application;
@@ -33,7 +67,9 @@ struct ax_window
 
     CGSize Size;
     CGPoint Position;
-    char *Name;
+    ax_string *Name;
+
+    ax_window_display DisplayCache;
 };
 
 inline bool
@@ -61,7 +97,16 @@ void AXLibDestroyWindow(ax_window *Window);
 bool AXLibIsWindowStandard(ax_window *Window);
 bool AXLibIsWindowCustom(ax_window *Window);
 
-bool AXLibWindowHasRole(ax_window *Window, CFTypeRef Role);
-bool AXLibWindowHasCustomRole(ax_window *Window, CFTypeRef Role);
+uint32_t AXLibRoleID(const char *Role);
+bool AXLibWindowHasRole(ax_window *Window, uint32_t RoleID);
+bool AXLibWindowHasCustomRole(ax_window *Window, uint32_t RoleID);
+void AXLibSetWindowCustomRole(ax_window *Window, uint32_t RoleID);
+
+bool AXLibMoveWindow(ax_window *Window, int X, int Y);
+bool AXLibResizeWindow(ax_window *Window, int Width, int Height);
+void AXLibExpectWindowFrame(uint32_t WID, uint32_t Flag, CGPoint Position, CGSize Size);
+bool AXLibIsExpectedWindowFrame(ax_window *Window, uint32_t Flag);
+void AXLibForgetWindowFrame(uint32_t WID, uint32_t Flag);
+uint64_t AXLibSuppressedWindowEchoes();
 
 #endif
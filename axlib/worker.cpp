@@ -0,0 +1,327 @@
+#include "worker.h"
+#include "application.h"
+#include "element.h"
+#include "window.h"
+#include "event.h"
+#include "axlib.h"
+
+#define internal static
+
+internal std::atomic<uint64_t> ApplicationDeadline(AX_DEFAULT_DEADLINE * 1000 * 1000 * 1000);
+
+/* NOTE: The deadline also bounds synchronous AX reads, through the messaging timeout of
+         every application and window element we know about. */
+void AXLibSetApplicationDeadline(double Seconds)
+{
+    if(Seconds <= 0)
+        return;
+
+    ApplicationDeadline.store(Seconds * 1000 * 1000 * 1000, std::memory_order_relaxed);
+
+    ax_application_map *Applications = BeginAXLibApplications();
+    for(ax_application_map_iter It = Applications->begin();
+        It != Applications->end();
+        ++It)
+    {
+        ax_application *Application = It->second;
+        AXUIElementSetMessagingTimeout(Application->Ref, Seconds);
+        for(ax_window_map_iter WIt = Application->Windows.begin();
+            WIt != Application->Windows.end();
+            ++WIt)
+        {
+            AXUIElementSetMessagingTimeout(WIt->second->Ref, Seconds);
+        }
+    }
+    EndAXLibApplications();
+}
+
+double AXLibApplicationDeadline()
+{
+    return ApplicationDeadline.load(std::memory_order_relaxed) / (1000.0 * 1000.0 * 1000.0);
+}
+
+internal inline void
+AXLibRetainWorker(ax_application_worker *Worker)
+{
+    Worker->References.fetch_add(1, std::memory_order_relaxed);
+}
+
+internal void
+AXLibReleaseWorker(ax_application_worker *Worker)
+{
+    if(Worker->References.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        std::map<uint32_t, ax_deferred_frame>::iterator It;
+        for(It = Worker->Pending.begin(); It != Worker->Pending.end(); ++It)
+            CFRelease(It->second.Ref);
+
+        pthread_mutex_destroy(&Worker->PendingLock);
+        dispatch_release(Worker->Queue);
+        delete Worker;
+    }
+}
+
+internal inline void
+AXLibUpdateMaxLatency(ax_application_worker *Worker, uint64_t Latency)
+{
+    uint64_t Current = Worker->MaxLatency.load(std::memory_order_relaxed);
+    while((Latency > Current) &&
+          (!Worker->MaxLatency.compare_exchange_weak(Current, Latency, std::memory_order_relaxed)));
+}
+
+/* NOTE: Runs on the queue of the worker, after a resize that completed within the deadline. Reading
+         the frame back here, rather than on the event-loop, sees the size that the application
+         actually applied, and never blocks the event-loop on a slow application. A correction is
+         expected like any other frame that we set, and reported back to the event-loop. */
+internal void
+AXLibCorrectWindowFrame(uint32_t WID, ax_deferred_frame *Frame)
+{
+    CGSize Size = AXLibGetWindowSize(Frame->Ref);
+    CGPoint Position = (Frame->Flags & AXWindow_MoveIntrinsic) ? Frame->Position : AXLibGetWindowPosition(Frame->Ref);
+    CGRect Requested = { Position, Frame->Size };
+
+    if(!AXLibCenterWindowFrame(&Position, Frame->Size, Size))
+        return;
+
+    AXLibForgetWindowFrame(WID, AXWindow_SizeIntrinsic);
+    AXLibExpectWindowFrame(WID, AXWindow_MoveIntrinsic, Position, CGSizeZero);
+    if(!AXLibSetWindowPosition(Frame->Ref, Position.x, Position.y))
+    {
+        AXLibForgetWindowFrame(WID, AXWindow_MoveIntrinsic);
+        Position = Requested.origin;
+    }
+
+    ax_window_frame *Correction = (ax_window_frame *) malloc(sizeof(ax_window_frame));
+    Correction->ID = WID;
+    Correction->Requested = Requested;
+    Correction->Position = Position;
+    Correction->Size = Size;
+    AXLibConstructEvent(AXEvent_WindowFrameCorrected, Correction, true);
+}
+
+/* NOTE: Runs on the queue of the worker. The quarantine is lifted by the first call that
+         completes within the deadline, and extended with a doubling backoff by every
+         call that does not. */
+internal void
+AXLibApplyWindowFrame(ax_application_worker *Worker, uint32_t WID, ax_deferred_frame *Frame)
+{
+    uint64_t Deadline = ApplicationDeadline.load(std::memory_order_relaxed);
+    uint64_t StartTime = AXLibCurrentTime();
+
+    bool Moved = true, Resized = true;
+    if(Frame->Flags & AXWindow_MoveIntrinsic)
+        Moved = AXLibSetWindowPosition(Frame->Ref, Frame->Position.x, Frame->Position.y);
+    if(Frame->Flags & AXWindow_SizeIntrinsic)
+        Resized = AXLibSetWindowSize(Frame->Ref, Frame->Size.width, Frame->Size.height);
+
+    uint64_t EndTime = AXLibCurrentTime();
+    uint64_t Latency = EndTime - StartTime;
+    Worker->Calls.fetch_add(1, std::memory_order_relaxed);
+    Worker->TotalLatency.fetch_add(Latency, std::memory_order_relaxed);
+    AXLibUpdateMaxLatency(Worker, Latency);
+
+    if(Latency >= Deadline)
+    {
+        uint32_t Strikes = Worker->Strikes.fetch_add(1, std::memory_order_relaxed);
+        Worker->Timeouts.fetch_add(1, std::memory_order_relaxed);
+        Worker->QuarantineUntil.store(EndTime + AXLibQuarantineBackoff(Strikes), std::memory_order_relaxed);
+    }
+    else
+    {
+        Worker->Strikes.store(0, std::memory_order_relaxed);
+        Worker->QuarantineUntil.store(0, std::memory_order_relaxed);
+    }
+
+    if(!Moved)
+        AXLibForgetWindowFrame(WID, AXWindow_MoveIntrinsic);
+    if(!Resized)
+        AXLibForgetWindowFrame(WID, AXWindow_SizeIntrinsic);
+
+    if((Frame->Flags & AXWindow_SizeIntrinsic) &&
+       (Resized) &&
+       (Latency < Deadline))
+        AXLibCorrectWindowFrame(WID, Frame);
+}
+
+internal inline bool
+AXLibIsWorkerQuarantined(ax_application_worker *Worker)
+{
+    return AXLibCurrentTime() < Worker->QuarantineUntil.load(std::memory_order_relaxed);
+}
+
+internal void AXLibScheduleDeferredFrames(ax_application_worker *Worker);
+
+/* NOTE: Must be called with PendingLock held. Takes ownership of Frame->Ref. When a frame
+         is already deferred for the window, Newer decides which of the two wins. */
+internal void
+AXLibDeferWindowFrame(ax_application_worker *Worker, uint32_t WID, ax_deferred_frame *Frame, bool Newer)
+{
+    std::map<uint32_t, ax_deferred_frame>::iterator It = Worker->Pending.find(WID);
+    if(It == Worker->Pending.end())
+    {
+        Worker->Pending[WID] = *Frame;
+        return;
+    }
+
+    ax_deferred_frame *Existing = &It->second;
+    if((Frame->Flags & AXWindow_MoveIntrinsic) &&
+       (Newer || !(Existing->Flags & AXWindow_MoveIntrinsic)))
+        Existing->Position = Frame->Position;
+
+    if((Frame->Flags & AXWindow_SizeIntrinsic) &&
+       (Newer || !(Existing->Flags & AXWindow_SizeIntrinsic)))
+        Existing->Size = Frame->Size;
+
+    Existing->Flags |= Frame->Flags;
+    CFRelease(Frame->Ref);
+}
+
+/* NOTE: Runs on the queue of the worker. The first frame is a probe; if the application
+         is still not responding, the remaining frames stay deferred for another round. */
+internal void
+AXLibFlushDeferredFrames(ax_application_worker *Worker)
+{
+    std::map<uint32_t, ax_deferred_frame> Frames;
+    pthread_mutex_lock(&Worker->PendingLock);
+    Frames.swap(Worker->Pending);
+    Worker->RetryScheduled = false;
+    pthread_mutex_unlock(&Worker->PendingLock);
+
+    std::map<uint32_t, ax_deferred_frame>::iterator It = Frames.begin();
+    while(It != Frames.end())
+    {
+        if(!Worker->Stopped.load(std::memory_order_relaxed))
+            AXLibApplyWindowFrame(Worker, It->first, &It->second);
+
+        CFRelease(It->second.Ref);
+        Frames.erase(It++);
+
+        if((!Worker->Stopped.load(std::memory_order_relaxed)) &&
+           (AXLibIsWorkerQuarantined(Worker)))
+            break;
+    }
+
+    pthread_mutex_lock(&Worker->PendingLock);
+    for(It = Frames.begin(); It != Frames.end(); ++It)
+        AXLibDeferWindowFrame(Worker, It->first, &It->second, false);
+
+    if(!Worker->Pending.empty())
+        AXLibScheduleDeferredFrames(Worker);
+    pthread_mutex_unlock(&Worker->PendingLock);
+}
+
+/* NOTE: Must be called with PendingLock held. */
+internal void
+AXLibScheduleDeferredFrames(ax_application_worker *Worker)
+{
+    if(Worker->RetryScheduled)
+        return;
+
+    uint64_t Now = AXLibCurrentTime();
+    uint64_t Until = Worker->QuarantineUntil.load(std::memory_order_relaxed);
+    int64_t Delay = Until > Now ? Until - Now : 0;
+
+    Worker->RetryScheduled = true;
+    AXLibRetainWorker(Worker);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, Delay), Worker->Queue,
+    ^{
+        AXLibFlushDeferredFrames(Worker);
+        AXLibReleaseWorker(Worker);
+    });
+}
+
+void AXLibStartApplicationWorker(ax_application *Application)
+{
+    ax_application_worker *Worker = new ax_application_worker();
+    Worker->Queue = dispatch_queue_create("com.koekeishiya.axlib.application", DISPATCH_QUEUE_SERIAL);
+    Worker->References.store(1, std::memory_order_relaxed);
+    pthread_mutex_init(&Worker->PendingLock, NULL);
+
+    Application->Worker = Worker;
+    AXUIElementSetMessagingTimeout(Application->Ref, AXLibApplicationDeadline());
+}
+
+/* NOTE: Does not wait for the queue to drain, as the application may be hung. Requests
+         that are still queued are dropped, and the worker is freed by the last one. */
+void AXLibStopApplicationWorker(ax_application *Application)
+{
+    ax_application_worker *Worker = Application->Worker;
+    if(Worker)
+    {
+        Worker->Stopped.store(true, std::memory_order_relaxed);
+        Application->Worker = NULL;
+        AXLibReleaseWorker(Worker);
+    }
+}
+
+void AXLibQueueWindowFrame(ax_window *Window, uint32_t Flags, CGPoint Position, CGSize Size)
+{
+    ax_application_worker *Worker = Window->Application->Worker;
+    if(!Worker)
+        return;
+
+    uint32_t WID = Window->ID;
+    ax_deferred_frame Frame = { (AXUIElementRef) CFRetain(Window->Ref), Flags, Position, Size };
+
+    if(AXLibIsWorkerQuarantined(Worker))
+    {
+        pthread_mutex_lock(&Worker->PendingLock);
+        AXLibDeferWindowFrame(Worker, WID, &Frame, true);
+        AXLibScheduleDeferredFrames(Worker);
+        pthread_mutex_unlock(&Worker->PendingLock);
+    }
+    else
+    {
+        /* NOTE: The application may have been quarantined while this request was queued,
+                 in which case it is deferred as well. Anything deferred for the window
+                 was requested after this, and takes precedence. */
+        AXLibRetainWorker(Worker);
+        dispatch_async(Worker->Queue,
+        ^{
+            ax_deferred_frame Request = Frame;
+            if(Worker->Stopped.load(std::memory_order_relaxed))
+            {
+                CFRelease(Request.Ref);
+            }
+            else if(AXLibIsWorkerQuarantined(Worker))
+            {
+                pthread_mutex_lock(&Worker->PendingLock);
+                AXLibDeferWindowFrame(Worker, WID, &Request, false);
+                AXLibScheduleDeferredFrames(Worker);
+                pthread_mutex_unlock(&Worker->PendingLock);
+            }
+            else
+            {
+                AXLibApplyWindowFrame(Worker, WID, &Request);
+                CFRelease(Request.Ref);
+            }
+
+            AXLibReleaseWorker(Worker);
+        });
+    }
+}
+
+bool AXLibIsApplicationQuarantined(ax_application *Application)
+{
+    return Application->Worker && AXLibIsWorkerQuarantined(Application->Worker);
+}
+
+/* NOTE: Must be thread-safe! Latencies are in nanoseconds. */
+void AXLibApplicationLatencyStats(ax_application *Application, ax_application_latency *Stats)
+{
+    memset(Stats, 0, sizeof(ax_application_latency));
+
+    ax_application_worker *Worker = Application->Worker;
+    if(Worker)
+    {
+        Stats->Calls = Worker->Calls.load(std::memory_order_relaxed);
+        Stats->Timeouts = Worker->Timeouts.load(std::memory_order_relaxed);
+        Stats->TotalLatency = Worker->TotalLatency.load(std::memory_order_relaxed);
+        Stats->MaxLatency = Worker->MaxLatency.load(std::memory_order_relaxed);
+        Stats->Quarantined = AXLibIsWorkerQuarantined(Worker);
+
+        pthread_mutex_lock(&Worker->PendingLock);
+        Stats->Pending = Worker->Pending.size();
+        pthread_mutex_unlock(&Worker->PendingLock);
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef AXLIB_WORKER_H
+#define AXLIB_WORKER_H
+
+#include <Carbon/Carbon.h>
+#include <atomic>
+#include <map>
+
+/* NOTE: Every application has its own serial queue that performs the AX calls which
+         change window geometry, so that a slow or hung application only stalls its
+         own queue and never the event-loop. A call that takes longer than the
+         deadline puts the application in quarantine. While quarantined, new frames
+         are coalesced per window and flushed by a single retry in the background. */
+#define AX_DEFAULT_DEADLINE 0.25
+#define AX_QUARANTINE_MIN (500 * 1000 * 1000ULL)
+#define AX_QUARANTINE_MAX (8 * 1000 * 1000 * 1000ULL)
+
+struct ax_deferred_frame
+{
+    AXUIElementRef Ref;
+    uint32_t Flags;
+    CGPoint Position;
+    CGSize Size;
+};
+
+struct ax_application_worker
+{
+    dispatch_queue_t Queue;
+    std::atomic<uint32_t> References;
+    std::atomic<bool> Stopped;
+
+    std::atomic<uint64_t> QuarantineUntil;
+    std::atomic<uint32_t> Strikes;
+
+    std::atomic<uint64_t> Calls;
+    std::atomic<uint64_t> Timeouts;
+    std::atomic<uint64_t> TotalLatency;
+    std::atomic<uint64_t> MaxLatency;
+
+    pthread_mutex_t PendingLock;
+    std::map<uint32_t, ax_deferred_frame> Pending;
+    bool RetryScheduled;
+};
+
+struct ax_application_latency
+{
+    uint64_t Calls;
+    uint64_t Timeouts;
+    uint64_t TotalLatency;
+    uint64_t MaxLatency;
+    uint64_t Pending;
+    bool Quarantined;
+};
+
+/* NOTE: Context of AXEvent_WindowFrameCorrected. Requested is the frame that the worker was asked
+         for, Position and Size is the frame the window actually ended up with. */
+struct ax_window_frame
+{
+    uint32_t ID;
+    CGRect Requested;
+    CGPoint Position;
+    CGSize Size;
+};
+
+/* NOTE: The quarantine doubles with every consecutive strike, up to AX_QUARANTINE_MAX. */
+inline uint64_t
+AXLibQuarantineBackoff(uint32_t Strikes)
+{
+    uint64_t Result = AX_QUARANTINE_MIN << (Strikes < 4 ? Strikes : 4);
+    return Result > AX_QUARANTINE_MAX ? AX_QUARANTINE_MAX : Result;
+}
+
+/* NOTE: A window that did not accept the requested size, because of a minimum size or a size
+         increment, is centered inside the frame it was given. Returns true if the position had
+         to change. A window that ended up larger than requested is left alone. */
+inline bool
+AXLibCenterWindowFrame(CGPoint *Position, CGSize Requested, CGSize Actual)
+{
+    double XOff = (Requested.width - Actual.width) / 2.0;
+    double YOff = (Requested.height - Actual.height) / 2.0;
+    if(XOff < 1.0 && YOff < 1.0)
+        return false;
+
+    Position->x += XOff > 0 ? (int) XOff : 0;
+    Position->y += YOff > 0 ? (int) YOff : 0;
+    return true;
+}
+
+struct ax_application;
+struct ax_window;
+
+void AXLibSetApplicationDeadline(double Seconds);
+double AXLibApplicationDeadline();
+
+void AXLibStartApplicationWorker(ax_application *Application);
+void AXLibStopApplicationWorker(ax_application *Application);
+
+void AXLibQueueWindowFrame(ax_window *Window, uint32_t Flags, CGPoint Position, CGSize Size);
+bool AXLibIsApplicationQuarantined(ax_application *Application);
+void AXLibApplicationLatencyStats(ax_application *Application, ax_application_latency *Stats);
+
+#endif
@@ -4,6 +4,7 @@
 #include <objc/runtime.h>
 #include <objc/message.h>
 #include <CoreFoundation/CoreFoundation.h>
+#include <algorithm>
 
 #define internal static
 #define local_persist static
@@ -86,50 +87,146 @@ OverlayLibRemoveBorder(uint32_t BorderId)
 }
 
 
+/* NOTE: Borders are not sent to the overlay when they change. Every border that changed
+         during a batch of events is queued once, and FlushBorders submits its final
+         state after the batch, when the geometry of the windows has been committed.
+         A border whose final state equals what the overlay shows is skipped. */
+internal std::vector<kwm_border *> QueuedBorders;
+
+internal inline bool
+ColorEquals(color *A, color *B)
+{
+    return (A->Red == B->Red) &&
+           (A->Green == B->Green) &&
+           (A->Blue == B->Blue) &&
+           (A->Alpha == B->Alpha);
+}
+
+internal inline bool
+BorderStateEquals(border_state *A, border_state *B)
+{
+    if(A->Visible != B->Visible)
+        return false;
+
+    if(!A->Visible)
+        return true;
+
+    return (CGRectEqualToRect(A->Frame, B->Frame)) &&
+           (ColorEquals(&A->Color, &B->Color)) &&
+           (A->Width == B->Width) &&
+           (A->Radius == B->Radius);
+}
+
+internal void
+QueueBorder(kwm_border *Border, bool Visible, CGRect Frame, uint32_t WindowID)
+{
+    Border->WindowID = WindowID;
+    Border->Requested.Visible = Visible;
+    if(Visible)
+    {
+        Border->Requested.Frame = Frame;
+        Border->Requested.Color = Border->Color;
+        Border->Requested.Width = Border->Width;
+        Border->Requested.Radius = Border->Radius;
+    }
+
+    if(!Border->Queued)
+    {
+        Border->Queued = true;
+        QueuedBorders.push_back(Border);
+    }
+}
+
+internal void
+UnqueueBorder(kwm_border *Border)
+{
+    if(Border->Queued)
+    {
+        QueuedBorders.erase(std::find(QueuedBorders.begin(), QueuedBorders.end(), Border));
+        Border->Queued = false;
+    }
+}
+
 internal void
 OpenBorder(kwm_border *Border)
 {
     Border->BorderId = OverlayLibCreateBorder(0, 0, 100, 100, 0, 0, 0, 0, 0, 0);
+    Border->Submitted.Visible = false;
 }
 
-void CloseBorder(kwm_border *Border)
+internal void
+RemoveBorder(kwm_border *Border)
 {
     if(Border->BorderId)
     {
         OverlayLibRemoveBorder(Border->BorderId);
         Border->BorderId = 0;
     }
+
+    Border->Submitted.Visible = false;
 }
 
-void ClearBorder(kwm_border *Border)
+internal void
+SubmitBorder(kwm_border *Border)
 {
-    if(Border->BorderId)
+    border_state *State = &Border->Requested;
+    if(!State->Visible)
     {
-        OverlayLibRemoveBorder(Border->BorderId);
-        Border->BorderId = 0;
+        RemoveBorder(Border);
+        return;
+    }
+
+    if(Border->WindowID)
+    {
+        ax_window *Window = GetWindowByID(Border->WindowID);
+        if(Window)
+            State->Frame = CGRectMake(Window->Position.x, Window->Position.y,
+                                      Window->Size.width, Window->Size.height);
+    }
+
+    if(!Border->BorderId)
+        OpenBorder(Border);
+
+    if((Border->BorderId) &&
+       (!BorderStateEquals(State, &Border->Submitted)))
+    {
+        OverlayLibUpdateBorder(
+            Border->BorderId,
+            State->Frame.origin.x, State->Frame.origin.y, State->Frame.size.width, State->Frame.size.height,
+            State->Color.Red, State->Color.Green, State->Color.Blue, State->Color.Alpha,
+            State->Width, State->Radius
+        );
+
+        Border->Submitted = *State;
     }
 }
 
-internal inline void
-RefreshBorder(kwm_border *Border, ax_window *Window)
+/* NOTE: Must only be called from the event-loop thread, once the geometry changes of
+         the current batch of events have been made. */
+void FlushBorders()
 {
-	OverlayLibUpdateBorder(
-		Border->BorderId,
-		Window->Position.x, Window->Position.y, Window->Size.width, Window->Size.height,
-		Border->Color.Red, Border->Color.Green, Border->Color.Blue, Border->Color.Alpha,
-		Border->Width, Border->Radius
-	);
+    for(std::size_t Index = 0; Index < QueuedBorders.size(); ++Index)
+    {
+        kwm_border *Border = QueuedBorders[Index];
+        Border->Queued = false;
+        SubmitBorder(Border);
+    }
+
+    QueuedBorders.clear();
 }
 
-internal inline void
-RefreshBorder(kwm_border *Border, tree_node *Node)
+/* NOTE: Takes effect immediately, as the border may be freed by the caller. */
+void CloseBorder(kwm_border *Border)
 {
-    OverlayLibUpdateBorder(
-		Border->BorderId,
-		Node->Container.X, Node->Container.Y, Node->Container.Width, Node->Container.Height,
-		Border->Color.Red, Border->Color.Green, Border->Color.Blue, Border->Color.Alpha,
-		Border->Width, Border->Radius
-	);
+    UnqueueBorder(Border);
+    Border->Requested.Visible = false;
+    RemoveBorder(Border);
+}
+
+void ClearBorder(kwm_border *Border)
+{
+    if(Border->BorderId || Border->Queued)
+        QueueBorder(Border, false, CGRectZero, 0);
 }
 
 void UpdateBorder(kwm_border *Border, ax_window *Window)
@@ -137,17 +234,10 @@ void UpdateBorder(kwm_border *Border, ax_window *Window)
     if(Border && Border->Enabled)
     {
         if(Window)
-        {
-            if(!Border->BorderId)
-                OpenBorder(Border);
-
-            if(Border->BorderId)
-                RefreshBorder(Border, Window);
-        }
+            QueueBorder(Border, true, CGRectMake(Window->Position.x, Window->Position.y,
+                                                 Window->Size.width, Window->Size.height), Window->ID);
         else
-        {
             ClearBorder(Border);
-        }
     }
 }
 
@@ -156,16 +246,9 @@ void UpdateBorder(kwm_border *Border, tree_node *Node)
     if(Border && Border->Enabled)
     {
         if(Node)
-        {
-            if(!Border->BorderId)
-                OpenBorder(Border);
-
-            if(Border->BorderId)
-                RefreshBorder(Border, Node);
-        }
+            QueueBorder(Border, true, CGRectMake(Node->Container.X, Node->Container.Y,
+                                                 Node->Container.Width, Node->Container.Height), 0);
         else
-        {
             ClearBorder(Border);
-        }
     }
 }
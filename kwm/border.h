@@ -10,5 +10,6 @@ void CloseBorder(kwm_border *Border);
 void ClearBorder(kwm_border *Border);
 void UpdateBorder(kwm_border *Border, ax_window *Window);
 void UpdateBorder(kwm_border *Border, tree_node *Node);
+void FlushBorders();
 
 #endif
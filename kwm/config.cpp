@@ -17,13 +17,22 @@
 #include "scratchpad.h"
 #include "cursor.h"
 #include "event.h"
+#include "query.h"
 #include "../axlib/axlib.h"
 
 #define internal static
-#define INVALID_SOCKFD -1
-internal int ClientSockFD = INVALID_SOCKFD;
+internal __thread int ClientSockFD = INVALID_SOCKFD;
+
+/* NOTE: Hands the client socket over to the query, which writes the response and closes
+         the socket. The latest snapshot answers the query directly when possible,
+         otherwise a query event is posted to the event-loop. */
+#define KwmConstructQueryEvent(EventType, EventContext) \
+    do { void *QueryContext = EventContext; \
+         if(!KwmAnswerQueryFromSnapshot(EventType, QueryContext)) \
+             KwmConstructEvent(EventType, QueryContext); \
+         ClientSockFD = INVALID_SOCKFD; \
+       } while(0)
 
-extern std::map<std::string, space_info> WindowTree;
 extern ax_application *FocusedApplication;
 extern ax_window *MarkedWindow;
 
@@ -34,13 +43,54 @@ extern kwm_border MarkedBorder;
 extern kwm_path KWMPath;
 extern kwm_settings KWMSettings;
 
+/* NOTE: The first error completes the response to the client. */
 internal inline void
 ReportInvalidCommand(std::string Command)
 {
     if(ClientSockFD != INVALID_SOCKFD)
+    {
         KwmWriteToSocket(Command, ClientSockFD);
+        ClientSockFD = INVALID_SOCKFD;
+    }
     else
+    {
         std::cerr << "Parse error: " << Command << std::endl;
+    }
+}
+
+internal inline bool
+ConvertTokenToInt(token Token, int *Result)
+{
+    bool Success = ((Token.Type == Token_Digit) &&
+                    (ConvertTextToInt(Token.Text, Token.TextLength, Result)));
+    return Success;
+}
+
+internal inline bool
+ConvertTokenToUint(token Token, uint32_t *Result)
+{
+    bool Success = ((Token.Type == Token_Digit) &&
+                    (ConvertTextToUint(Token.Text, Token.TextLength, Result)));
+    return Success;
+}
+
+internal inline bool
+ConvertTokenToDouble(token Token, double *Result)
+{
+    bool Success = ((Token.Type == Token_Digit) &&
+                    (ConvertTextToDouble(Token.Text, Token.TextLength, Result)));
+    return Success;
+}
+
+internal inline bool
+ConvertTokenToColor(token Token, color *Result)
+{
+    unsigned int Hex;
+    bool Success = ConvertTextToHex(Token.Text, Token.TextLength, &Hex);
+    if(Success)
+        *Result = ConvertHexRGBAToColor(Hex);
+
+    return Success;
 }
 
 internal void
@@ -57,31 +107,46 @@ KwmParseConfigOptionTiling(tokenizer *Tokenizer)
         ReportInvalidCommand("Unknown command 'config tiling " + std::string(Token.Text, Token.TextLength) + "'");
 }
 
+internal void
+KwmParseConfigOptionPrewarm(tokenizer *Tokenizer)
+{
+    token Token = GetToken(Tokenizer);
+    if(TokenEquals(Token, "lazy"))
+        KWMSettings.Prewarm = SpacePrewarmLazy;
+    else if(TokenEquals(Token, "eager"))
+        KWMSettings.Prewarm = SpacePrewarmEager;
+    else if(TokenEquals(Token, "idle"))
+        KWMSettings.Prewarm = SpacePrewarmIdle;
+    else
+        ReportInvalidCommand("Unknown command 'config prewarm " + std::string(Token.Text, Token.TextLength) + "'");
+}
+
 internal void
 KwmParseConfigOptionPadding(tokenizer *Tokenizer)
 {
+    double Top, Bottom, Left, Right;
     bool IsValid = true;
     token TokenTop = GetToken(Tokenizer);
     token TokenBottom = GetToken(Tokenizer);
     token TokenLeft = GetToken(Tokenizer);
     token TokenRight = GetToken(Tokenizer);
 
-    if(TokenTop.Type != Token_Digit)
+    if(!ConvertTokenToDouble(TokenTop, &Top))
     {
         ReportInvalidCommand("Unknown config padding top value '" + std::string(TokenTop.Text, TokenTop.TextLength) + "'");
         IsValid = false;
     }
-    if(TokenBottom.Type != Token_Digit)
+    if(!ConvertTokenToDouble(TokenBottom, &Bottom))
     {
         ReportInvalidCommand("Unknown config padding bottom value '" + std::string(TokenBottom.Text, TokenBottom.TextLength) + "'");
         IsValid = false;
     }
-    if(TokenLeft.Type != Token_Digit)
+    if(!ConvertTokenToDouble(TokenLeft, &Left))
     {
         ReportInvalidCommand("Unknown config padding left value '" + std::string(TokenLeft.Text, TokenLeft.TextLength) + "'");
         IsValid = false;
     }
-    if(TokenRight.Type != Token_Digit)
+    if(!ConvertTokenToDouble(TokenRight, &Right))
     {
         ReportInvalidCommand("Unknown config padding right value '" + std::string(TokenRight.Text, TokenRight.TextLength) + "'");
         IsValid = false;
@@ -89,10 +154,10 @@ KwmParseConfigOptionPadding(tokenizer *Tokenizer)
 
     if(IsValid)
     {
-        container_offset Offset = { ConvertStringToDouble(std::string(TokenTop.Text, TokenTop.TextLength)),
-                                    ConvertStringToDouble(std::string(TokenBottom.Text, TokenBottom.TextLength)),
-                                    ConvertStringToDouble(std::string(TokenLeft.Text, TokenLeft.TextLength)),
-                                    ConvertStringToDouble(std::string(TokenRight.Text, TokenRight.TextLength)),
+        container_offset Offset = { Top,
+                                    Bottom,
+                                    Left,
+                                    Right,
                                     0,
                                     0
                                   };
@@ -104,16 +169,17 @@ KwmParseConfigOptionPadding(tokenizer *Tokenizer)
 internal void
 KwmParseConfigOptionGap(tokenizer *Tokenizer)
 {
+    double Vertical, Horizontal;
     bool IsValid = true;
     token TokenVertical = GetToken(Tokenizer);
     token TokenHorizontal = GetToken(Tokenizer);
 
-    if(TokenVertical.Type != Token_Digit)
+    if(!ConvertTokenToDouble(TokenVertical, &Vertical))
     {
         ReportInvalidCommand("Unknown config gap vertical value '" + std::string(TokenVertical.Text, TokenVertical.TextLength) + "'");
         IsValid = false;
     }
-    if(TokenHorizontal.Type != Token_Digit)
+    if(!ConvertTokenToDouble(TokenHorizontal, &Horizontal))
     {
         ReportInvalidCommand("Unknown config gap horizontal value '" + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength) + "'");
         IsValid = false;
@@ -125,8 +191,8 @@ KwmParseConfigOptionGap(tokenizer *Tokenizer)
                                     0,
                                     0,
                                     0,
-                                    ConvertStringToDouble(std::string(TokenVertical.Text, TokenVertical.TextLength)),
-                                    ConvertStringToDouble(std::string(TokenHorizontal.Text, TokenHorizontal.TextLength))
+                                    Vertical,
+                                    Horizontal
                                   };
 
         SetDefaultGapOfDisplay(Offset);
@@ -214,6 +280,15 @@ KwmParseConfigOptionMouse(tokenizer *Tokenizer)
                 ClearFlags(&KWMSettings, Settings_MouseDrag);
             else if(TokenEquals(Token, "mod"))
                 KwmSetMouseDragKey(GetTextTilEndOfLine(Tokenizer));
+            else if(TokenEquals(Token, "rate"))
+            {
+                double Rate;
+                token Token = GetToken(Tokenizer);
+                if((ConvertTokenToDouble(Token, &Rate)) && (Rate >= 0))
+                    KWMSettings.DragRate = Rate;
+                else
+                    ReportInvalidCommand("Unknown command 'config mouse-drag rate " + std::string(Token.Text, Token.TextLength) + "'");
+            }
             else
                 ReportInvalidCommand("Unknown command 'config mouse-drag " + std::string(Token.Text, Token.TextLength) + "'");
         }
@@ -406,20 +481,17 @@ KwmParseConfigOptionSplitRatio(tokenizer *Tokenizer)
         if(TokenEquals(Token, "ratio"))
         {
             token Token = GetToken(Tokenizer);
-            switch(Token.Type)
+            double Value;
+            if(ConvertTokenToDouble(Token, &Value))
             {
-                case Token_Digit:
-                {
-                    double Value = ConvertStringToDouble(std::string(Token.Text, Token.TextLength));
-                    if(Value > 0.0 && Value < 1.0)
-                    {
-                        KWMSettings.SplitRatio = Value;
-                    }
-                } break;
-                default:
+                if(Value > 0.0 && Value < 1.0)
                 {
-                    ReportInvalidCommand("Unknown command 'config split-ratio " + std::string(Token.Text, Token.TextLength) + "'");
-                } break;
+                    KWMSettings.SplitRatio = Value;
+                }
+            }
+            else
+            {
+                ReportInvalidCommand("Unknown command 'config split-ratio " + std::string(Token.Text, Token.TextLength) + "'");
             }
         }
         else
@@ -440,17 +512,8 @@ KwmParseConfigOptionOptimalRatio(tokenizer *Tokenizer)
         if(TokenEquals(Token, "ratio"))
         {
             token Token = GetToken(Tokenizer);
-            switch(Token.Type)
-            {
-                case Token_Digit:
-                {
-                    KWMSettings.OptimalRatio = ConvertStringToDouble(std::string(Token.Text, Token.TextLength));
-                } break;
-                default:
-                {
-                    ReportInvalidCommand("Unknown command 'config optimal-ratio " + std::string(Token.Text, Token.TextLength) + "'");
-                } break;
-            }
+            if(!ConvertTokenToDouble(Token, &KWMSettings.OptimalRatio))
+                ReportInvalidCommand("Unknown command 'config optimal-ratio " + std::string(Token.Text, Token.TextLength) + "'");
         }
         else
             ReportInvalidCommand("Unknown command 'config optimal-" + std::string(Token.Text, Token.TextLength) + "'");
@@ -461,6 +524,30 @@ KwmParseConfigOptionOptimalRatio(tokenizer *Tokenizer)
     }
 }
 
+internal void
+KwmParseConfigOptionAX(tokenizer *Tokenizer)
+{
+    if(RequireToken(Tokenizer, Token_Dash))
+    {
+        token Token = GetToken(Tokenizer);
+        if(TokenEquals(Token, "deadline"))
+        {
+            double Seconds;
+            token Token = GetToken(Tokenizer);
+            if((ConvertTokenToDouble(Token, &Seconds)) && (Seconds > 0))
+                AXLibSetApplicationDeadline(Seconds);
+            else
+                ReportInvalidCommand("Unknown command 'config ax-deadline " + std::string(Token.Text, Token.TextLength) + "'");
+        }
+        else
+            ReportInvalidCommand("Unknown command 'config ax-" + std::string(Token.Text, Token.TextLength) + "'");
+    }
+    else
+    {
+        ReportInvalidCommand("Expected token '-' after 'config ax'");
+    }
+}
+
 internal void
 KwmParseConfigOptionSpawn(tokenizer *Tokenizer)
 {
@@ -493,42 +580,34 @@ KwmParseConfigOptionBorder(tokenizer *Tokenizer)
         else if(TokenEquals(Token, "size"))
         {
             token Token = GetToken(Tokenizer);
-            switch(Token.Type)
+            if(!ConvertTokenToDouble(Token, &FocusedBorder.Width))
             {
-                case Token_Digit:
-                {
-                    FocusedBorder.Width = ConvertStringToInt(std::string(Token.Text, Token.TextLength));
-                } break;
-                default:
-                {
-                    std::string BorderSize(Token.Text, Token.TextLength);
-                    ReportInvalidCommand("Unknown command 'config border focused size " + BorderSize + "'");
-                } break;
+                std::string BorderSize(Token.Text, Token.TextLength);
+                ReportInvalidCommand("Unknown command 'config border focused size " + BorderSize + "'");
             }
         }
         else if(TokenEquals(Token, "radius"))
         {
             token Token = GetToken(Tokenizer);
-            switch(Token.Type)
+            if(!ConvertTokenToDouble(Token, &FocusedBorder.Radius))
             {
-                case Token_Digit:
-                {
-                    FocusedBorder.Radius = ConvertStringToDouble(std::string(Token.Text, Token.TextLength));
-                } break;
-                default:
-                {
-                    std::string BorderSize(Token.Text, Token.TextLength);
-                    ReportInvalidCommand("Unknown command 'config border focused radius " + BorderSize + "'");
-                } break;
+                std::string BorderSize(Token.Text, Token.TextLength);
+                ReportInvalidCommand("Unknown command 'config border focused radius " + BorderSize + "'");
             }
         }
         else if(TokenEquals(Token, "color"))
         {
             token Token = GetToken(Tokenizer);
-            std::string BorderColor(Token.Text, Token.TextLength);
-            FocusedBorder.Color = ConvertHexRGBAToColor(ConvertHexStringToInt(BorderColor));
-            if(FocusedApplication && FocusedApplication->Focus)
-                UpdateBorder(&FocusedBorder, FocusedApplication->Focus);
+            if(ConvertTokenToColor(Token, &FocusedBorder.Color))
+            {
+                if(FocusedApplication && FocusedApplication->Focus)
+                    UpdateBorder(&FocusedBorder, FocusedApplication->Focus);
+            }
+            else
+            {
+                std::string BorderColor(Token.Text, Token.TextLength);
+                ReportInvalidCommand("Unknown command 'config border focused color " + BorderColor + "'");
+            }
         }
     }
     else if(TokenEquals(TokenBorder, "marked"))
@@ -546,40 +625,29 @@ KwmParseConfigOptionBorder(tokenizer *Tokenizer)
         else if(TokenEquals(Token, "size"))
         {
             token Token = GetToken(Tokenizer);
-            switch(Token.Type)
+            if(!ConvertTokenToDouble(Token, &MarkedBorder.Width))
             {
-                case Token_Digit:
-                {
-                    MarkedBorder.Width = ConvertStringToInt(std::string(Token.Text, Token.TextLength));
-                } break;
-                default:
-                {
-                    std::string BorderSize(Token.Text, Token.TextLength);
-                    ReportInvalidCommand("Unknown command 'config border marked size " + BorderSize + "'");
-                } break;
+                std::string BorderSize(Token.Text, Token.TextLength);
+                ReportInvalidCommand("Unknown command 'config border marked size " + BorderSize + "'");
             }
         }
         else if(TokenEquals(Token, "radius"))
         {
             token Token = GetToken(Tokenizer);
-            switch(Token.Type)
+            if(!ConvertTokenToDouble(Token, &MarkedBorder.Radius))
             {
-                case Token_Digit:
-                {
-                    MarkedBorder.Radius = ConvertStringToDouble(std::string(Token.Text, Token.TextLength));
-                } break;
-                default:
-                {
-                    std::string BorderSize(Token.Text, Token.TextLength);
-                    ReportInvalidCommand("Unknown command 'config border marked radius " + BorderSize + "'");
-                } break;
+                std::string BorderSize(Token.Text, Token.TextLength);
+                ReportInvalidCommand("Unknown command 'config border marked radius " + BorderSize + "'");
             }
         }
         else if(TokenEquals(Token, "color"))
         {
             token Token = GetToken(Tokenizer);
-            std::string BorderColor(Token.Text, Token.TextLength);
-            MarkedBorder.Color = ConvertHexRGBAToColor(ConvertHexStringToInt(BorderColor));
+            if(!ConvertTokenToColor(Token, &MarkedBorder.Color))
+            {
+                std::string BorderColor(Token.Text, Token.TextLength);
+                ReportInvalidCommand("Unknown command 'config border marked color " + BorderColor + "'");
+            }
         }
     }
     else
@@ -591,9 +659,10 @@ KwmParseConfigOptionBorder(tokenizer *Tokenizer)
 internal void
 KwmParseConfigOptionSpace(tokenizer *Tokenizer)
 {
+    int ScreenID, DesktopID;
     token TokenDisplay = GetToken(Tokenizer);
     std::string Display(TokenDisplay.Text, TokenDisplay.TextLength);
-    if(TokenDisplay.Type != Token_Digit)
+    if(!ConvertTokenToInt(TokenDisplay, &ScreenID))
     {
         ReportInvalidCommand("Unknown command 'config space " + Display + "'");
         return;
@@ -601,19 +670,17 @@ KwmParseConfigOptionSpace(tokenizer *Tokenizer)
 
     token TokenSpace = GetToken(Tokenizer);
     std::string Space(TokenSpace.Text, TokenSpace.TextLength);
-    if(TokenSpace.Type != Token_Digit)
+    if(!ConvertTokenToInt(TokenSpace, &DesktopID))
     {
         ReportInvalidCommand("Unknown command 'config space " + Display + " " + Space + "'");
         return;
     }
 
-    int ScreenID = ConvertStringToInt(Display);
-    int DesktopID = ConvertStringToInt(Space);
     space_settings *SpaceSettings = GetSpaceSettingsForDesktopID(ScreenID, DesktopID);
     if(!SpaceSettings)
     {
         space_identifier Lookup = { ScreenID, DesktopID };
-        space_settings NULLSpaceSettings = { KWMSettings.DefaultOffset, SpaceModeDefault, {0, 0}, "", ""};
+        space_settings NULLSpaceSettings = { KWMSettings.DefaultOffset, SpaceModeDefault, {0, 0}, "", NULL };
 
         space_settings *ScreenSettings = GetSpaceSettingsForDisplay(ScreenID);
         if(ScreenSettings)
@@ -639,28 +706,29 @@ KwmParseConfigOptionSpace(tokenizer *Tokenizer)
     }
     else if(TokenEquals(Token, "padding"))
     {
+        double Top, Bottom, Left, Right;
         bool IsValid = true;
         token TokenTop = GetToken(Tokenizer);
         token TokenBottom = GetToken(Tokenizer);
         token TokenLeft = GetToken(Tokenizer);
         token TokenRight = GetToken(Tokenizer);
 
-        if(TokenTop.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenTop, &Top))
         {
             ReportInvalidCommand("Unknown config padding top value '" + std::string(TokenTop.Text, TokenTop.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenBottom.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenBottom, &Bottom))
         {
             ReportInvalidCommand("Unknown config padding bottom value '" + std::string(TokenBottom.Text, TokenBottom.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenLeft.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenLeft, &Left))
         {
             ReportInvalidCommand("Unknown config padding left value '" + std::string(TokenLeft.Text, TokenLeft.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenRight.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenRight, &Right))
         {
             ReportInvalidCommand("Unknown config padding right value '" + std::string(TokenRight.Text, TokenRight.TextLength) + "'");
             IsValid = false;
@@ -668,24 +736,25 @@ KwmParseConfigOptionSpace(tokenizer *Tokenizer)
 
         if(IsValid)
         {
-            SpaceSettings->Offset.PaddingTop = ConvertStringToDouble(std::string(TokenTop.Text, TokenTop.TextLength));
-            SpaceSettings->Offset.PaddingBottom = ConvertStringToDouble(std::string(TokenBottom.Text, TokenBottom.TextLength));
-            SpaceSettings->Offset.PaddingLeft = ConvertStringToDouble(std::string(TokenLeft.Text, TokenLeft.TextLength));
-            SpaceSettings->Offset.PaddingRight = ConvertStringToDouble(std::string(TokenRight.Text, TokenRight.TextLength));
+            SpaceSettings->Offset.PaddingTop = Top;
+            SpaceSettings->Offset.PaddingBottom = Bottom;
+            SpaceSettings->Offset.PaddingLeft = Left;
+            SpaceSettings->Offset.PaddingRight = Right;
         }
     }
     else if(TokenEquals(Token, "gap"))
     {
+        double Vertical, Horizontal;
         bool IsValid = true;
         token TokenVertical = GetToken(Tokenizer);
         token TokenHorizontal = GetToken(Tokenizer);
 
-        if(TokenVertical.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenVertical, &Vertical))
         {
             ReportInvalidCommand("Unknown config gap vertical value '" + std::string(TokenVertical.Text, TokenVertical.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenHorizontal.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenHorizontal, &Horizontal))
         {
             ReportInvalidCommand("Unknown config gap horizontal value '" + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength) + "'");
             IsValid = false;
@@ -693,14 +762,14 @@ KwmParseConfigOptionSpace(tokenizer *Tokenizer)
 
         if(IsValid)
         {
-            SpaceSettings->Offset.VerticalGap = ConvertStringToDouble(std::string(TokenVertical.Text, TokenVertical.TextLength));
-            SpaceSettings->Offset.HorizontalGap = ConvertStringToDouble(std::string(TokenHorizontal.Text, TokenHorizontal.TextLength));
+            SpaceSettings->Offset.VerticalGap = Vertical;
+            SpaceSettings->Offset.HorizontalGap = Horizontal;
         }
     }
     else if(TokenEquals(Token, "name"))
     {
         token Token = GetToken(Tokenizer);
-        SpaceSettings->Name = std::string(Token.Text, Token.TextLength);
+        SpaceSettings->Name = AXLibInternString(Token.Text, Token.TextLength);
     }
     else if(TokenEquals(Token, "tree"))
     {
@@ -716,19 +785,19 @@ KwmParseConfigOptionSpace(tokenizer *Tokenizer)
 internal void
 KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
 {
+    int ScreenID;
     token TokenDisplay = GetToken(Tokenizer);
     std::string Display(TokenDisplay.Text, TokenDisplay.TextLength);
-    if(TokenDisplay.Type != Token_Digit)
+    if(!ConvertTokenToInt(TokenDisplay, &ScreenID))
     {
         ReportInvalidCommand("Unknown command 'config display " + Display + "'");
         return;
     }
 
-    int ScreenID = ConvertStringToInt(Display);
     space_settings *DisplaySettings = GetSpaceSettingsForDisplay(ScreenID);
     if(!DisplaySettings)
     {
-        space_settings NULLSpaceSettings = { KWMSettings.DefaultOffset, SpaceModeDefault, {0, 0}, "", "" };
+        space_settings NULLSpaceSettings = { KWMSettings.DefaultOffset, SpaceModeDefault, {0, 0}, "", NULL };
         KWMSettings.DisplaySettings[ScreenID] = NULLSpaceSettings;
         DisplaySettings = &KWMSettings.DisplaySettings[ScreenID];
     }
@@ -749,28 +818,29 @@ KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
     }
     else if(TokenEquals(Token, "padding"))
     {
+        double Top, Bottom, Left, Right;
         bool IsValid = true;
         token TokenTop = GetToken(Tokenizer);
         token TokenBottom = GetToken(Tokenizer);
         token TokenLeft = GetToken(Tokenizer);
         token TokenRight = GetToken(Tokenizer);
 
-        if(TokenTop.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenTop, &Top))
         {
             ReportInvalidCommand("Unknown config padding top value '" + std::string(TokenTop.Text, TokenTop.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenBottom.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenBottom, &Bottom))
         {
             ReportInvalidCommand("Unknown config padding bottom value '" + std::string(TokenBottom.Text, TokenBottom.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenLeft.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenLeft, &Left))
         {
             ReportInvalidCommand("Unknown config padding left value '" + std::string(TokenLeft.Text, TokenLeft.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenRight.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenRight, &Right))
         {
             ReportInvalidCommand("Unknown config padding right value '" + std::string(TokenRight.Text, TokenRight.TextLength) + "'");
             IsValid = false;
@@ -778,24 +848,25 @@ KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
 
         if(IsValid)
         {
-            DisplaySettings->Offset.PaddingTop = ConvertStringToDouble(std::string(TokenTop.Text, TokenTop.TextLength));
-            DisplaySettings->Offset.PaddingBottom = ConvertStringToDouble(std::string(TokenBottom.Text, TokenBottom.TextLength));
-            DisplaySettings->Offset.PaddingLeft = ConvertStringToDouble(std::string(TokenLeft.Text, TokenLeft.TextLength));
-            DisplaySettings->Offset.PaddingRight = ConvertStringToDouble(std::string(TokenRight.Text, TokenRight.TextLength));
+            DisplaySettings->Offset.PaddingTop = Top;
+            DisplaySettings->Offset.PaddingBottom = Bottom;
+            DisplaySettings->Offset.PaddingLeft = Left;
+            DisplaySettings->Offset.PaddingRight = Right;
         }
     }
     else if(TokenEquals(Token, "gap"))
     {
+        double Vertical, Horizontal;
         bool IsValid = true;
         token TokenVertical = GetToken(Tokenizer);
         token TokenHorizontal = GetToken(Tokenizer);
 
-        if(TokenVertical.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenVertical, &Vertical))
         {
             ReportInvalidCommand("Unknown config gap vertical value '" + std::string(TokenVertical.Text, TokenVertical.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenHorizontal.Type != Token_Digit)
+        if(!ConvertTokenToDouble(TokenHorizontal, &Horizontal))
         {
             ReportInvalidCommand("Unknown config gap horizontal value '" + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength) + "'");
             IsValid = false;
@@ -803,8 +874,8 @@ KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
 
         if(IsValid)
         {
-            DisplaySettings->Offset.VerticalGap = ConvertStringToDouble(std::string(TokenVertical.Text, TokenVertical.TextLength));
-            DisplaySettings->Offset.HorizontalGap = ConvertStringToDouble(std::string(TokenHorizontal.Text, TokenHorizontal.TextLength));
+            DisplaySettings->Offset.VerticalGap = Vertical;
+            DisplaySettings->Offset.HorizontalGap = Horizontal;
         }
     }
     else if(TokenEquals(Token, "float"))
@@ -814,16 +885,17 @@ KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
             token Token = GetToken(Tokenizer);
             if(TokenEquals(Token, "dim"))
             {
+                double Width, Height;
                 bool IsValid = true;
                 token TokenWidth = GetToken(Tokenizer);
                 token TokenHeight = GetToken(Tokenizer);
 
-                if(TokenWidth.Type != Token_Digit)
+                if(!ConvertTokenToDouble(TokenWidth, &Width))
                 {
                     ReportInvalidCommand("Unknown float-dim width value '" + std::string(TokenWidth.Text, TokenWidth.TextLength) + "'");
                     IsValid = false;
                 }
-                if(TokenHeight.Type != Token_Digit)
+                if(!ConvertTokenToDouble(TokenHeight, &Height))
                 {
                     ReportInvalidCommand("Unknown float-dim height value '" + std::string(TokenHeight.Text, TokenHeight.TextLength) + "'");
                     IsValid = false;
@@ -831,8 +903,8 @@ KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
 
                 if(IsValid)
                 {
-                    DisplaySettings->FloatDim.width = ConvertStringToDouble(std::string(TokenWidth.Text, TokenWidth.TextLength));
-                    DisplaySettings->FloatDim.height = ConvertStringToDouble(std::string(TokenHeight.Text, TokenHeight.TextLength));
+                    DisplaySettings->FloatDim.width = Width;
+                    DisplaySettings->FloatDim.height = Height;
                 }
             }
             else
@@ -866,6 +938,8 @@ KwmParseConfigOption(tokenizer *Tokenizer)
         {
             if(TokenEquals(Token, "tiling"))
                 KwmParseConfigOptionTiling(Tokenizer);
+            else if(TokenEquals(Token, "prewarm"))
+                KwmParseConfigOptionPrewarm(Tokenizer);
             else if(TokenEquals(Token, "padding"))
                 KwmParseConfigOptionPadding(Tokenizer);
             else if(TokenEquals(Token, "gap"))
@@ -890,6 +964,8 @@ KwmParseConfigOption(tokenizer *Tokenizer)
                 KwmParseConfigOptionOptimalRatio(Tokenizer);
             else if(TokenEquals(Token, "spawn"))
                 KwmParseConfigOptionSpawn(Tokenizer);
+            else if(TokenEquals(Token, "ax"))
+                KwmParseConfigOptionAX(Tokenizer);
             else if(TokenEquals(Token, "border"))
                 KwmParseConfigOptionBorder(Tokenizer);
             else if(TokenEquals(Token, "space"))
@@ -916,6 +992,7 @@ KwmParseWindowOption(tokenizer *Tokenizer)
         token Token = GetToken(Tokenizer);
         if(TokenEquals(Token, "f"))
         {
+            uint32_t WindowID;
             token Selector = GetToken(Tokenizer);
             if(TokenEquals(Selector, "north"))
                 ShiftWindowFocusDirected(0);
@@ -931,8 +1008,8 @@ KwmParseWindowOption(tokenizer *Tokenizer)
                 ShiftWindowFocus(1);
             else if(TokenEquals(Selector, "curr"))
                 FocusWindowBelowCursor();
-            else if(Selector.Type == Token_Digit)
-                FocusWindowByID(ConvertStringToUint(std::string(Selector.Text, Selector.TextLength)));
+            else if(ConvertTokenToUint(Selector, &WindowID))
+                FocusWindowByID(WindowID);
             else
                 ReportInvalidCommand("Unknown selector '" + std::string(Selector.Text, Selector.TextLength) + "'");
         }
@@ -1034,10 +1111,10 @@ KwmParseWindowOption(tokenizer *Tokenizer)
             }
             else if(TokenEquals(Selector, "reduce") || TokenEquals(Selector, "expand"))
             {
+                double Ratio;
                 token Value = GetToken(Tokenizer);
-                if(Value.Type == Token_Digit)
+                if(ConvertTokenToDouble(Value, &Ratio))
                 {
-                    double Ratio = ConvertStringToDouble(std::string(Value.Text, Value.TextLength));
                     Ratio = TokenEquals(Selector, "reduce") ? -Ratio : Ratio;
 
                     token Direction = GetToken(Tokenizer);
@@ -1080,13 +1157,16 @@ KwmParseWindowOption(tokenizer *Tokenizer)
                 ax_window *Window = FocusedApplication ? FocusedApplication->Focus : NULL;
                 if(Window)
                 {
+                    int DisplayID;
                     token Token = GetToken(Tokenizer);
                     if(TokenEquals(Token, "prev"))
                         MoveWindowToDisplay(Window, -1, true);
                     else if(TokenEquals(Token, "next"))
                         MoveWindowToDisplay(Window, 1, true);
+                    else if(ConvertTokenToInt(Token, &DisplayID))
+                        MoveWindowToDisplay(Window, DisplayID, false);
                     else
-                        MoveWindowToDisplay(Window, ConvertStringToInt(std::string(Token.Text, Token.TextLength)), false);
+                        ReportInvalidCommand("Unknown selector '" + std::string(Token.Text, Token.TextLength) + "'");
                 }
             }
             else if(TokenEquals(Selector, "north"))
@@ -1120,22 +1200,15 @@ KwmParseWindowOption(tokenizer *Tokenizer)
             }
             else
             {
-                bool Valid = true;
+                int XOff, YOff;
                 token XToken = GetToken(Tokenizer);
                 token YToken = GetToken(Tokenizer);
 
-                if(XToken.Type != Token_Digit || YToken.Type != Token_Digit)
-                {
-                    Valid = false;
-                    ReportInvalidCommand("Expected token of type 'Token_Digit'");
-                }
-
-                if(Valid)
-                {
-                    int XOff = ConvertStringToInt(std::string(XToken.Text, XToken.TextLength));
-                    int YOff = ConvertStringToInt(std::string(YToken.Text, YToken.TextLength));
+                if(ConvertTokenToInt(XToken, &XOff) &&
+                   ConvertTokenToInt(YToken, &YOff))
                     MoveFloatingWindow(XOff, YOff);
-                }
+                else
+                    ReportInvalidCommand("Expected token of type 'Token_Digit'");
             }
         }
         else if(TokenEquals(Token, "mk"))
@@ -1218,15 +1291,19 @@ KwmParseTreeOption(tokenizer *Tokenizer)
     else if(TokenEquals(Token, "rotate"))
     {
         token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "90") || TokenEquals(Token, "270") || TokenEquals(Token, "180"))
-            RotateBSPTree(ConvertStringToInt(std::string(Token.Text, Token.TextLength)));
+        if(TokenEquals(Token, "90"))
+            RotateBSPTree(90);
+        else if(TokenEquals(Token, "180"))
+            RotateBSPTree(180);
+        else if(TokenEquals(Token, "270"))
+            RotateBSPTree(270);
         else
             ReportInvalidCommand("Unknown command 'tree rotate " + std::string(Token.Text, Token.TextLength) + "'");
     }
     else if(TokenEquals(Token, "save"))
     {
         ax_display *Display = AXLibMainDisplay();
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
         token Token = GetToken(Tokenizer);
         if(Token.Type != Token_EndOfStream)
             SaveBSPTreeToFile(Display, SpaceInfo, std::string(Token.Text, Token.TextLength));
@@ -1255,6 +1332,7 @@ KwmParseDisplayOption(tokenizer *Tokenizer)
         token Token = GetToken(Tokenizer);
         if(TokenEquals(Token, "f"))
         {
+            int DisplayID;
             token Selector = GetToken(Tokenizer);
             if(TokenEquals(Selector, "prev"))
             {
@@ -1268,9 +1346,8 @@ KwmParseDisplayOption(tokenizer *Tokenizer)
                 if(Display)
                     FocusDisplay(AXLibNextDisplay(Display));
             }
-            else if(Selector.Type == Token_Digit)
+            else if(ConvertTokenToInt(Selector, &DisplayID))
             {
-                int DisplayID = ConvertStringToInt(std::string(Selector.Text, Selector.TextLength));
                 ax_display *Display = AXLibArrangementDisplay(DisplayID);
                 if(Display)
                     FocusDisplay(Display);
@@ -1339,7 +1416,7 @@ KwmParseSpaceOption(tokenizer *Tokenizer)
                 ax_display *Display = AXLibMainDisplay();
                 if(Display)
                 {
-                    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+                    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
                     ApplyTreeNodeContainer(SpaceInfo->RootNode);
                 }
             }
@@ -1416,18 +1493,30 @@ KwmParseScratchpadOption(tokenizer *Tokenizer)
     token Token = GetToken(Tokenizer);
     if(TokenEquals(Token, "show"))
     {
+        int Slot;
         token Value = GetToken(Tokenizer);
-        ShowScratchpadWindow(ConvertStringToInt(std::string(Value.Text, Value.TextLength)));
+        if(ConvertTokenToInt(Value, &Slot))
+            ShowScratchpadWindow(Slot);
+        else
+            ReportInvalidCommand("Unknown scratchpad slot '" + std::string(Value.Text, Value.TextLength) + "'");
     }
     else if(TokenEquals(Token, "hide"))
     {
+        int Slot;
         token Value = GetToken(Tokenizer);
-        HideScratchpadWindow(ConvertStringToInt(std::string(Value.Text, Value.TextLength)));
+        if(ConvertTokenToInt(Value, &Slot))
+            HideScratchpadWindow(Slot);
+        else
+            ReportInvalidCommand("Unknown scratchpad slot '" + std::string(Value.Text, Value.TextLength) + "'");
     }
     else if(TokenEquals(Token, "toggle"))
     {
+        int Slot;
         token Value = GetToken(Tokenizer);
-        ToggleScratchpadWindow(ConvertStringToInt(std::string(Value.Text, Value.TextLength)));
+        if(ConvertTokenToInt(Value, &Slot))
+            ToggleScratchpadWindow(Slot);
+        else
+            ReportInvalidCommand("Unknown scratchpad slot '" + std::string(Value.Text, Value.TextLength) + "'");
     }
     else if(TokenEquals(Token, "add"))
     {
@@ -1455,18 +1544,18 @@ KwmParseQueryOption(tokenizer *Tokenizer)
     {
         token Selector = GetToken(Tokenizer);
         if(TokenEquals(Selector, "mode"))
-            KwmConstructEvent(KWMEvent_QueryTilingMode, KwmCreateContext(ClientSockFD));
+            KwmConstructQueryEvent(KWMEvent_QueryTilingMode, KwmCreateContext(ClientSockFD));
         else if(TokenEquals(Selector,"spawn"))
-            KwmConstructEvent(KWMEvent_QuerySpawnPosition, KwmCreateContext(ClientSockFD));
+            KwmConstructQueryEvent(KWMEvent_QuerySpawnPosition, KwmCreateContext(ClientSockFD));
         else if(TokenEquals(Selector, "split"))
         {
             if(RequireToken(Tokenizer, Token_Dash))
             {
                 token Token = GetToken(Tokenizer);
                 if(TokenEquals(Token, "mode"))
-                    KwmConstructEvent(KWMEvent_QuerySplitMode, KwmCreateContext(ClientSockFD));
+                    KwmConstructQueryEvent(KWMEvent_QuerySplitMode, KwmCreateContext(ClientSockFD));
                 else if(TokenEquals(Token, "ratio"))
-                    KwmConstructEvent(KWMEvent_QuerySplitRatio, KwmCreateContext(ClientSockFD));
+                    KwmConstructQueryEvent(KWMEvent_QuerySplitRatio, KwmCreateContext(ClientSockFD));
                 else
                     ReportInvalidCommand("Unknown command 'query split-" + std::string(Token.Text, Token.TextLength) + "'");
             }
@@ -1487,13 +1576,13 @@ KwmParseQueryOption(tokenizer *Tokenizer)
         {
             token Token = GetToken(Tokenizer);
             if(TokenEquals(Token, "id"))
-                KwmConstructEvent(KWMEvent_QueryFocusedWindowId, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryFocusedWindowId, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "name"))
-                KwmConstructEvent(KWMEvent_QueryFocusedWindowName, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryFocusedWindowName, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "split"))
-                KwmConstructEvent(KWMEvent_QueryFocusedWindowSplit, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryFocusedWindowSplit, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "float"))
-                KwmConstructEvent(KWMEvent_QueryFocusedWindowFloat, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryFocusedWindowFloat, KwmCreateContext(ClientSockFD));
             else
             {
                 int *Args = (int *) malloc(sizeof(int) * 2);
@@ -1510,64 +1599,61 @@ KwmParseQueryOption(tokenizer *Tokenizer)
                 else
                     *(Args + 1) = 0;
 
-                KwmConstructEvent(KWMEvent_QueryWindowIdInDirectionOfFocusedWindow, Args);
+                KwmConstructQueryEvent(KWMEvent_QueryWindowIdInDirectionOfFocusedWindow, Args);
             }
         }
         else if(TokenEquals(Token, "marked"))
         {
             token Token = GetToken(Tokenizer);
             if(TokenEquals(Token, "id"))
-                KwmConstructEvent(KWMEvent_QueryMarkedWindowId, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryMarkedWindowId, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "name"))
-                KwmConstructEvent(KWMEvent_QueryMarkedWindowName, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryMarkedWindowName, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "split"))
-                KwmConstructEvent(KWMEvent_QueryMarkedWindowSplit, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryMarkedWindowSplit, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "float"))
-                KwmConstructEvent(KWMEvent_QueryMarkedWindowFloat, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryMarkedWindowFloat, KwmCreateContext(ClientSockFD));
             else
                 ReportInvalidCommand("Unknown command 'query window marked " + std::string(Token.Text, Token.TextLength) + "'");
         }
         else if(TokenEquals(Token, "parent"))
         {
-            bool Valid = true;
+            int FirstID, SecondID;
             token Token1 = GetToken(Tokenizer);
             token Token2 = GetToken(Tokenizer);
-            if(Token1.Type != Token_Digit || Token2.Type != Token_Digit)
-            {
-                Valid = false;
-                ReportInvalidCommand("Expected token of type 'Token_Digit'");
-            }
-
-            if(Valid)
+            if(ConvertTokenToInt(Token1, &FirstID) &&
+               ConvertTokenToInt(Token2, &SecondID))
             {
                 int *Args = (int *) malloc(sizeof(int) * 3);
                 *Args = ClientSockFD;
-                *(Args + 1) = ConvertStringToInt(std::string(Token1.Text, Token1.TextLength));
-                *(Args + 2) = ConvertStringToInt(std::string(Token2.Text, Token2.TextLength));
-                KwmConstructEvent(KWMEvent_QueryParentNodeState, Args);
+                *(Args + 1) = FirstID;
+                *(Args + 2) = SecondID;
+                KwmConstructQueryEvent(KWMEvent_QueryParentNodeState, Args);
+            }
+            else
+            {
+                ReportInvalidCommand("Expected token of type 'Token_Digit'");
             }
         }
         else if(TokenEquals(Token, "child"))
         {
-            bool Valid = true;
+            int WindowID;
             token Token = GetToken(Tokenizer);
-            if(Token.Type != Token_Digit)
-            {
-                Valid = false;
-                ReportInvalidCommand("Expected token of type 'Token_Digit'");
-            }
-
-            if(Valid)
+            if(ConvertTokenToInt(Token, &WindowID))
             {
                 int *Args = (int *) malloc(sizeof(int) * 2);
                 *Args = ClientSockFD;
-                *(Args + 1) = ConvertStringToInt(std::string(Token.Text, Token.TextLength));
-                KwmConstructEvent(KWMEvent_QueryNodePosition, Args);
+                *(Args + 1) = WindowID;
+                KwmConstructQueryEvent(KWMEvent_QueryNodePosition, Args);
+            }
+            else
+            {
+                ReportInvalidCommand("Expected token of type 'Token_Digit'");
             }
         }
         else if(TokenEquals(Token, "list"))
         {
-            KwmConstructEvent(KWMEvent_QueryWindowList, KwmCreateContext(ClientSockFD));
+            KwmConstructQueryEvent(KWMEvent_QueryWindowList, KwmCreateContext(ClientSockFD));
         }
         else
         {
@@ -1580,7 +1666,7 @@ KwmParseQueryOption(tokenizer *Tokenizer)
         {
             token Token = GetToken(Tokenizer);
             if(TokenEquals(Token, "focus"))
-                KwmConstructEvent(KWMEvent_QueryCycleFocus, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryCycleFocus, KwmCreateContext(ClientSockFD));
             else
                 ReportInvalidCommand("Unknown command 'query cycle-" + std::string(Token.Text, Token.TextLength) + "'");
         }
@@ -1600,7 +1686,7 @@ KwmParseQueryOption(tokenizer *Tokenizer)
                 {
                     token Token = GetToken(Tokenizer);
                     if(TokenEquals(Token, "resizable"))
-                        KwmConstructEvent(KWMEvent_QueryFloatNonResizable, KwmCreateContext(ClientSockFD));
+                        KwmConstructQueryEvent(KWMEvent_QueryFloatNonResizable, KwmCreateContext(ClientSockFD));
                     else
                         ReportInvalidCommand("Unknown command 'query float-non-" + std::string(Token.Text, Token.TextLength) + "'");
                 }
@@ -1630,7 +1716,7 @@ KwmParseQueryOption(tokenizer *Tokenizer)
                 {
                     token Token = GetToken(Tokenizer);
                     if(TokenEquals(Token, "container"))
-                        KwmConstructEvent(KWMEvent_QueryLockToContainer, KwmCreateContext(ClientSockFD));
+                        KwmConstructQueryEvent(KWMEvent_QueryLockToContainer, KwmCreateContext(ClientSockFD));
                     else
                         ReportInvalidCommand("Unknown command 'query lock-to-" + std::string(Token.Text, Token.TextLength) + "'");
                 }
@@ -1660,7 +1746,7 @@ KwmParseQueryOption(tokenizer *Tokenizer)
                 {
                     token Token = GetToken(Tokenizer);
                     if(TokenEquals(Token, "float"))
-                        KwmConstructEvent(KWMEvent_QueryStandbyOnFloat, KwmCreateContext(ClientSockFD));
+                        KwmConstructQueryEvent(KWMEvent_QueryStandbyOnFloat, KwmCreateContext(ClientSockFD));
                     else
                         ReportInvalidCommand("Unknown command 'query standby-on-" + std::string(Token.Text, Token.TextLength) + "'");
                 }
@@ -1690,7 +1776,7 @@ KwmParseQueryOption(tokenizer *Tokenizer)
                 {
                     token Token = GetToken(Tokenizer);
                     if(TokenEquals(Token, "mouse"))
-                        KwmConstructEvent(KWMEvent_QueryFocusFollowsMouse, KwmCreateContext(ClientSockFD));
+                        KwmConstructQueryEvent(KWMEvent_QueryFocusFollowsMouse, KwmCreateContext(ClientSockFD));
                     else
                         ReportInvalidCommand("Unknown command 'query focus-follows-" + std::string(Token.Text, Token.TextLength) + "'");
                 }
@@ -1720,7 +1806,7 @@ KwmParseQueryOption(tokenizer *Tokenizer)
                 {
                     token Token = GetToken(Tokenizer);
                     if(TokenEquals(Token, "focus"))
-                        KwmConstructEvent(KWMEvent_QueryMouseFollowsFocus, KwmCreateContext(ClientSockFD));
+                        KwmConstructQueryEvent(KWMEvent_QueryMouseFollowsFocus, KwmCreateContext(ClientSockFD));
                     else
                         ReportInvalidCommand("Unknown command 'query mouse-follows-" + std::string(Token.Text, Token.TextLength) + "'");
                 }
@@ -1744,7 +1830,7 @@ KwmParseQueryOption(tokenizer *Tokenizer)
         token Token = GetToken(Tokenizer);
         if(TokenEquals(Token, "list"))
         {
-            KwmConstructEvent(KWMEvent_QueryScratchpad, KwmCreateContext(ClientSockFD));
+            KwmConstructQueryEvent(KWMEvent_QueryScratchpad, KwmCreateContext(ClientSockFD));
         }
         else
         {
@@ -1758,13 +1844,13 @@ KwmParseQueryOption(tokenizer *Tokenizer)
         {
             token Token = GetToken(Tokenizer);
             if(TokenEquals(Token, "tag"))
-                KwmConstructEvent(KWMEvent_QueryCurrentSpaceTag, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryCurrentSpaceTag, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "name"))
-                KwmConstructEvent(KWMEvent_QueryCurrentSpaceName, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryCurrentSpaceName, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "id"))
-                KwmConstructEvent(KWMEvent_QueryCurrentSpaceId, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryCurrentSpaceId, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "mode"))
-                KwmConstructEvent(KWMEvent_QueryCurrentSpaceMode, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryCurrentSpaceMode, KwmCreateContext(ClientSockFD));
             else
                 ReportInvalidCommand("Unknown command 'query space active " + std::string(Token.Text, Token.TextLength) + "'");
         }
@@ -1772,15 +1858,15 @@ KwmParseQueryOption(tokenizer *Tokenizer)
         {
             token Token = GetToken(Tokenizer);
             if(TokenEquals(Token, "name"))
-                KwmConstructEvent(KWMEvent_QueryPreviousSpaceName, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryPreviousSpaceName, KwmCreateContext(ClientSockFD));
             else if(TokenEquals(Token, "id"))
-                KwmConstructEvent(KWMEvent_QueryPreviousSpaceId, KwmCreateContext(ClientSockFD));
+                KwmConstructQueryEvent(KWMEvent_QueryPreviousSpaceId, KwmCreateContext(ClientSockFD));
             else
                 ReportInvalidCommand("Unknown command 'query space previous " + std::string(Token.Text, Token.TextLength) + "'");
         }
         else if(TokenEquals(Token, "list"))
         {
-            KwmConstructEvent(KWMEvent_QuerySpaces, KwmCreateContext(ClientSockFD));
+            KwmConstructQueryEvent(KWMEvent_QuerySpaces, KwmCreateContext(ClientSockFD));
         }
         else
         {
@@ -1791,21 +1877,51 @@ KwmParseQueryOption(tokenizer *Tokenizer)
     {
         token Token = GetToken(Tokenizer);
         if(TokenEquals(Token, "focused"))
-            KwmConstructEvent(KWMEvent_QueryFocusedBorder, KwmCreateContext(ClientSockFD));
+            KwmConstructQueryEvent(KWMEvent_QueryFocusedBorder, KwmCreateContext(ClientSockFD));
         else if(TokenEquals(Token, "marked"))
-            KwmConstructEvent(KWMEvent_QueryMarkedBorder, KwmCreateContext(ClientSockFD));
+            KwmConstructQueryEvent(KWMEvent_QueryMarkedBorder, KwmCreateContext(ClientSockFD));
         else
             ReportInvalidCommand("Unknown command 'query border " + std::string(Token.Text, Token.TextLength) + "'");
     }
+    else if(TokenEquals(Token, "events"))
+    {
+        /* NOTE: The event-loop stats are thread-safe to read, and are not part of the
+                 snapshot, so that they also report on a stalled event-loop. */
+        KwmWriteToSocket(KwmQueryEventLoopStats(), ClientSockFD);
+        ClientSockFD = INVALID_SOCKFD;
+    }
+    else if(TokenEquals(Token, "ax"))
+    {
+        /* NOTE: Like the event-loop stats, these are read directly so that a hung
+                 application is visible even while the event-loop is busy. */
+        KwmWriteToSocket(KwmQueryApplicationLatency(), ClientSockFD);
+        ClientSockFD = INVALID_SOCKFD;
+    }
+    else if(TokenEquals(Token, "startup"))
+    {
+        KwmWriteToSocket(KwmQueryStartupStats(), ClientSockFD);
+        ClientSockFD = INVALID_SOCKFD;
+    }
     else
     {
         ReportInvalidCommand("Unknown command 'query " + std::string(Token.Text, Token.TextLength) + "'");
-        shutdown(ClientSockFD, SHUT_RDWR);
-        close(ClientSockFD);
     }
 }
 
-void KwmParseKwmc(tokenizer *Tokenizer, int SockFD)
+/* NOTE: The command that starts at Command and runs to the end of the line, as a view into the
+         buffer of the tokenizer. */
+internal token
+GetCommandTilEndOfLine(token Command, tokenizer *Tokenizer)
+{
+    token Line = GetTokenTilEndOfLine(Tokenizer);
+    Command.Type = Token_String;
+    Command.TextLength = (Line.Text + Line.TextLength) - Command.Text;
+    return Command;
+}
+
+/* NOTE: Returns true if the caller still owns the client socket, i.e. no error has been
+         reported through it and it was not handed over to a query event. */
+bool KwmParseKwmc(tokenizer *Tokenizer, int SockFD)
 {
     ClientSockFD = SockFD;
     token Token = GetToken(Tokenizer);
@@ -1813,7 +1929,6 @@ void KwmParseKwmc(tokenizer *Tokenizer, int SockFD)
     {
         case Token_EndOfStream:
         {
-            return;
         } break;
         case Token_Identifier:
         {
@@ -1834,11 +1949,12 @@ void KwmParseKwmc(tokenizer *Tokenizer, int SockFD)
             else if(TokenEquals(Token, "bindsym") ||
                     TokenEquals(Token, "bindcode") ||
                     TokenEquals(Token, "bindsym_passthrough") ||
-                    TokenEquals(Token, "bindcode_passthrough") ||
-                    TokenEquals(Token, "rule"))
-                KwmInterpretCommand(std::string(Token.Text, Token.TextLength) + " " + GetTextTilEndOfLine(Tokenizer), INVALID_SOCKFD);
+                    TokenEquals(Token, "bindcode_passthrough"))
+                KwmInterpretCommand(GetCommandTilEndOfLine(Token, Tokenizer), INVALID_SOCKFD);
+            else if(TokenEquals(Token, "rule"))
+                KwmAddRule(TrimToken(GetTokenTilEndOfLine(Tokenizer)));
             else if(TokenEquals(Token, "whitelist"))
-                KwmInterpretCommand(std::string(Token.Text, Token.TextLength) + " " + GetTextTilEndOfLine(Tokenizer), INVALID_SOCKFD);
+                KwmInterpretCommand(GetCommandTilEndOfLine(Token, Tokenizer), INVALID_SOCKFD);
             else
                 ReportInvalidCommand("Unknown token '" + std::string(Token.Text, Token.TextLength) + "'");
         } break;
@@ -1847,6 +1963,10 @@ void KwmParseKwmc(tokenizer *Tokenizer, int SockFD)
             ReportInvalidCommand("Unknown token '" + std::string(Token.Text, Token.TextLength) + "'");
         } break;
     }
+
+    bool Result = ClientSockFD != INVALID_SOCKFD;
+    ClientSockFD = INVALID_SOCKFD;
+    return Result;
 }
 
 internal void
@@ -1917,6 +2037,8 @@ KwmPreprocessConfig(std::string &Text)
 /* NOTE(koekeishiya): The passed string has to include the absolute path to the file. */
 void KwmParseConfig(std::string File)
 {
+    /* NOTE: A reload may be requested by a client, whose socket must survive the parse. */
+    int SockFD = ClientSockFD;
     ClientSockFD = INVALID_SOCKFD;
     tokenizer Tokenizer = {};
     char *FileContents = ReadFile(File);
@@ -1971,6 +2093,8 @@ void KwmParseConfig(std::string File)
             }
         }
     }
+
+    ClientSockFD = SockFD;
 }
 
 internal void
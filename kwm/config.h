@@ -4,7 +4,7 @@
 #include "tokenizer.h"
 #include <string>
 
-void KwmParseKwmc(tokenizer *Tokenizer, int ClientSockFD);
+bool KwmParseKwmc(tokenizer *Tokenizer, int ClientSockFD);
 void KwmParseConfig(std::string File);
 void KwmReloadConfig();
 
@@ -4,68 +4,65 @@
 
 #define internal static
 
-extern std::map<std::string, space_info> WindowTree;
 extern kwm_settings KWMSettings;
 
+/* NOTE: The gap arguments are already halved, the caller reads them once per space.
+         These are the reference for SplitNodeContainers(..), used by CreateNodeContainers. */
 internal node_container
-LeftVerticalContainerSplit(ax_display *Display, tree_node *Node)
+LeftVerticalContainerSplit(tree_node *Node, double Gap)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
     node_container LeftContainer;
 
     LeftContainer.X = Node->Container.X;
     LeftContainer.Y = Node->Container.Y;
-    LeftContainer.Width = (Node->Container.Width * Node->SplitRatio) - (SpaceInfo->Settings.Offset.VerticalGap / 2);
+    LeftContainer.Width = (Node->Container.Width * Node->SplitRatio) - Gap;
     LeftContainer.Height = Node->Container.Height;
 
     return LeftContainer;
 }
 
 internal node_container
-RightVerticalContainerSplit(ax_display *Display, tree_node *Node)
+RightVerticalContainerSplit(tree_node *Node, double Gap)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
     node_container RightContainer;
 
-    RightContainer.X = Node->Container.X + (Node->Container.Width * Node->SplitRatio) + (SpaceInfo->Settings.Offset.VerticalGap / 2);
+    RightContainer.X = Node->Container.X + (Node->Container.Width * Node->SplitRatio) + Gap;
     RightContainer.Y = Node->Container.Y;
-    RightContainer.Width = (Node->Container.Width * (1 - Node->SplitRatio)) - (SpaceInfo->Settings.Offset.VerticalGap / 2);
+    RightContainer.Width = (Node->Container.Width * (1 - Node->SplitRatio)) - Gap;
     RightContainer.Height = Node->Container.Height;
 
     return RightContainer;
 }
 
 internal node_container
-UpperHorizontalContainerSplit(ax_display *Display, tree_node *Node)
+UpperHorizontalContainerSplit(tree_node *Node, double Gap)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
     node_container UpperContainer;
 
     UpperContainer.X = Node->Container.X;
     UpperContainer.Y = Node->Container.Y;
     UpperContainer.Width = Node->Container.Width;
-    UpperContainer.Height = (Node->Container.Height * Node->SplitRatio) - (SpaceInfo->Settings.Offset.HorizontalGap / 2);
+    UpperContainer.Height = (Node->Container.Height * Node->SplitRatio) - Gap;
 
     return UpperContainer;
 }
 
 internal node_container
-LowerHorizontalContainerSplit(ax_display *Display, tree_node *Node)
+LowerHorizontalContainerSplit(tree_node *Node, double Gap)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
     node_container LowerContainer;
 
     LowerContainer.X = Node->Container.X;
-    LowerContainer.Y = Node->Container.Y + (Node->Container.Height * Node->SplitRatio) + (SpaceInfo->Settings.Offset.HorizontalGap / 2);
+    LowerContainer.Y = Node->Container.Y + (Node->Container.Height * Node->SplitRatio) + Gap;
     LowerContainer.Width = Node->Container.Width;
-    LowerContainer.Height = (Node->Container.Height * (1 - Node->SplitRatio)) - (SpaceInfo->Settings.Offset.HorizontalGap / 2);
+    LowerContainer.Height = (Node->Container.Height * (1 - Node->SplitRatio)) - Gap;
 
     return LowerContainer;
 }
 
 void SetRootNodeContainer(ax_display *Display, tree_node *Node)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     Node->Container.X = Display->Frame.origin.x + SpaceInfo->Settings.Offset.PaddingLeft;
     Node->Container.Y = Display->Frame.origin.y + SpaceInfo->Settings.Offset.PaddingTop;
@@ -78,7 +75,7 @@ void SetRootNodeContainer(ax_display *Display, tree_node *Node)
 
 void SetLinkNodeContainer(ax_display *Display, link_node *Link)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     Link->Container.X = Display->Frame.origin.x + SpaceInfo->Settings.Offset.PaddingLeft;
     Link->Container.Y = Display->Frame.origin.y + SpaceInfo->Settings.Offset.PaddingTop;
@@ -88,6 +85,10 @@ void SetLinkNodeContainer(ax_display *Display, link_node *Link)
 
 void CreateNodeContainer(ax_display *Display, tree_node *Node, container_type Type)
 {
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
+    double VerticalGap = SpaceInfo->Settings.Offset.VerticalGap / 2;
+    double HorizontalGap = SpaceInfo->Settings.Offset.HorizontalGap / 2;
+
     if(Node->SplitRatio == 0)
         Node->SplitRatio = KWMSettings.SplitRatio;
 
@@ -95,19 +96,19 @@ void CreateNodeContainer(ax_display *Display, tree_node *Node, container_type Ty
     {
         case CONTAINER_LEFT:
         {
-            Node->Container = LeftVerticalContainerSplit(Display, Node->Parent);
+            Node->Container = LeftVerticalContainerSplit(Node->Parent, VerticalGap);
         } break;
         case CONTAINER_RIGHT:
         {
-            Node->Container = RightVerticalContainerSplit(Display, Node->Parent);
+            Node->Container = RightVerticalContainerSplit(Node->Parent, VerticalGap);
         } break;
         case CONTAINER_UPPER:
         {
-            Node->Container = UpperHorizontalContainerSplit(Display, Node->Parent);
+            Node->Container = UpperHorizontalContainerSplit(Node->Parent, HorizontalGap);
         } break;
         case CONTAINER_LOWER:
         {
-            Node->Container = LowerHorizontalContainerSplit(Display, Node->Parent);
+            Node->Container = LowerHorizontalContainerSplit(Node->Parent, HorizontalGap);
         } break;
         default: { /* NOTE(koekeishiya): No container specified. */} break;
     }
@@ -165,15 +166,50 @@ void ResizeLinkNodeContainers(tree_node *Root)
     }
 }
 
+#ifdef DEBUG_BUILD
+internal bool
+IsSameContainer(node_container A, node_container B)
+{
+    return A.X == B.X && A.Y == B.Y && A.Width == B.Width && A.Height == B.Height;
+}
+
+/* NOTE: Checks SplitNodeContainers(..) against the scalar reference. */
+internal void
+AssertNodeContainers(tree_node *Node, double VerticalGap, double HorizontalGap)
+{
+    if(!Node->LeftChild || !Node->RightChild)
+        return;
+
+    if(Node->SplitMode == SPLIT_VERTICAL)
+    {
+        Assert(IsSameContainer(Node->LeftChild->Container, LeftVerticalContainerSplit(Node, VerticalGap)));
+        Assert(IsSameContainer(Node->RightChild->Container, RightVerticalContainerSplit(Node, VerticalGap)));
+    }
+    else
+    {
+        Assert(IsSameContainer(Node->LeftChild->Container, UpperHorizontalContainerSplit(Node, HorizontalGap)));
+        Assert(IsSameContainer(Node->RightChild->Container, LowerHorizontalContainerSplit(Node, HorizontalGap)));
+    }
+
+    AssertNodeContainers(Node->LeftChild, VerticalGap, HorizontalGap);
+    AssertNodeContainers(Node->RightChild, VerticalGap, HorizontalGap);
+}
+#endif
+
+/* NOTE: Same result as calling CreateNodeContainerPair(..) on every split node,
+         top-down, with the gaps read once per space rather than once per container. */
 void CreateNodeContainers(ax_display *Display, tree_node *Node, bool OptimalSplit)
 {
     if(Node && Node->LeftChild && Node->RightChild)
     {
-        Node->SplitMode = OptimalSplit ? GetOptimalSplitMode(Node) : Node->SplitMode;
-        CreateNodeContainerPair(Display, Node->LeftChild, Node->RightChild, Node->SplitMode);
-
-        CreateNodeContainers(Display, Node->LeftChild, OptimalSplit);
-        CreateNodeContainers(Display, Node->RightChild, OptimalSplit);
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
+        double VerticalGap = SpaceInfo->Settings.Offset.VerticalGap / 2;
+        double HorizontalGap = SpaceInfo->Settings.Offset.HorizontalGap / 2;
+
+        SplitNodeContainers(Node, VerticalGap, HorizontalGap, OptimalSplit);
+#ifdef DEBUG_BUILD
+        AssertNodeContainers(Node, VerticalGap, HorizontalGap);
+#endif
     }
 }
 
@@ -13,4 +13,6 @@ void ResizeLinkNodeContainers(tree_node *Root);
 void CreateNodeContainers(ax_display *Display, tree_node *Node, bool OptimalSplit);
 void CreateDeserializedNodeContainer(ax_display *Display, tree_node *Node);
 
+void SplitNodeContainers(tree_node *Node, double VerticalGap, double HorizontalGap, bool OptimalSplit);
+
 #endif
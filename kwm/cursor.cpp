@@ -4,6 +4,7 @@
 #include "tree.h"
 #include "space.h"
 #include "border.h"
+#include "query.h"
 #include "../axlib/axlib.h"
 #include "display.h"
 #include "helpers.h"
@@ -11,7 +12,6 @@
 #define internal static
 #define local_persist static
 
-extern std::map<std::string, space_info> WindowTree;
 extern ax_application *FocusedApplication;
 extern kwm_settings KWMSettings;
 extern kwm_border MarkedBorder;
@@ -30,12 +30,30 @@ struct resize_indicator_border
     tree_node *Node;
 };
 
+/* NOTE: Geometry changes made while dragging are committed at most once per interval, which is the
+         refresh interval of the display unless a rate is configured. Only the latest cursor position
+         is kept. A position that arrives too early is committed by a trailing AXEvent_MouseDragCommit
+         at the end of the interval, so the drag catches up when the cursor stops moving; mouse-up
+         always commits it. */
+#define KWM_DRAG_DEFAULT_RATE 60.0
+
+struct drag_commit_state
+{
+    uint64_t Interval;
+    uint64_t NextCommit;
+    uint32_t Generation;
+    bool Pending;
+    bool Trailing;
+    CGPoint Cursor;
+};
+
 internal bool DragMoveWindow = false;
 internal bool DragResizeNode = false;
 internal tree_node *MarkedNode = NULL;
 
 internal std::vector<resize_indicator_border> ResizeIndicatorBorders;
 internal resize_state_struct ResizeState = {};
+internal drag_commit_state DragCommit = {};
 
 internal inline CGPoint
 GetCursorPos()
@@ -67,6 +85,113 @@ ClearMarkedNode()
     ClearBorder(&MarkedBorder);
 }
 
+internal uint64_t
+GetDragCommitInterval(ax_display *Display)
+{
+    double Rate = KWMSettings.DragRate;
+    if((Rate <= 0) && (Display))
+    {
+        CGDisplayModeRef Mode = CGDisplayCopyDisplayMode(Display->ID);
+        if(Mode)
+        {
+            Rate = CGDisplayModeGetRefreshRate(Mode);
+            CGDisplayModeRelease(Mode);
+        }
+    }
+
+    /* NOTE: Built-in panels report a refresh rate of 0. */
+    if(Rate <= 0)
+        Rate = KWM_DRAG_DEFAULT_RATE;
+
+    return (1000.0 * 1000.0 * 1000.0) / Rate;
+}
+
+internal inline void
+BeginDragCommits(ax_display *Display)
+{
+    DragCommit.Interval = GetDragCommitInterval(Display);
+    DragCommit.NextCommit = 0;
+    DragCommit.Pending = false;
+    DragCommit.Trailing = false;
+    ++DragCommit.Generation;
+}
+
+/* NOTE: Cancels the trailing commit of the drag, if one is scheduled. */
+internal inline void
+EndDragCommits()
+{
+    DragCommit.Pending = false;
+    DragCommit.Trailing = false;
+    ++DragCommit.Generation;
+}
+
+/* NOTE: The timer only posts an event, the commit itself is made on the event-loop thread. An event
+         of a drag that has since ended carries an old generation, and is ignored. */
+internal void
+ScheduleTrailingDragCommit(uint64_t Delay)
+{
+    if(DragCommit.Trailing)
+        return;
+
+    DragCommit.Trailing = true;
+    uint32_t Generation = DragCommit.Generation;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, Delay), dispatch_get_main_queue(),
+    ^{
+        uint32_t *DragGeneration = (uint32_t *) malloc(sizeof(uint32_t));
+        *DragGeneration = Generation;
+        AXLibConstructEvent(AXEvent_MouseDragCommit, DragGeneration, false);
+    });
+}
+
+/* NOTE: Records the cursor position of a drag event, and returns true if the interval has passed
+         since the last commit. Otherwise the position stays pending, and is replaced by the next
+         event or committed by the trailing commit. */
+internal inline bool
+UpdateDragCommit(CGPoint *Cursor)
+{
+    DragCommit.Cursor = *Cursor;
+    DragCommit.Pending = true;
+
+    uint64_t Now = AXLibCurrentTime();
+    if(Now < DragCommit.NextCommit)
+    {
+        ScheduleTrailingDragCommit(DragCommit.NextCommit - Now);
+        return false;
+    }
+
+    DragCommit.NextCommit = Now + DragCommit.Interval;
+    return true;
+}
+
+internal void
+CommitDragMoveWindow(ax_window *Window)
+{
+    DragCommit.Pending = false;
+    if(AXLibHasFlags(Window, AXWindow_Floating))
+    {
+        double X = DragCommit.Cursor.x - Window->Size.width / 2;
+        double Y = DragCommit.Cursor.y - Window->Size.height / 2;
+        AXLibMoveWindow(Window, X, Y);
+    }
+    else
+    {
+        ax_display *CursorDisplay = AXLibCursorDisplay();
+        ax_display *WindowDisplay = AXLibWindowDisplay(Window);
+        tree_node *NewNode;
+
+        if(WindowDisplay != CursorDisplay)
+            NewNode = GetSpaceInfo(CursorDisplay->Space)->RootNode;
+        else
+            NewNode = GetTreeNodeForPoint(GetSpaceInfo(WindowDisplay->Space)->RootNode, &DragCommit.Cursor);
+
+        if(NewNode && NewNode != MarkedNode)
+        {
+            MarkedNode = NewNode;
+            UpdateBorder(&MarkedBorder, MarkedNode);
+        }
+    }
+}
+
 EVENT_CALLBACK(Callback_AXEvent_MouseMoved)
 {
     FocusWindowBelowCursor();
@@ -74,6 +199,7 @@ EVENT_CALLBACK(Callback_AXEvent_MouseMoved)
 
 EVENT_CALLBACK(Callback_AXEvent_LeftMouseDown)
 {
+    KwmInvalidateSnapshot(Snapshot_Marked | Snapshot_Layout);
     if((FocusedApplication && FocusedApplication->Focus) &&
        (IsCursorInsideRect(FocusedApplication->Focus->Position.x,
                            FocusedApplication->Focus->Position.y,
@@ -82,11 +208,13 @@ EVENT_CALLBACK(Callback_AXEvent_LeftMouseDown)
     {
         DEBUG("AXEvent_LeftMouseDown");
         DragMoveWindow = true;
+        BeginDragCommits(AXLibWindowDisplay(FocusedApplication->Focus));
     }
 }
 
 EVENT_CALLBACK(Callback_AXEvent_LeftMouseUp)
 {
+    KwmInvalidateSnapshot(Snapshot_Marked | Snapshot_Layout);
     if(DragMoveWindow)
     {
         DEBUG("AXEvent_LeftMouseUp");
@@ -97,6 +225,11 @@ EVENT_CALLBACK(Callback_AXEvent_LeftMouseUp)
          * and its Focus can never be NULL here. */
 
         ax_window *Window = FocusedApplication->Focus;
+        if(DragCommit.Pending)
+            CommitDragMoveWindow(Window);
+
+        EndDragCommits();
+
         ax_display *WindowDisplay = AXLibWindowDisplay(Window);
         ax_display *CursorDisplay = AXLibCursorDisplay();
 
@@ -108,7 +241,7 @@ EVENT_CALLBACK(Callback_AXEvent_LeftMouseUp)
         {
             if(MarkedNode && MarkedNode->WindowID != Window->ID)
             {
-                tree_node *Node = GetTreeNodeFromWindowIDOrLinkNode(WindowTree[WindowDisplay->Space->Identifier].RootNode, Window->ID);
+                tree_node *Node = GetTreeNodeFromWindowIDOrLinkNode(GetSpaceInfo(WindowDisplay->Space)->RootNode, Window->ID);
                 if(Node)
                 {
                     SwapNodeWindowIDs(Node, MarkedNode);
@@ -132,30 +265,8 @@ EVENT_CALLBACK(Callback_AXEvent_LeftMouseDragged)
          * was triggered on top of a window. Thus, we assume that the FocusedApplication
          * and its Focus can never be NULL here. */
 
-        ax_window *Window = FocusedApplication->Focus;
-        if(AXLibHasFlags(Window, AXWindow_Floating))
-        {
-            double X = Cursor->x - Window->Size.width / 2;
-            double Y = Cursor->y - Window->Size.height / 2;
-            AXLibSetWindowPosition(Window->Ref, X, Y);
-        }
-        else
-        {
-            ax_display *CursorDisplay = AXLibCursorDisplay();
-            ax_display *WindowDisplay = AXLibWindowDisplay(Window);
-            tree_node *NewNode;
-
-            if(WindowDisplay != CursorDisplay)
-                NewNode = WindowTree[CursorDisplay->Space->Identifier].RootNode;
-            else
-                NewNode = GetTreeNodeForPoint(WindowTree[WindowDisplay->Space->Identifier].RootNode, Cursor);
-
-            if(NewNode && NewNode != MarkedNode)
-            {
-                MarkedNode = NewNode;
-                UpdateBorder(&MarkedBorder, MarkedNode);
-            }
-        }
+        if(UpdateDragCommit(Cursor))
+            CommitDragMoveWindow(FocusedApplication->Focus);
     }
 
     free(Cursor);
@@ -165,7 +276,7 @@ internal resize_indicator_border
 InitializeResizedNodeBorder(tree_node *Node)
 {
     DEBUG("Making resize border");
-    kwm_border *Border = (kwm_border *) malloc(sizeof(*Border));
+    kwm_border *Border = (kwm_border *) calloc(1, sizeof(*Border));
     Border->Type = BORDER_MARKED;
     Border->BorderId = 0;
     Border->Enabled = true;
@@ -202,6 +313,33 @@ UpdateResizedNodeBorders()
     }
 }
 
+internal void
+CommitResizeState()
+{
+    local_persist const double SplitRatioMinDifference = 0.002;
+    DragCommit.Pending = false;
+
+    if(ResizeState.VerticalAncestor)
+    {
+        double ContainerTop = ResizeState.VerticalAncestor->Container.Y;
+        double ContainerHeight = ResizeState.VerticalAncestor->Container.Height;
+        double SplitRatio = (DragCommit.Cursor.y - ContainerTop) / ContainerHeight;
+        if(fabs(SplitRatio - ResizeState.VerticalAncestor->SplitRatio) > SplitRatioMinDifference)
+            SetContainerSplitRatio(SplitRatio, ResizeState.Node, ResizeState.VerticalAncestor, ResizeState.Display, false);
+    }
+
+    if(ResizeState.HorizontalAncestor)
+    {
+        double ContainerLeft = ResizeState.HorizontalAncestor->Container.X;
+        double ContainerWidth = ResizeState.HorizontalAncestor->Container.Width;
+        double SplitRatio = (DragCommit.Cursor.x - ContainerLeft) / ContainerWidth;
+        if(fabs(SplitRatio - ResizeState.HorizontalAncestor->SplitRatio) > SplitRatioMinDifference)
+            SetContainerSplitRatio(SplitRatio, ResizeState.Node, ResizeState.HorizontalAncestor, ResizeState.Display, false);
+    }
+
+    UpdateResizedNodeBorders();
+}
+
 internal void
 FreeResizedNodeBorders()
 {
@@ -216,9 +354,10 @@ FreeResizedNodeBorders()
 
 EVENT_CALLBACK(Callback_AXEvent_RightMouseDown)
 {
+    KwmInvalidateSnapshot(Snapshot_Marked | Snapshot_Layout);
     CGPoint CursorPos = GetCursorPos();
     ax_display *CursorDisplay = AXLibCursorDisplay();
-    tree_node *Root = WindowTree[CursorDisplay->Space->Identifier].RootNode;
+    tree_node *Root = GetSpaceInfo(CursorDisplay->Space)->RootNode;
     tree_node *NodeBelowCursor = GetTreeNodeForPoint(Root, &CursorPos);
 
     if(!NodeBelowCursor)
@@ -285,15 +424,21 @@ EVENT_CALLBACK(Callback_AXEvent_RightMouseDown)
         AbsoluteAncestor = Root;
 
     InitializeResizedNodeBorders(AbsoluteAncestor);
+    BeginDragCommits(CursorDisplay);
     DEBUG("AXEvent_RightMouseDown");
 }
 
 EVENT_CALLBACK(Callback_AXEvent_RightMouseUp)
 {
+    KwmInvalidateSnapshot(Snapshot_Marked | Snapshot_Layout);
     if(DragResizeNode)
     {
         DEBUG("AXEvent_RightMouseUp");
 
+        if(DragCommit.Pending)
+            CommitResizeState();
+
+        EndDragCommits();
         FreeResizedNodeBorders();
         ApplyTreeNodeContainer(ResizeState.HorizontalAncestor);
         ApplyTreeNodeContainer(ResizeState.VerticalAncestor);
@@ -304,34 +449,38 @@ EVENT_CALLBACK(Callback_AXEvent_RightMouseUp)
 
 EVENT_CALLBACK(Callback_AXEvent_RightMouseDragged)
 {
-    CGPoint CursorPos = GetCursorPos();
-    local_persist  const double SplitRatioMinDifference = 0.002;
+    CGPoint *Cursor = (CGPoint *) Event->Context;
+
     if(DragResizeNode)
     {
         DEBUG("AXEvent_RightMouseDragged");
-        if(ResizeState.VerticalAncestor)
-        {
-            double ContainerTop = ResizeState.VerticalAncestor->Container.Y;
-            double ContainerHeight = ResizeState.VerticalAncestor->Container.Height;
-            double SplitRatio = (CursorPos.y - ContainerTop) / ContainerHeight;
-            if(fabs(SplitRatio - ResizeState.VerticalAncestor->SplitRatio) > SplitRatioMinDifference)
-                SetContainerSplitRatio(SplitRatio, ResizeState.Node, ResizeState.VerticalAncestor, ResizeState.Display, false);
-        }
+        if(UpdateDragCommit(Cursor))
+            CommitResizeState();
+    }
 
-        if(ResizeState.HorizontalAncestor)
+    free(Cursor);
+}
+
+/* NOTE: Event context is the generation of the drag that scheduled the trailing commit. */
+EVENT_CALLBACK(Callback_AXEvent_MouseDragCommit)
+{
+    uint32_t *Generation = (uint32_t *) Event->Context;
+
+    if(*Generation == DragCommit.Generation)
+    {
+        DragCommit.Trailing = false;
+        if(DragCommit.Pending)
         {
-            double ContainerLeft = ResizeState.HorizontalAncestor->Container.X;
-            double ContainerWidth = ResizeState.HorizontalAncestor->Container.Width;
-            double SplitRatio = (CursorPos.x - ContainerLeft) / ContainerWidth;
-            if(fabs(SplitRatio - ResizeState.HorizontalAncestor->SplitRatio) > SplitRatioMinDifference)
-                SetContainerSplitRatio(SplitRatio, ResizeState.Node, ResizeState.HorizontalAncestor, ResizeState.Display, false);
+            DEBUG("AXEvent_MouseDragCommit");
+            DragCommit.NextCommit = AXLibCurrentTime() + DragCommit.Interval;
+            if(DragMoveWindow)
+                CommitDragMoveWindow(FocusedApplication->Focus);
+            else if(DragResizeNode)
+                CommitResizeState();
         }
-
-        UpdateResizedNodeBorders();
     }
 
-    CGPoint *EventCursorPos = (CGPoint *) Event->Context;
-    free(EventCursorPos);
+    free(Generation);
 }
 
 
@@ -1,6 +1,12 @@
 #include "daemon.h"
 #include "interpreter.h"
 
+#include <vector>
+#include <deque>
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+
 #define internal static
 
 internal int KwmSockFD;
@@ -8,6 +14,28 @@ internal bool KwmDaemonIsRunning;
 internal int KwmDaemonPort = 3020;
 internal pthread_t KwmDaemonThread;
 
+/* NOTE: A subscriber only ever sees the latest notification of a state topic, older ones
+         are overwritten while they wait to be sent. Window notifications can not be
+         coalesced, so a subscriber that falls more than KWM_SUBSCRIBER_MAX_EVENTS
+         behind is dropped. */
+#define KWM_SUBSCRIBER_MAX_EVENTS 256
+
+struct kwm_subscriber
+{
+    int SockFD;
+    uint32_t Topics;
+    bool Dropped;
+
+    std::string Outgoing;
+    std::string Latest[NotifyTopic_Count];
+    std::deque<std::string> Events;
+};
+
+internal std::vector<kwm_subscriber *> Subscribers;
+internal pthread_mutex_t SubscriberLock = PTHREAD_MUTEX_INITIALIZER;
+internal pthread_t KwmNotifyThread;
+internal int KwmNotifyPipe[2] = { INVALID_SOCKFD, INVALID_SOCKFD };
+
 std::string KwmReadFromSocket(int ClientSockFD)
 {
     char Cur;
@@ -28,6 +56,198 @@ void KwmWriteToSocket(std::string Msg, int ClientSockFD)
     close(ClientSockFD);
 }
 
+internal inline void
+KwmWakeNotifyThread()
+{
+    char Wake = 0;
+    write(KwmNotifyPipe[1], &Wake, 1);
+}
+
+/* NOTE: Must be thread-safe! Called from the daemon thread. The subscriber owns the
+         client socket from now on. */
+void KwmAddSubscriber(int ClientSockFD, uint32_t Topics)
+{
+    int _True = 1;
+    setsockopt(ClientSockFD, SOL_SOCKET, SO_NOSIGPIPE, &_True, sizeof(int));
+    fcntl(ClientSockFD, F_SETFL, fcntl(ClientSockFD, F_GETFL) | O_NONBLOCK);
+
+    kwm_subscriber *Subscriber = new kwm_subscriber();
+    Subscriber->SockFD = ClientSockFD;
+    Subscriber->Topics = Topics;
+
+    pthread_mutex_lock(&SubscriberLock);
+    Subscribers.push_back(Subscriber);
+    pthread_mutex_unlock(&SubscriberLock);
+
+    KwmWakeNotifyThread();
+}
+
+/* NOTE: Must be thread-safe! Called from the event-loop thread. Never touches a socket,
+         the notification is only queued for the notify thread. */
+void KwmNotify(kwm_notify_topic Topic, const std::string &Line)
+{
+    bool Queued = false;
+
+    pthread_mutex_lock(&SubscriberLock);
+    for(std::size_t Index = 0; Index < Subscribers.size(); ++Index)
+    {
+        kwm_subscriber *Subscriber = Subscribers[Index];
+        if(!(Subscriber->Topics & NotifyTopicFlag(Topic)))
+            continue;
+
+        if(Topic == NotifyTopic_Window)
+        {
+            if(Subscriber->Events.size() < KWM_SUBSCRIBER_MAX_EVENTS)
+                Subscriber->Events.push_back(Line + "\n");
+            else
+                Subscriber->Dropped = true;
+        }
+        else
+        {
+            Subscriber->Latest[Topic] = Line + "\n";
+        }
+
+        Queued = true;
+    }
+    pthread_mutex_unlock(&SubscriberLock);
+
+    if(Queued)
+        KwmWakeNotifyThread();
+}
+
+internal inline bool
+KwmSubscriberHasPending(kwm_subscriber *Subscriber)
+{
+    if(!Subscriber->Outgoing.empty() || !Subscriber->Events.empty())
+        return true;
+
+    for(int Topic = 0; Topic < NotifyTopic_Count; ++Topic)
+    {
+        if(!Subscriber->Latest[Topic].empty())
+            return true;
+    }
+
+    return false;
+}
+
+/* NOTE: Sends as much as the socket accepts without blocking. Window notifications are
+         sent before state notifications, so that a focus change never refers to a
+         window the subscriber has not heard about yet. Returns false if the
+         connection is broken. */
+internal bool
+KwmFlushSubscriber(kwm_subscriber *Subscriber)
+{
+    while(true)
+    {
+        if(Subscriber->Outgoing.empty())
+        {
+            if(!Subscriber->Events.empty())
+            {
+                Subscriber->Outgoing.swap(Subscriber->Events.front());
+                Subscriber->Events.pop_front();
+            }
+            else
+            {
+                for(int Topic = 0; Topic < NotifyTopic_Count; ++Topic)
+                    Subscriber->Outgoing += Subscriber->Latest[Topic];
+
+                for(int Topic = 0; Topic < NotifyTopic_Count; ++Topic)
+                    Subscriber->Latest[Topic].clear();
+
+                if(Subscriber->Outgoing.empty())
+                    return true;
+            }
+        }
+
+        ssize_t Sent = send(Subscriber->SockFD, Subscriber->Outgoing.c_str(), Subscriber->Outgoing.size(), 0);
+        if(Sent == -1)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        Subscriber->Outgoing.erase(0, Sent);
+    }
+}
+
+/* NOTE: Subscribers are only removed by this thread. The daemon thread may append new
+         subscribers while we poll, so the first entries of Subscribers always line up
+         with the pollfd array. */
+internal void *
+KwmNotifySubscribersBG(void *)
+{
+    std::vector<struct pollfd> PollFDs;
+    while(KwmDaemonIsRunning)
+    {
+        PollFDs.clear();
+
+        struct pollfd WakeFD = { KwmNotifyPipe[0], POLLIN, 0 };
+        PollFDs.push_back(WakeFD);
+
+        pthread_mutex_lock(&SubscriberLock);
+        for(std::size_t Index = 0; Index < Subscribers.size(); ++Index)
+        {
+            kwm_subscriber *Subscriber = Subscribers[Index];
+            struct pollfd SubscriberFD = { Subscriber->SockFD, POLLIN, 0 };
+            if(KwmSubscriberHasPending(Subscriber))
+                SubscriberFD.events |= POLLOUT;
+
+            PollFDs.push_back(SubscriberFD);
+        }
+        pthread_mutex_unlock(&SubscriberLock);
+
+        if(poll(&PollFDs[0], PollFDs.size(), -1) == -1)
+            continue;
+
+        if(PollFDs[0].revents & POLLIN)
+        {
+            char Wake[64];
+            while(read(KwmNotifyPipe[0], Wake, sizeof(Wake)) > 0);
+        }
+
+        pthread_mutex_lock(&SubscriberLock);
+        for(std::size_t Index = 0; Index < Subscribers.size(); ++Index)
+        {
+            kwm_subscriber *Subscriber = Subscribers[Index];
+            if(Index + 1 < PollFDs.size())
+            {
+                short Events = PollFDs[Index + 1].revents;
+                if(Events & (POLLERR | POLLHUP | POLLNVAL))
+                {
+                    Subscriber->Dropped = true;
+                }
+                else if(Events & POLLIN)
+                {
+                    char Discard[64];
+                    ssize_t Received = recv(Subscriber->SockFD, Discard, sizeof(Discard), 0);
+                    if(Received == 0 || (Received == -1 && errno != EAGAIN && errno != EWOULDBLOCK))
+                        Subscriber->Dropped = true;
+                }
+            }
+
+            if(!Subscriber->Dropped && !KwmFlushSubscriber(Subscriber))
+                Subscriber->Dropped = true;
+        }
+
+        std::size_t Kept = 0;
+        for(std::size_t Index = 0; Index < Subscribers.size(); ++Index)
+        {
+            kwm_subscriber *Subscriber = Subscribers[Index];
+            if(Subscriber->Dropped)
+            {
+                shutdown(Subscriber->SockFD, SHUT_RDWR);
+                close(Subscriber->SockFD);
+                delete Subscriber;
+            }
+            else
+            {
+                Subscribers[Kept++] = Subscriber;
+            }
+        }
+        Subscribers.resize(Kept);
+        pthread_mutex_unlock(&SubscriberLock);
+    }
+
+    return NULL;
+}
+
 internal void *
 KwmDaemonHandleConnectionBG(void *)
 {
@@ -41,7 +261,7 @@ KwmDaemonHandleConnectionBG(void *)
         if(ClientSockFD != -1)
         {
             std::string Message = KwmReadFromSocket(ClientSockFD);
-            KwmInterpretCommand(Message, ClientSockFD);
+            KwmQueueCommand(Message, ClientSockFD);
         }
     }
 
@@ -52,6 +272,7 @@ void KwmTerminateDaemon()
 {
     KwmDaemonIsRunning = false;
     close(KwmSockFD);
+    KwmWakeNotifyThread();
 }
 
 bool KwmStartDaemon()
@@ -76,7 +297,14 @@ bool KwmStartDaemon()
     if(listen(KwmSockFD, 10) == -1)
         return false;
 
+    if(pipe(KwmNotifyPipe) == -1)
+        return false;
+
+    fcntl(KwmNotifyPipe[0], F_SETFL, fcntl(KwmNotifyPipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl(KwmNotifyPipe[1], F_SETFL, fcntl(KwmNotifyPipe[1], F_GETFL) | O_NONBLOCK);
+
     KwmDaemonIsRunning = true;
     pthread_create(&KwmDaemonThread, NULL, &KwmDaemonHandleConnectionBG, NULL);
+    pthread_create(&KwmNotifyThread, NULL, &KwmNotifySubscribersBG, NULL);
     return true;
 }
@@ -9,6 +9,23 @@
 #include <pthread.h>
 #include <string.h>
 #include <string>
+#include <stdint.h>
+
+#define INVALID_SOCKFD -1
+
+enum kwm_notify_topic
+{
+    NotifyTopic_Focus,
+    NotifyTopic_Space,
+    NotifyTopic_Layout,
+    NotifyTopic_Mode,
+    NotifyTopic_Window,
+
+    NotifyTopic_Count
+};
+
+#define NotifyTopicFlag(Topic) (1 << (Topic))
+#define NotifyTopic_All ((1 << NotifyTopic_Count) - 1)
 
 bool KwmStartDaemon();
 void KwmTerminateDaemon();
@@ -16,4 +33,7 @@ void KwmTerminateDaemon();
 std::string KwmReadFromSocket(int ClientSockFD);
 void KwmWriteToSocket(std::string Msg, int ClientSockFD);
 
+void KwmAddSubscriber(int ClientSockFD, uint32_t Topics);
+void KwmNotify(kwm_notify_topic Topic, const std::string &Line);
+
 #endif
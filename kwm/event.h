@@ -4,6 +4,8 @@
 #include "../axlib/event.h"
 
 /* NOTE(koekeishiya): Declare kwm_event_type callbacks as external functions. */
+extern EVENT_CALLBACK(Callback_KWMEvent_DaemonCommand);
+
 extern EVENT_CALLBACK(Callback_KWMEvent_QueryTilingMode);
 extern EVENT_CALLBACK(Callback_KWMEvent_QuerySplitMode);
 extern EVENT_CALLBACK(Callback_KWMEvent_QuerySplitRatio);
@@ -45,6 +47,8 @@ extern EVENT_CALLBACK(Callback_KWMEvent_QueryScratchpad);
 
 enum kwm_event_type
 {
+    KWMEvent_DaemonCommand,
+
     KWMEvent_QueryTilingMode,
     KWMEvent_QuerySplitMode,
     KWMEvent_QuerySplitRatio,
@@ -93,12 +97,14 @@ KwmCreateContext(int Id)
     return IdContext;
 }
 
-/* NOTE(koekeishiya): Construct an ax_event with the appropriate callback through macro expansion. */
+/* NOTE(koekeishiya): Construct an ax_event with the appropriate callback through macro expansion.
+                      Kwm events are always issued by a client of the daemon, and use the interactive lane. */
 #define KwmConstructEvent(EventType, EventContext) \
     do { ax_event Event = {}; \
          Event.Context = EventContext; \
          Event.Intrinsic = false; \
          Event.Handle = &Callback_##EventType; \
+         Event.Lane = AXEventLane_Interactive; \
          AXLibAddEvent(Event); \
        } while(0)
 
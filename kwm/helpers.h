@@ -2,71 +2,223 @@
 #define HELPERS_H
 
 #include "types.h"
+#include <limits.h>
+#include <stdint.h>
+#include <locale.h>
+#include <math.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
 
-#define ConvertStringTo_(name, type) \
-inline type \
-ConvertStringTo##name(std::string Value) \
-{ \
-    type Result = 0; \
-    std::stringstream Stream; \
-    Stream << Value; \
-    Stream >> Result; \
-    return Result; \
-}
+/* NOTE: Locale independent conversions that work directly on a range of characters,
+         in the spirit of std::from_chars. The whole range must be consumed for the
+         conversion to succeed. On failure false is returned and *Result is untouched. */
+inline bool
+ConvertTextToInt(const char *Text, int Length, int *Result)
+{
+    int Index = 0;
+    bool Negative = false;
+    if((Length > 0) && ((Text[0] == '-') || (Text[0] == '+')))
+    {
+        Negative = Text[0] == '-';
+        ++Index;
+    }
 
-ConvertStringTo_(Uint, uint32_t);
-ConvertStringTo_(Int, int);
-ConvertStringTo_(Double, double);
+    if(Index == Length)
+        return false;
 
-inline unsigned int
-ConvertHexStringToInt(std::string HexString)
-{
-    unsigned int HexResult = 0xffffff;
-    std::stringstream Stream;
-    Stream << std::hex << HexString;
-    Stream >> HexResult;
-    return HexResult;
+    int64_t Value = 0;
+    for(; Index < Length; ++Index)
+    {
+        char C = Text[Index];
+        if((C < '0') || (C > '9'))
+            return false;
+
+        Value = (Value * 10) + (C - '0');
+        if(Value > (int64_t)INT_MAX + 1)
+            return false;
+    }
+
+    if(Negative)
+        Value = -Value;
+
+    if((Value > INT_MAX) || (Value < INT_MIN))
+        return false;
+
+    *Result = (int) Value;
+    return true;
 }
 
 inline bool
-IsPrefixOfString(std::string &Line, std::string Prefix)
+ConvertTextToUint(const char *Text, int Length, uint32_t *Result)
 {
-    bool Result = false;
+    if(Length <= 0)
+        return false;
 
-    if(Line.substr(0, Prefix.size()) == Prefix)
+    uint64_t Value = 0;
+    for(int Index = 0; Index < Length; ++Index)
     {
-        Line = Line.substr(Prefix.size()+1);
-        Result = true;
+        char C = Text[Index];
+        if((C < '0') || (C > '9'))
+            return false;
+
+        Value = (Value * 10) + (C - '0');
+        if(Value > UINT32_MAX)
+            return false;
     }
 
-    return Result;
+    *Result = (uint32_t) Value;
+    return true;
 }
 
-inline std::string
-CreateStringFromTokens(std::vector<std::string> Tokens, int StartIndex)
+/* NOTE: Accepts an optional sign, digits with an optional fractional part and an optional
+         exponent; whitespace, hexadecimal floats, 'inf' and 'nan' are rejected, as are values
+         that overflow a double. When the digits fit in the 53-bit mantissa and the power of ten
+         is exactly representable, a single multiply or divide is correctly rounded. Anything
+         else is handed to strtod_l in the C locale. */
+inline bool
+ConvertTextToDouble(const char *Text, int Length, double *Result)
 {
-    std::string Text = "";
-    for(std::size_t TokenIndex = StartIndex; TokenIndex < Tokens.size(); ++TokenIndex)
+    int Index = 0;
+    bool Negative = false;
+    if((Index < Length) && ((Text[Index] == '-') || (Text[Index] == '+')))
+    {
+        Negative = Text[Index] == '-';
+        ++Index;
+    }
+
+    uint64_t Mantissa = 0;
+    int Digits = 0;
+    int Scale = 0;
+    while((Index < Length) && (Text[Index] >= '0') && (Text[Index] <= '9'))
+    {
+        if(Digits < 19)
+            Mantissa = (Mantissa * 10) + (Text[Index] - '0');
+        ++Index, ++Digits;
+    }
+
+    if((Index < Length) && (Text[Index] == '.'))
+    {
+        ++Index;
+        while((Index < Length) && (Text[Index] >= '0') && (Text[Index] <= '9'))
+        {
+            if(Digits < 19)
+                Mantissa = (Mantissa * 10) + (Text[Index] - '0');
+            ++Index, ++Digits, --Scale;
+        }
+    }
+
+    if(Digits == 0)
+        return false;
+
+    int Exponent = 0;
+    if((Index < Length) && ((Text[Index] == 'e') || (Text[Index] == 'E')))
+    {
+        ++Index;
+        bool NegativeExponent = false;
+        if((Index < Length) && ((Text[Index] == '-') || (Text[Index] == '+')))
+        {
+            NegativeExponent = Text[Index] == '-';
+            ++Index;
+        }
+
+        int ExponentDigits = 0;
+        while((Index < Length) && (Text[Index] >= '0') && (Text[Index] <= '9'))
+        {
+            if(Exponent < 100000)
+                Exponent = (Exponent * 10) + (Text[Index] - '0');
+            ++Index, ++ExponentDigits;
+        }
+
+        if(ExponentDigits == 0)
+            return false;
+
+        if(NegativeExponent)
+            Exponent = -Exponent;
+    }
+
+    if(Index != Length)
+        return false;
+
+    Exponent += Scale;
+    if((Digits <= 15) && (Exponent >= -22) && (Exponent <= 22))
+    {
+        static const double Powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        double Value = (double) Mantissa;
+        Value = Exponent < 0 ? Value / Powers[-Exponent] : Value * Powers[Exponent];
+        *Result = Negative ? -Value : Value;
+        return true;
+    }
+
+    static locale_t CLocale = newlocale(LC_ALL_MASK, "C", NULL);
+
+    char Buffer[64];
+    std::string Long;
+    const char *Terminated = Buffer;
+    if(Length < (int) sizeof(Buffer))
     {
-        Text += Tokens[TokenIndex];
-        if(TokenIndex < Tokens.size() - 1)
-            Text += " ";
+        memcpy(Buffer, Text, Length);
+        Buffer[Length] = '\0';
     }
+    else
+    {
+        Long.assign(Text, Length);
+        Terminated = Long.c_str();
+    }
+
+    char *End;
+    double Value = strtod_l(Terminated, &End, CLocale);
+    if((End != Terminated + Length) || (Value == HUGE_VAL) || (Value == -HUGE_VAL))
+        return false;
 
-    return Text;
+    *Result = Value;
+    return true;
 }
 
-inline std::vector<std::string>
-SplitString(std::string Line, char Delim)
+/* NOTE: Accepts up to eight hexadecimal digits, optionally prefixed by '0x'. */
+inline bool
+ConvertTextToHex(const char *Text, int Length, unsigned int *Result)
 {
-    std::vector<std::string> Elements;
-    std::stringstream Stream(Line);
-    std::string Temp;
+    int Index = 0;
+    if((Length > 1) && (Text[0] == '0') && ((Text[1] == 'x') || (Text[1] == 'X')))
+        Index = 2;
+
+    if((Index == Length) || (Length - Index > 8))
+        return false;
+
+    unsigned int Value = 0;
+    for(; Index < Length; ++Index)
+    {
+        char C = Text[Index];
+        unsigned int Digit;
+        if((C >= '0') && (C <= '9'))
+            Digit = C - '0';
+        else if((C >= 'a') && (C <= 'f'))
+            Digit = C - 'a' + 10;
+        else if((C >= 'A') && (C <= 'F'))
+            Digit = C - 'A' + 10;
+        else
+            return false;
 
-    while(std::getline(Stream, Temp, Delim))
-        Elements.push_back(Temp);
+        Value = (Value << 4) | Digit;
+    }
+
+    *Result = Value;
+    return true;
+}
 
-    return Elements;
+inline bool
+ConvertStringToInt(const std::string &Value, int *Result)
+{
+    return ConvertTextToInt(Value.c_str(), Value.size(), Result);
+}
+
+inline bool
+ConvertStringToDouble(const std::string &Value, double *Result)
+{
+    return ConvertTextToDouble(Value.c_str(), Value.size(), Result);
 }
 
 inline std::string &
@@ -4,33 +4,233 @@
 #include "rules.h"
 #include "config.h"
 #include "tokenizer.h"
+#include "daemon.h"
+#include "node.h"
+#include "window.h"
+#include "event.h"
+#include "query.h"
 #include "../axlib/axlib.h"
 
-void KwmInterpretCommand(std::string Message, int ClientSockFD)
+#define internal static
+
+extern ax_display *FocusedDisplay;
+
+internal std::vector<kwm_command> CommandQueue;
+internal pthread_mutex_t CommandQueueLock = PTHREAD_MUTEX_INITIALIZER;
+internal bool CommandDrainPending = false;
+
+internal kwm_command_type
+KwmCommandTypeFromToken(token Command)
+{
+    if(TokenEquals(Command, "quit"))
+        return Command_Quit;
+    else if(TokenEquals(Command, "query"))
+        return Command_Query;
+    else if((TokenEquals(Command, "config")) ||
+            (TokenEquals(Command, "mode")) ||
+            (TokenEquals(Command, "window")) ||
+            (TokenEquals(Command, "tree")) ||
+            (TokenEquals(Command, "display")) ||
+            (TokenEquals(Command, "space")) ||
+            (TokenEquals(Command, "scratchpad")))
+        return Command_Kwmc;
+    else if(TokenEquals(Command, "rule"))
+        return Command_Rule;
+    else if(TokenEquals(Command, "whitelist"))
+        return Command_Whitelist;
+    else if(TokenEquals(Command, "subscribe"))
+        return Command_Subscribe;
+
+    return Command_Unknown;
+}
+
+/* NOTE: 'subscribe' without any topics subscribes to all of them. */
+internal bool
+KwmParseSubscribeTopics(tokenizer *Tokenizer, uint32_t *Topics)
+{
+    *Topics = 0;
+    token Token = GetToken(Tokenizer);
+    while(Token.Type != Token_EndOfStream)
+    {
+        if(TokenEquals(Token, "focus"))
+            *Topics |= NotifyTopicFlag(NotifyTopic_Focus);
+        else if(TokenEquals(Token, "space"))
+            *Topics |= NotifyTopicFlag(NotifyTopic_Space);
+        else if(TokenEquals(Token, "layout"))
+            *Topics |= NotifyTopicFlag(NotifyTopic_Layout);
+        else if(TokenEquals(Token, "mode"))
+            *Topics |= NotifyTopicFlag(NotifyTopic_Mode);
+        else if(TokenEquals(Token, "window"))
+            *Topics |= NotifyTopicFlag(NotifyTopic_Window);
+        else if(TokenEquals(Token, "all"))
+            *Topics |= NotifyTopic_All;
+        else
+            return false;
+
+        Token = GetToken(Tokenizer);
+    }
+
+    if(*Topics == 0)
+        *Topics = NotifyTopic_All;
+
+    return true;
+}
+
+/* NOTE: The command is dispatched on tokens that point directly into Message.
+         Nothing is copied until a handler decides to store part of the command.
+         Returns true if the caller still owns the client socket and has to complete it;
+         a query hands the socket over to the query event that writes the response,
+         and a subscription keeps the socket open to push notifications. */
+internal bool
+KwmExecuteCommand(kwm_command_type Type, token Message, int ClientSockFD)
 {
-    std::vector<std::string> Tokens = SplitString(Message, ' ');
     tokenizer Tokenizer = {};
-    Tokenizer.At = (char *) Message.c_str();
-
-    if(Tokens[0] == "quit")
-        KwmQuit();
-    else if((Tokens[0] == "config") ||
-            (Tokens[0] == "mode") ||
-            (Tokens[0] == "window") ||
-            (Tokens[0] == "tree") ||
-            (Tokens[0] == "display") ||
-            (Tokens[0] == "space") ||
-            (Tokens[0] == "scratchpad") ||
-            (Tokens[0] == "query"))
-        KwmParseKwmc(&Tokenizer, ClientSockFD);
-    else if(Tokens[0] == "rule")
-        KwmAddRule(CreateStringFromTokens(Tokens, 1));
-    else if(Tokens[0] == "whitelist")
-        CarbonWhitelistProcess(CreateStringFromTokens(Tokens, 1));
-
-    if(Tokens[0] != "query")
+    Tokenizer.At = Message.Text;
+    Tokenizer.End = Message.Text + Message.TextLength;
+
+    switch(Type)
+    {
+        case Command_Quit:
+        {
+            KwmQuit();
+        } break;
+        case Command_Kwmc:
+        case Command_Query:
+        {
+            return KwmParseKwmc(&Tokenizer, ClientSockFD);
+        } break;
+        case Command_Rule:
+        {
+            GetToken(&Tokenizer);
+            KwmAddRule(TrimToken(GetTokenTilEndOfLine(&Tokenizer)));
+        } break;
+        case Command_Whitelist:
+        {
+            GetToken(&Tokenizer);
+            token Process = TrimToken(GetTokenTilEndOfLine(&Tokenizer));
+            if(Process.TextLength > 0)
+                CarbonWhitelistProcess(std::string(Process.Text, Process.TextLength));
+        } break;
+        case Command_Subscribe:
+        {
+            GetToken(&Tokenizer);
+            uint32_t Topics;
+            if(!KwmParseSubscribeTopics(&Tokenizer, &Topics))
+            {
+                KwmWriteToSocket("Unknown command '" + std::string(Message.Text, Message.TextLength) + "'", ClientSockFD);
+                return false;
+            }
+
+            KwmAddSubscriber(ClientSockFD, Topics);
+            return false;
+        } break;
+        case Command_Unknown:
+        {
+        } break;
+    }
+
+    return true;
+}
+
+internal void
+KwmCompleteCommand(int ClientSockFD)
+{
+    if(ClientSockFD != INVALID_SOCKFD)
     {
         shutdown(ClientSockFD, SHUT_RDWR);
         close(ClientSockFD);
     }
 }
+
+internal inline token
+KwmCommandMessage(const std::string &Message)
+{
+    token Token = {};
+    Token.Type = Token_String;
+    Token.Text = const_cast<char *>(Message.c_str());
+    Token.TextLength = Message.size();
+    return Token;
+}
+
+internal kwm_command_type
+KwmCommandType(token Message)
+{
+    tokenizer Tokenizer = {};
+    Tokenizer.At = Message.Text;
+    Tokenizer.End = Message.Text + Message.TextLength;
+    return KwmCommandTypeFromToken(GetToken(&Tokenizer));
+}
+
+/* NOTE: Executes the command immediately on the calling thread. Message is tokenized in place,
+         and only has to stay alive until this returns. */
+void KwmInterpretCommand(token Message, int ClientSockFD)
+{
+    if(KwmExecuteCommand(KwmCommandType(Message), Message, ClientSockFD))
+        KwmCompleteCommand(ClientSockFD);
+}
+
+/* NOTE: Must be thread-safe! Called from the daemon thread. Commands are executed on the
+         event-loop thread, so they never race with the AXEvent handlers. Only one drain
+         event is posted for any number of commands that arrive before it runs.
+         Queries are answered on the daemon thread, from the latest published snapshot,
+         and subscriptions are registered directly with the daemon. Only a command that is
+         queued is copied, as it outlives the message of the caller. */
+void KwmQueueCommand(const std::string &Message, int ClientSockFD)
+{
+    kwm_command_type Type = KwmCommandType(KwmCommandMessage(Message));
+    if((Type == Command_Query) ||
+       (Type == Command_Subscribe))
+    {
+        if(KwmExecuteCommand(Type, KwmCommandMessage(Message), ClientSockFD))
+            KwmCompleteCommand(ClientSockFD);
+
+        return;
+    }
+
+    kwm_command Command = {};
+    Command.Type = Type;
+    Command.Message = Message;
+    Command.ClientSockFD = ClientSockFD;
+
+    pthread_mutex_lock(&CommandQueueLock);
+    CommandQueue.push_back(Command);
+    bool PostDrainEvent = !CommandDrainPending;
+    CommandDrainPending = true;
+    pthread_mutex_unlock(&CommandQueueLock);
+
+    if(PostDrainEvent)
+        KwmConstructEvent(KWMEvent_DaemonCommand, NULL);
+}
+
+/* NOTE: All commands queued since the last drain are executed as one batch. Geometry
+         changes are deferred until the entire batch has run, and each client socket is
+         completed after that single layout pass. Window frames read during the batch
+         already reflect earlier commands, see SetWindowDimensions(..). */
+EVENT_CALLBACK(Callback_KWMEvent_DaemonCommand)
+{
+    std::vector<kwm_command> Commands;
+
+    pthread_mutex_lock(&CommandQueueLock);
+    Commands.swap(CommandQueue);
+    CommandDrainPending = false;
+    pthread_mutex_unlock(&CommandQueueLock);
+
+    std::vector<bool> Complete(Commands.size(), false);
+    KwmInvalidateSnapshot(Snapshot_All);
+
+    BeginDeferredWindowDimensions();
+    for(std::size_t Index = 0; Index < Commands.size(); ++Index)
+    {
+        kwm_command *Command = &Commands[Index];
+        Complete[Index] = KwmExecuteCommand(Command->Type, KwmCommandMessage(Command->Message), Command->ClientSockFD);
+    }
+
+    if(EndDeferredWindowDimensions())
+        NotifyLayoutChanged(FocusedDisplay);
+
+    for(std::size_t Index = 0; Index < Commands.size(); ++Index)
+    {
+        if(Complete[Index])
+            KwmCompleteCommand(Commands[Index].ClientSockFD);
+    }
+}
@@ -1,8 +1,28 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
+#include "tokenizer.h"
 #include <string>
 
-void KwmInterpretCommand(std::string Message, int ClientSockFD);
+enum kwm_command_type
+{
+    Command_Unknown,
+    Command_Quit,
+    Command_Kwmc,
+    Command_Query,
+    Command_Rule,
+    Command_Whitelist,
+    Command_Subscribe,
+};
+
+struct kwm_command
+{
+    kwm_command_type Type;
+    std::string Message;
+    int ClientSockFD;
+};
+
+void KwmInterpretCommand(token Message, int ClientSockFD);
+void KwmQueueCommand(const std::string &Message, int ClientSockFD);
 
 #endif
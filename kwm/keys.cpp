@@ -1,5 +1,6 @@
 #include "keys.h"
 #include "helpers.h"
+#include "tokenizer.h"
 #include "interpreter.h"
 
 #define internal static
@@ -83,28 +84,31 @@ CompareControlKey(modifier_keys *A, modifier_keys *B)
 internal void
 ParseModifiers(modifier_keys *Modifier, std::string KeySym)
 {
-    std::vector<std::string> Modifiers = SplitString(KeySym, '+');
-    for(std::size_t ModIndex = 0; ModIndex < Modifiers.size(); ++ModIndex)
+    tokenizer Tokenizer = {};
+    Tokenizer.At = const_cast<char *>(KeySym.c_str());
+
+    token Mod;
+    while(GetDelimitedToken(&Tokenizer, '+', &Mod))
     {
-        if(Modifiers[ModIndex] == "cmd")
+        if(TokenEquals(Mod, "cmd"))
             AddFlags(Modifier, Modifier_Flag_Cmd);
-        else if(Modifiers[ModIndex] == "lcmd")
+        else if(TokenEquals(Mod, "lcmd"))
             AddFlags(Modifier, Modifier_Flag_LCmd);
-        else if(Modifiers[ModIndex] == "rcmd")
+        else if(TokenEquals(Mod, "rcmd"))
             AddFlags(Modifier, Modifier_Flag_RCmd);
-        else if(Modifiers[ModIndex] == "alt")
+        else if(TokenEquals(Mod, "alt"))
             AddFlags(Modifier, Modifier_Flag_Alt);
-        else if(Modifiers[ModIndex] == "lalt")
+        else if(TokenEquals(Mod, "lalt"))
             AddFlags(Modifier, Modifier_Flag_LAlt);
-        else if(Modifiers[ModIndex] == "ralt")
+        else if(TokenEquals(Mod, "ralt"))
             AddFlags(Modifier, Modifier_Flag_RAlt);
-        else if(Modifiers[ModIndex] == "shift")
+        else if(TokenEquals(Mod, "shift"))
             AddFlags(Modifier, Modifier_Flag_Shift);
-        else if(Modifiers[ModIndex] == "lshift")
+        else if(TokenEquals(Mod, "lshift"))
             AddFlags(Modifier, Modifier_Flag_LShift);
-        else if(Modifiers[ModIndex] == "rshift")
+        else if(TokenEquals(Mod, "rshift"))
             AddFlags(Modifier, Modifier_Flag_RShift);
-        else if(Modifiers[ModIndex] == "ctrl")
+        else if(TokenEquals(Mod, "ctrl"))
             AddFlags(Modifier, Modifier_Flag_Control);
     }
 }
@@ -6,12 +6,13 @@
 #include "scratchpad.h"
 #include "border.h"
 #include "config.h"
+#include "query.h"
 #include "../axlib/axlib.h"
 #include <getopt.h>
 
 #define internal static
 const char *KwmVersion = "Kwm Version 4.0.3";
-std::map<std::string, space_info> WindowTree;
+std::deque<space_info> WindowTree;
 
 ax_display *FocusedDisplay = NULL;
 ax_application *FocusedApplication = NULL;
@@ -186,6 +187,7 @@ KwmInit()
     KWMSettings.Space = SpaceModeBSP;
     KWMSettings.Focus = FocusModeAutoraise;
     KWMSettings.Cycle = CycleModeScreen;
+    KWMSettings.Prewarm = SpacePrewarmLazy;
 
     FocusedBorder.Radius = -1;
     FocusedBorder.Type = BORDER_FOCUSED;
@@ -253,6 +255,18 @@ ParseArguments(int argc, char **argv)
     return false;
 }
 
+/* NOTE: Runs on the event-loop thread once per batch of events. Borders are submitted
+         first, as the geometry of the batch has been committed at this point. Trees of
+         spaces that are not active are built after the snapshot for queries is published. */
+internal
+EVENT_QUEUE_DRAINED_CALLBACK(KwmEventQueueDrained)
+{
+    FlushBorders();
+    KwmPublishSnapshot();
+    if(KWMSettings.Prewarm != SpacePrewarmLazy)
+        PrewarmNextWindowNodeTree();
+}
+
 internal inline void
 ConfigureRunLoop()
 {
@@ -310,6 +324,8 @@ int main(int argc, char **argv)
     KwmParseConfig(KWMPath.Config);
 
     CreateWindowNodeTree(MainDisplay);
+    if(KWMSettings.Prewarm == SpacePrewarmEager)
+        PrewarmAllWindowNodeTrees();
 
     /* TODO(koekeishiya): Probably want to defer this to run at some point where we know that
      * the focused application is set. This is usually the case as 'Finder' is always reported
@@ -317,6 +333,11 @@ int main(int argc, char **argv)
      * refinement, because we will (sometimes ?) get NULL when started by launchd at login */
     if(FocusedApplication && FocusedApplication->Focus)
         UpdateBorder(&FocusedBorder, FocusedApplication->Focus);
+    FlushBorders();
+
+    /* NOTE: Queries are answered from a snapshot published after each batch of events.
+             Until the first snapshot exists, queries are posted to the event-loop. */
+    AXLibSetEventQueueDrainedCallback(&KwmEventQueueDrained);
 
     ConfigureRunLoop();
     CFRunLoopRun();
@@ -0,0 +1,74 @@
+#include "container.h"
+
+#define internal static
+
+extern kwm_settings KWMSettings;
+
+internal inline split_type
+OptimalSplitMode(node_container *Container)
+{
+    return (Container->Width / Container->Height) >= KWMSettings.OptimalRatio ? SPLIT_VERTICAL : SPLIT_HORIZONTAL;
+}
+
+internal inline void
+SetDefaultSplit(tree_node *Node)
+{
+    if(Node->SplitRatio == 0)
+        Node->SplitRatio = KWMSettings.SplitRatio;
+
+    if(Node->SplitMode == SPLIT_NONE)
+        Node->SplitMode = OptimalSplitMode(&Node->Container);
+}
+
+/* NOTE: Splits every node that has both children, top-down; anything below a half-built node is
+         left alone. Every expression is evaluated in the same order as the ..ContainerSplit
+         functions in container.cpp, so both produce identical results. The gaps are already halved.
+         The split works on tree_node directly. A flat copy of the tree costs more to build and
+         write back than the split itself, see tests/layout_bench.cpp. */
+void SplitNodeContainers(tree_node *Node, double VerticalGap, double HorizontalGap, bool OptimalSplit)
+{
+    if(!Node->LeftChild || !Node->RightChild)
+        return;
+
+    node_container *Container = &Node->Container;
+    node_container *Left = &Node->LeftChild->Container;
+    node_container *Right = &Node->RightChild->Container;
+    double Ratio = Node->SplitRatio;
+
+    if(OptimalSplit)
+        Node->SplitMode = OptimalSplitMode(Container);
+
+    if(Node->SplitMode == SPLIT_VERTICAL)
+    {
+        Left->X = Container->X;
+        Left->Y = Container->Y;
+        Left->Width = (Container->Width * Ratio) - VerticalGap;
+        Left->Height = Container->Height;
+        Left->Type = CONTAINER_LEFT;
+
+        Right->X = Container->X + (Container->Width * Ratio) + VerticalGap;
+        Right->Y = Container->Y;
+        Right->Width = (Container->Width * (1 - Ratio)) - VerticalGap;
+        Right->Height = Container->Height;
+        Right->Type = CONTAINER_RIGHT;
+    }
+    else
+    {
+        Left->X = Container->X;
+        Left->Y = Container->Y;
+        Left->Width = Container->Width;
+        Left->Height = (Container->Height * Ratio) - HorizontalGap;
+        Left->Type = CONTAINER_UPPER;
+
+        Right->X = Container->X;
+        Right->Y = Container->Y + (Container->Height * Ratio) + HorizontalGap;
+        Right->Width = Container->Width;
+        Right->Height = (Container->Height * (1 - Ratio)) - HorizontalGap;
+        Right->Type = CONTAINER_LOWER;
+    }
+
+    SetDefaultSplit(Node->LeftChild);
+    SetDefaultSplit(Node->RightChild);
+    SplitNodeContainers(Node->LeftChild, VerticalGap, HorizontalGap, OptimalSplit);
+    SplitNodeContainers(Node->RightChild, VerticalGap, HorizontalGap, OptimalSplit);
+}
@@ -0,0 +1,169 @@
+#include "tree.h"
+
+#define internal static
+
+/* NOTE: Unique per root node, starting at one so that a zero generation is never valid. */
+internal uint32_t TreeGeneration = 0;
+
+uint32_t NextTreeGeneration()
+{
+    return ++TreeGeneration;
+}
+
+internal inline bool
+HasChildren(tree_node *Node)
+{
+    return Node->LeftChild || Node->RightChild;
+}
+
+/* NOTE: Both nodes must belong to the same tree, and their keys must have been assigned while it
+         was the tree of a valid set. Order is the path from the root read as a binary number,
+         so it only fits for the first 64 levels; deeper nodes fall back to walking up to the
+         children of their closest common ancestor. */
+bool min_depth_leaf_order::operator()(const tree_node *A, const tree_node *B) const
+{
+    if(A->Depth != B->Depth)
+        return A->Depth < B->Depth;
+
+    if(A->Depth < 64)
+        return A->Order < B->Order;
+
+    if(A == B)
+        return false;
+
+    while(A->Parent != B->Parent)
+    {
+        A = A->Parent;
+        B = B->Parent;
+    }
+
+    return A->Parent->LeftChild == A;
+}
+
+internal inline void
+SetChildOrder(tree_node *Node)
+{
+    if(Node->LeftChild)
+    {
+        Node->LeftChild->Depth = Node->Depth + 1;
+        Node->LeftChild->Order = Node->Order << 1;
+    }
+
+    if(Node->RightChild)
+    {
+        Node->RightChild->Depth = Node->Depth + 1;
+        Node->RightChild->Order = (Node->Order << 1) | 1;
+    }
+}
+
+/* NOTE: Visits nodes breadth-first, so leaves are found in min_depth_leaf_order
+         and can be appended to the set in constant time. */
+internal void
+RebuildMinDepthLeaves(space_info *Space)
+{
+    Space->MinDepthLeaves.clear();
+    Space->MinDepthLeavesGeneration = 0;
+    if(!Space->RootNode)
+        return;
+
+    Space->MinDepthLeavesGeneration = Space->RootNode->Generation;
+    Space->RootNode->Depth = 0;
+    Space->RootNode->Order = 0;
+
+    std::vector<tree_node *> Queue;
+    Queue.push_back(Space->RootNode);
+    for(std::size_t Index = 0; Index < Queue.size(); ++Index)
+    {
+        tree_node *Node = Queue[Index];
+        if(!HasChildren(Node))
+        {
+            Space->MinDepthLeaves.insert(Space->MinDepthLeaves.end(), Node);
+        }
+        else
+        {
+            SetChildOrder(Node);
+            if(Node->LeftChild)
+                Queue.push_back(Node->LeftChild);
+
+            if(Node->RightChild)
+                Queue.push_back(Node->RightChild);
+        }
+    }
+}
+
+internal inline bool
+HasValidMinDepthLeaves(space_info *Space)
+{
+    return Space->RootNode &&
+           Space->MinDepthLeavesGeneration != 0 &&
+           Space->MinDepthLeavesGeneration == Space->RootNode->Generation;
+}
+
+/* NOTE(koekeishiya): Should not be able to return null as the binary-tree is always proper. */
+tree_node *FindFirstMinDepthLeafNode(space_info *Space)
+{
+    if(!HasValidMinDepthLeaves(Space))
+        RebuildMinDepthLeaves(Space);
+
+    if(Space->MinDepthLeaves.empty())
+        return NULL;
+
+    return *Space->MinDepthLeaves.begin();
+}
+
+/* NOTE: Must be called right after Parent was split by CreateLeafNodePair(..). */
+void AddMinDepthLeafPair(space_info *Space, tree_node *Parent)
+{
+    if(HasValidMinDepthLeaves(Space))
+    {
+        Space->MinDepthLeaves.erase(Parent);
+        SetChildOrder(Parent);
+        Space->MinDepthLeaves.insert(Parent->LeftChild);
+        Space->MinDepthLeaves.insert(Parent->RightChild);
+    }
+}
+
+/* NOTE: Removes every leaf below Node. Must be called before the subtree is changed,
+         while the leaves are still ordered by their current position and depth. */
+void RemoveMinDepthLeaves(space_info *Space, tree_node *Node)
+{
+    if(HasValidMinDepthLeaves(Space) && Node)
+    {
+        if(!HasChildren(Node))
+        {
+            Space->MinDepthLeaves.erase(Node);
+        }
+        else
+        {
+            RemoveMinDepthLeaves(Space, Node->LeftChild);
+            RemoveMinDepthLeaves(Space, Node->RightChild);
+        }
+    }
+}
+
+/* NOTE: Adds every leaf below Node, after the subtree has been changed. The keys of
+         the subtree are derived from Node, which must not have moved. */
+void AddMinDepthLeaves(space_info *Space, tree_node *Node)
+{
+    if(HasValidMinDepthLeaves(Space) && Node)
+    {
+        if(!HasChildren(Node))
+        {
+            Space->MinDepthLeaves.insert(Node);
+        }
+        else
+        {
+            SetChildOrder(Node);
+            AddMinDepthLeaves(Space, Node->LeftChild);
+            AddMinDepthLeaves(Space, Node->RightChild);
+        }
+    }
+}
+
+/* NOTE: Used when the tree is replaced or restructured in a way that changes the order
+         of its leaves. The set is rebuilt the next time it is needed. */
+void InvalidateMinDepthLeaves(space_info *Space)
+{
+    Space->MinDepthLeaves.clear();
+    Space->MinDepthLeavesGeneration = 0;
+}
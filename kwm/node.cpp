@@ -7,7 +7,6 @@
 
 #define internal static
 
-extern std::map<std::string, space_info> WindowTree;
 extern ax_application *FocusedApplication;
 extern kwm_settings KWMSettings;
 
@@ -21,6 +20,7 @@ tree_node *CreateRootNode()
     RootNode->Parent = NULL;
     RootNode->LeftChild = NULL;
     RootNode->RightChild = NULL;
+    RootNode->Generation = NextTreeGeneration();
     RootNode->SplitRatio = KWMSettings.SplitRatio;
     RootNode->SplitMode = SPLIT_OPTIMAL;
 
@@ -45,6 +45,7 @@ tree_node *CreateLeafNode(ax_display *Display, tree_node *Parent, uint32_t Windo
     memset(Leaf, 0, sizeof(tree_node));
 
     Leaf->Parent = Parent;
+    Leaf->Depth = Parent->Depth + 1;
     Leaf->WindowID = WindowID;
     Leaf->Type = NodeTypeTree;
 
@@ -58,6 +59,9 @@ tree_node *CreateLeafNode(ax_display *Display, tree_node *Parent, uint32_t Windo
 
 void CreateLeafNodePair(ax_display *Display, tree_node *Parent, uint32_t FirstWindowID, uint32_t SecondWindowID, split_type SplitMode)
 {
+    tree_node *PrevLeaf, *NextLeaf;
+    GetSurroundingLeafNodes(Parent, &PrevLeaf, &NextLeaf);
+
     Parent->WindowID = 0;
     Parent->SplitMode = SplitMode;
     Parent->SplitRatio = KWMSettings.SplitRatio;
@@ -118,12 +122,14 @@ void CreateLeafNodePair(ax_display *Display, tree_node *Parent, uint32_t FirstWi
         Parent->RightChild = NULL;
         Parent = NULL;
     }
+
+    ThreadLeafNodes(Parent, PrevLeaf, NextLeaf);
 }
 
 void CreatePseudoNode()
 {
     ax_display *Display = AXLibMainDisplay();
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(!FocusedApplication)
         return;
 
@@ -136,6 +142,7 @@ void CreatePseudoNode()
     {
         split_type SplitMode = KWMSettings.SplitMode == SPLIT_OPTIMAL ? GetOptimalSplitMode(Node) : KWMSettings.SplitMode;
         CreateLeafNodePair(Display, Node, Node->WindowID, 0, SplitMode);
+        AddMinDepthLeafPair(SpaceInfo, Node);
         ApplyTreeNodeContainer(Node);
     }
 }
@@ -143,7 +150,7 @@ void CreatePseudoNode()
 void RemovePseudoNode()
 {
     ax_display *Display = AXLibMainDisplay();
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(!FocusedApplication)
         return;
 
@@ -159,11 +166,18 @@ void RemovePseudoNode()
         if(!PseudoNode || !IsLeafNode(PseudoNode) || PseudoNode->WindowID != 0)
             return;
 
+        tree_node *PrevLeaf, *NextLeaf;
+        GetSurroundingLeafNodes(Parent, &PrevLeaf, &NextLeaf);
+        RemoveMinDepthLeaves(SpaceInfo, Parent);
+
         Parent->WindowID = Node->WindowID;
         Parent->LeftChild = NULL;
         Parent->RightChild = NULL;
         free(Node);
         free(PseudoNode);
+
+        ThreadLeafNodes(Parent, PrevLeaf, NextLeaf);
+        AddMinDepthLeaves(SpaceInfo, Parent);
         ApplyTreeNodeContainer(Parent);
     }
 }
@@ -203,7 +217,7 @@ bool IsRightChild(tree_node *Node)
 void ToggleFocusedNodeSplitMode()
 {
     ax_display *Display = AXLibMainDisplay();
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(!FocusedApplication)
         return;
 
@@ -231,7 +245,7 @@ void ToggleTypeOfFocusedNode()
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     tree_node *TreeNode = GetTreeNodeFromWindowIDOrLinkNode(SpaceInfo->RootNode, Window->ID);
     if(TreeNode && TreeNode != SpaceInfo->RootNode)
@@ -245,7 +259,7 @@ void ChangeTypeOfFocusedNode(node_type Type)
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     tree_node *TreeNode = GetTreeNodeFromWindowIDOrLinkNode(SpaceInfo->RootNode, Window->ID);
     if(TreeNode && TreeNode != SpaceInfo->RootNode)
@@ -294,24 +308,25 @@ split_type GetOptimalSplitMode(tree_node *Node)
     return (Node->Container.Width / Node->Container.Height) >= KWMSettings.OptimalRatio ? SPLIT_VERTICAL : SPLIT_HORIZONTAL;
 }
 
-void ResizeWindowToContainerSize(tree_node *Node)
+internal void
+ResizeWindowToContainer(uint32_t WindowID, node_container *Container)
 {
-    ax_window *Window = GetWindowByID((unsigned int)Node->WindowID);
+    ax_window *Window = GetWindowByID(WindowID);
     if(Window)
     {
-        SetWindowDimensions(Window, Node->Container.X, Node->Container.Y,
-                            Node->Container.Width, Node->Container.Height);
+        SetWindowDimensions(Window, Container->X, Container->Y,
+                            Container->Width, Container->Height);
     }
 }
 
+void ResizeWindowToContainerSize(tree_node *Node)
+{
+    ResizeWindowToContainer(Node->WindowID, &Node->Container);
+}
+
 void ResizeWindowToContainerSize(link_node *Link)
 {
-    ax_window *Window = GetWindowByID((unsigned int)Link->WindowID);
-    if(Window)
-    {
-        SetWindowDimensions(Window, Link->Container.X, Link->Container.Y,
-                            Link->Container.Width, Link->Container.Height);
-    }
+    ResizeWindowToContainer(Link->WindowID, &Link->Container);
 }
 
 void ResizeWindowToContainerSize(ax_window *Window)
@@ -323,7 +338,7 @@ void ResizeWindowToContainerSize(ax_window *Window)
             return;
 
         ax_display *Display = AXLibWindowDisplay(Window);
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
         tree_node *Node = GetTreeNodeFromWindowID(SpaceInfo->RootNode, Window->ID);
         if(Node)
@@ -357,7 +372,7 @@ void ModifyContainerSplitRatio(double Offset)
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     tree_node *Root = SpaceInfo->RootNode;
     if(!Root || IsLeafNode(Root) || Root->WindowID != 0)
@@ -422,7 +437,7 @@ void ModifyContainerSplitRatio(double Offset, int Degrees)
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     tree_node *Root = SpaceInfo->RootNode;
     if(!Root || IsLeafNode(Root) || Root->WindowID != 0)
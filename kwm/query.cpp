@@ -1,4 +1,4 @@
-#include "types.h"
+#include "query.h"
 #include "window.h"
 #include "space.h"
 #include "daemon.h"
@@ -6,10 +6,11 @@
 #include "node.h"
 
 #include "../axlib/axlib.h"
+#include <atomic>
 
 #define internal static
+#define local_persist static
 
-extern std::map<std::string, space_info> WindowTree;
 extern ax_window *MarkedWindow;
 
 extern kwm_settings KWMSettings;
@@ -25,7 +26,7 @@ GetSplitModeOfWindow(ax_window *Window)
         return "";
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     tree_node *Node = GetTreeNodeFromWindowIDOrLinkNode(SpaceInfo->RootNode, Window->ID);
     if(Node)
@@ -39,9 +40,9 @@ GetSplitModeOfWindow(ax_window *Window)
     return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryTilingMode)
+internal std::string
+KwmQueryTilingMode()
 {
-    int *SockFD = (int *) Event->Context;
     std::string Output;
 
     if(KWMSettings.Space == SpaceModeBSP)
@@ -51,14 +52,12 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryTilingMode)
     else
         Output = "float";
 
-    printf("QueryTilingMode: %d\n", *SockFD);
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QuerySplitMode)
+internal std::string
+KwmQuerySplitMode()
 {
-    int *SockFD = (int *) Event->Context;
     std::string Output;
 
     if(KWMSettings.SplitMode == SPLIT_OPTIMAL)
@@ -68,33 +67,28 @@ EVENT_CALLBACK(Callback_KWMEvent_QuerySplitMode)
     else if(KWMSettings.SplitMode == SPLIT_HORIZONTAL)
         Output = "Horizontal";
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QuerySplitRatio)
+internal std::string
+KwmQuerySplitRatio()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = std::to_string(KWMSettings.SplitRatio);
     Output.erase(Output.find_last_not_of('0') + 1, std::string::npos);
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QuerySpawnPosition)
+internal std::string
+KwmQuerySpawnPosition()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = HasFlags(&KWMSettings, Settings_SpawnAsLeftChild) ? "left" : "right";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryFocusFollowsMouse)
+internal std::string
+KwmQueryFocusFollowsMouse()
 {
-    int *SockFD = (int *) Event->Context;
     std::string Output;
 
     if(KWMSettings.Focus == FocusModeAutoraise)
@@ -102,59 +96,47 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryFocusFollowsMouse)
     else if(KWMSettings.Focus == FocusModeDisabled)
         Output = "off";
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryMouseFollowsFocus)
+internal std::string
+KwmQueryMouseFollowsFocus()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = HasFlags(&KWMSettings, Settings_MouseFollowsFocus) ? "on" : "off";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryCycleFocus)
+internal std::string
+KwmQueryCycleFocus()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = KWMSettings.Cycle == CycleModeScreen ? "screen" : "off";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryFloatNonResizable)
+internal std::string
+KwmQueryFloatNonResizable()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = HasFlags(&KWMSettings, Settings_FloatNonResizable) ? "on" : "off";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryLockToContainer)
+internal std::string
+KwmQueryLockToContainer()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = HasFlags(&KWMSettings, Settings_LockToContainer) ? "on" : "off";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryStandbyOnFloat)
+internal std::string
+KwmQueryStandbyOnFloat()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = HasFlags(&KWMSettings, Settings_StandbyOnFloat) ? "on" : "off";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QuerySpaces)
+internal std::string
+KwmQuerySpaces()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output;
     ax_display *Display = AXLibMainDisplay();
     if(Display)
@@ -185,39 +167,34 @@ EVENT_CALLBACK(Callback_KWMEvent_QuerySpaces)
             Output.erase(Output.begin() + Output.size()-1);
     }
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryCurrentSpaceName)
+internal std::string
+KwmQueryCurrentSpaceName()
 {
-    int *SockFD = (int *) Event->Context;
     std::string Output;
 
     ax_display *Display = AXLibMainDisplay();
     Output = GetNameOfSpace(Display, Display->Space);
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryPreviousSpaceName)
+internal std::string
+KwmQueryPreviousSpaceName()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output;
     ax_display *Display = AXLibMainDisplay();
     if(Display)
         Output = GetNameOfSpace(Display, Display->PrevSpace);
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryCurrentSpaceMode)
+internal std::string
+KwmQueryCurrentSpaceMode()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output;
     ax_window *Window = NULL;
     ax_application *Application = AXLibGetFocusedApplication();
@@ -225,13 +202,13 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryCurrentSpaceMode)
         Window = Application->Focus;
 
     GetTagForCurrentSpace(Output, Window);
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryCurrentSpaceTag)
+internal std::string
+KwmQueryCurrentSpaceTag()
 {
-    int *SockFD = (int *) Event->Context;
     std::string Output;
 
     ax_application *Application = AXLibGetFocusedApplication();
@@ -239,160 +216,134 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryCurrentSpaceTag)
     {
         ax_window *Window = Application->Focus;
         GetTagForCurrentSpace(Output, Window);
-        Output += " " + Application->Name;
+        Output += " " + std::string(Application->Name->Text);
         if(Window && Window->Name)
-            Output += " - " + std::string(Window->Name);
+            Output += " - " + std::string(Window->Name->Text);
     }
     else
     {
         GetTagForCurrentSpace(Output, NULL);
     }
 
-
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryCurrentSpaceId)
+internal std::string
+KwmQueryCurrentSpaceId()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = "-1";
     ax_display *Display = AXLibMainDisplay();
     if(Display)
         Output = std::to_string(AXLibDesktopIDFromCGSSpaceID(Display, Display->Space->ID));
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryPreviousSpaceId)
+internal std::string
+KwmQueryPreviousSpaceId()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = "-1";
     ax_display *Display = AXLibMainDisplay();
     if(Display)
         Output = std::to_string(AXLibDesktopIDFromCGSSpaceID(Display, Display->PrevSpace->ID));
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryFocusedBorder)
+internal std::string
+KwmQueryFocusedBorder()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = FocusedBorder.Enabled ? "true" : "false";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryMarkedBorder)
+internal std::string
+KwmQueryMarkedBorder()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = MarkedBorder.Enabled ? "true" : "false";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryFocusedWindowId)
+internal std::string
+KwmQueryFocusedWindowId()
 {
-    int *SockFD = (int *) Event->Context;
-
-
     ax_application *Application = AXLibGetFocusedApplication();
     std::string Output = Application && Application->Focus ? std::to_string(Application->Focus->ID) : "-1";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryFocusedWindowName)
+internal std::string
+KwmQueryFocusedWindowName()
 {
-    int *SockFD = (int *) Event->Context;
-
-
     ax_application *Application = AXLibGetFocusedApplication();
-    std::string Output = Application && Application->Focus ? Application->Focus->Name : "";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    std::string Output = Application && Application->Focus && Application->Focus->Name ? Application->Focus->Name->Text : "";
+
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryFocusedWindowSplit)
+internal std::string
+KwmQueryFocusedWindowSplit()
 {
-    int *SockFD = (int *) Event->Context;
-
     ax_application *Application = AXLibGetFocusedApplication();
     std::string Output = Application ? GetSplitModeOfWindow(Application->Focus) : "";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryFocusedWindowFloat)
+internal std::string
+KwmQueryFocusedWindowFloat()
 {
-    int *SockFD = (int *) Event->Context;
-
     ax_application *Application = AXLibGetFocusedApplication();
     std::string Output = Application && Application->Focus ? (AXLibHasFlags(Application->Focus, AXWindow_Floating) ? "true" : "false") : "false";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryMarkedWindowId)
+internal std::string
+KwmQueryMarkedWindowId()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = MarkedWindow ? std::to_string(MarkedWindow->ID) : "-1";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryMarkedWindowName)
+internal std::string
+KwmQueryMarkedWindowName()
 {
-    int *SockFD = (int *) Event->Context;
-
-    std::string Output = MarkedWindow && MarkedWindow->Name ? MarkedWindow->Name : "";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    std::string Output = MarkedWindow && MarkedWindow->Name ? MarkedWindow->Name->Text : "";
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryMarkedWindowSplit)
+internal std::string
+KwmQueryMarkedWindowSplit()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = GetSplitModeOfWindow(MarkedWindow);
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryMarkedWindowFloat)
+internal std::string
+KwmQueryMarkedWindowFloat()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output = MarkedWindow ? (AXLibHasFlags(MarkedWindow, AXWindow_Floating) ? "true" : "false") : "";
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryWindowList)
+internal std::string
+KwmQueryWindowList()
 {
-    int *SockFD = (int *) Event->Context;
-
     std::string Output;
     std::vector<ax_window *> Windows = AXLibGetAllVisibleWindows();
     for(std::size_t Index = 0; Index < Windows.size(); ++Index)
     {
         ax_window *Window = Windows[Index];
-        Output += std::to_string(Window->ID) + ", " + Window->Application->Name;
+        Output += std::to_string(Window->ID) + ", " + Window->Application->Name->Text;
         if(Window->Name)
-            Output +=  ", " + std::string(Window->Name);
+            Output +=  ", " + std::string(Window->Name->Text);
         if(Index < Windows.size() - 1)
             Output += "\n";
     }
 
-    KwmWriteToSocket(Output, *SockFD);
-    free(SockFD);
+    return Output;
 }
 
 EVENT_CALLBACK(Callback_KWMEvent_QueryNodePosition)
@@ -405,7 +356,7 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryNodePosition)
     ax_display *Display = AXLibMainDisplay();
     if(Display)
     {
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
         tree_node *Node = GetTreeNodeFromWindowIDOrLinkNode(SpaceInfo->RootNode, WindowID);
         if(Node)
             Output = IsLeftChild(Node) ? "left" : "right";
@@ -426,7 +377,7 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryParentNodeState)
     ax_display *Display = AXLibMainDisplay();
     if(Display)
     {
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
         tree_node *FirstNode = GetTreeNodeFromWindowIDOrLinkNode(SpaceInfo->RootNode, FirstID);
         tree_node *SecondNode = GetTreeNodeFromWindowIDOrLinkNode(SpaceInfo->RootNode, SecondID);
         if(FirstNode && SecondNode)
@@ -453,9 +404,9 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryWindowIdInDirectionOfFocusedWindow)
     free(Args);
 }
 
-EVENT_CALLBACK(Callback_KWMEvent_QueryScratchpad)
+internal std::string
+KwmQueryScratchpad()
 {
-    int *SockFD = (int *) Event->Context;
     std::string Result;
 
     int Index = 0;
@@ -464,13 +415,327 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryScratchpad)
     {
         Result += std::to_string(It->first) + ": " +
                   std::to_string(It->second->ID) + ", " +
-                  It->second->Application->Name + ", " +
-                  It->second->Name;
+                  It->second->Application->Name->Text + ", " +
+                  (It->second->Name ? It->second->Name->Text : "");
 
         if(Index++ < Scratchpad.Windows.size() - 1)
             Result += "\n";
     }
 
-    KwmWriteToSocket(Result, *SockFD);
+    return Result;
+}
+
+/* NOTE: Thread-safe. One line per event-loop lane, wait times are in microseconds,
+         followed by the number of move and resize echoes dropped by the observer. */
+std::string KwmQueryEventLoopStats()
+{
+    local_persist const char *LaneNames[AXEventLane_Count] = { "interactive", "lifecycle", "background" };
+
+    ax_event_lane_stats Stats[AXEventLane_Count];
+    AXLibEventLoopStats(Stats);
+
+    std::string Result;
+    for(int Lane = 0; Lane < AXEventLane_Count; ++Lane)
+    {
+        uint64_t AverageWait = Stats[Lane].Dispatched ? Stats[Lane].TotalWait / Stats[Lane].Dispatched : 0;
+        Result += std::string(LaneNames[Lane]) +
+                  " depth " + std::to_string(Stats[Lane].Depth) +
+                  " max-depth " + std::to_string(Stats[Lane].MaxDepth) +
+                  " dispatched " + std::to_string(Stats[Lane].Dispatched) +
+                  " avg-wait " + std::to_string(AverageWait / 1000) +
+                  " max-wait " + std::to_string(Stats[Lane].MaxWait / 1000);
+
+        Result += "\n";
+    }
+
+    ax_lock_stats LockStats[2];
+    AXLibApplicationsLockStats(&LockStats[0], &LockStats[1]);
+    for(int Index = 0; Index < 2; ++Index)
+    {
+        ax_lock_stats *Stats = &LockStats[Index];
+        uint64_t AverageWait = Stats->Acquired ? Stats->TotalWait / Stats->Acquired : 0;
+        uint64_t AverageHold = Stats->Acquired ? Stats->TotalHold / Stats->Acquired : 0;
+        Result += std::string(Index == 0 ? "applications-read" : "applications-write") +
+                  " acquired " + std::to_string(Stats->Acquired) +
+                  " avg-wait " + std::to_string(AverageWait / 1000) +
+                  " max-wait " + std::to_string(Stats->MaxWait / 1000) +
+                  " avg-hold " + std::to_string(AverageHold / 1000) +
+                  " max-hold " + std::to_string(Stats->MaxHold / 1000);
+
+        Result += "\n";
+    }
+
+    Result += "suppressed-echoes " + std::to_string(AXLibSuppressedWindowEchoes());
+    return Result;
+}
+
+/* NOTE: One line per application, latencies are in microseconds. */
+std::string KwmQueryApplicationLatency()
+{
+    std::string Result = "deadline " + std::to_string(AXLibApplicationDeadline());
+
+    ax_application_map *Applications = BeginAXLibApplications();
+    for(ax_application_map_iter It = Applications->begin();
+        It != Applications->end();
+        ++It)
+    {
+        ax_application *Application = It->second;
+        ax_application_latency Stats;
+        AXLibApplicationLatencyStats(Application, &Stats);
+
+        uint64_t AverageLatency = Stats.Calls ? Stats.TotalLatency / Stats.Calls : 0;
+        Result += "\n" + std::string(Application->Name->Text) +
+                  " pid " + std::to_string(Application->PID) +
+                  " calls " + std::to_string(Stats.Calls) +
+                  " timeouts " + std::to_string(Stats.Timeouts) +
+                  " avg-latency " + std::to_string(AverageLatency / 1000) +
+                  " max-latency " + std::to_string(Stats.MaxLatency / 1000) +
+                  " deferred " + std::to_string(Stats.Pending) +
+                  (Stats.Quarantined ? " quarantined" : "");
+    }
+    EndAXLibApplications();
+
+    return Result;
+}
+
+/* NOTE: Times are in milliseconds. */
+std::string KwmQueryStartupStats()
+{
+    ax_startup_stats Stats;
+    AXLibStartupStats(&Stats);
+
+    uint64_t AverageTime = Stats.Applications ? Stats.ApplicationTime / Stats.Applications : 0;
+    std::string Result = "applications " + std::to_string(Stats.Applications) +
+                         " initialized " + std::to_string(Stats.Initialized) +
+                         " windows " + std::to_string(Stats.Windows) +
+                         " timed-out " + std::to_string(Stats.TimedOut) +
+                         " stragglers " + std::to_string(Stats.Stragglers) + "\n" +
+                         "list " + std::to_string(Stats.ListTime / (1000 * 1000)) +
+                         " construct " + std::to_string(Stats.ConstructTime / (1000 * 1000)) +
+                         " initialize " + std::to_string(Stats.InitializeTime / (1000 * 1000)) +
+                         " avg-application " + std::to_string(AverageTime / (1000 * 1000)) +
+                         " max-application " + std::to_string(Stats.MaxApplicationTime / (1000 * 1000));
+
+    return Result;
+}
+
+#define KWM_QUERY_CALLBACK(Name) \
+EVENT_CALLBACK(Callback_KWMEvent_Query##Name) \
+{ \
+    int *SockFD = (int *) Event->Context; \
+    KwmWriteToSocket(KwmQuery##Name(), *SockFD); \
+    free(SockFD); \
+}
+
+KWM_QUERY_CALLBACK(TilingMode)
+KWM_QUERY_CALLBACK(SplitMode)
+KWM_QUERY_CALLBACK(SplitRatio)
+KWM_QUERY_CALLBACK(SpawnPosition)
+KWM_QUERY_CALLBACK(FocusFollowsMouse)
+KWM_QUERY_CALLBACK(MouseFollowsFocus)
+KWM_QUERY_CALLBACK(CycleFocus)
+KWM_QUERY_CALLBACK(FloatNonResizable)
+KWM_QUERY_CALLBACK(LockToContainer)
+KWM_QUERY_CALLBACK(StandbyOnFloat)
+KWM_QUERY_CALLBACK(Spaces)
+KWM_QUERY_CALLBACK(CurrentSpaceName)
+KWM_QUERY_CALLBACK(PreviousSpaceName)
+KWM_QUERY_CALLBACK(CurrentSpaceMode)
+KWM_QUERY_CALLBACK(CurrentSpaceTag)
+KWM_QUERY_CALLBACK(CurrentSpaceId)
+KWM_QUERY_CALLBACK(PreviousSpaceId)
+KWM_QUERY_CALLBACK(FocusedBorder)
+KWM_QUERY_CALLBACK(MarkedBorder)
+KWM_QUERY_CALLBACK(FocusedWindowId)
+KWM_QUERY_CALLBACK(FocusedWindowName)
+KWM_QUERY_CALLBACK(FocusedWindowSplit)
+KWM_QUERY_CALLBACK(FocusedWindowFloat)
+KWM_QUERY_CALLBACK(MarkedWindowId)
+KWM_QUERY_CALLBACK(MarkedWindowName)
+KWM_QUERY_CALLBACK(MarkedWindowSplit)
+KWM_QUERY_CALLBACK(MarkedWindowFloat)
+KWM_QUERY_CALLBACK(WindowList)
+KWM_QUERY_CALLBACK(Scratchpad)
+
+/* NOTE: Queries that only depend on the current state, and can therefore be answered
+         from a snapshot. Queries that take arguments are still run on the event-loop. */
+struct kwm_snapshot_query
+{
+    kwm_event_type Type;
+    std::string (*Query)();
+    uint32_t Flags;
+};
+
+#define KWM_SNAPSHOT_QUERY(Name, Flags) { KWMEvent_Query##Name, &KwmQuery##Name, Flags }
+internal const kwm_snapshot_query SnapshotQueries[] =
+{
+    KWM_SNAPSHOT_QUERY(TilingMode, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(SplitMode, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(SplitRatio, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(SpawnPosition, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(FocusFollowsMouse, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(MouseFollowsFocus, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(CycleFocus, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(FloatNonResizable, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(LockToContainer, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(StandbyOnFloat, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(Spaces, Snapshot_Spaces),
+    KWM_SNAPSHOT_QUERY(CurrentSpaceName, Snapshot_Spaces),
+    KWM_SNAPSHOT_QUERY(PreviousSpaceName, Snapshot_Spaces),
+    KWM_SNAPSHOT_QUERY(CurrentSpaceMode, Snapshot_Settings | Snapshot_Spaces | Snapshot_Focus | Snapshot_Layout),
+    KWM_SNAPSHOT_QUERY(CurrentSpaceTag, Snapshot_Settings | Snapshot_Spaces | Snapshot_Focus | Snapshot_Layout),
+    KWM_SNAPSHOT_QUERY(CurrentSpaceId, Snapshot_Spaces),
+    KWM_SNAPSHOT_QUERY(PreviousSpaceId, Snapshot_Spaces),
+    KWM_SNAPSHOT_QUERY(FocusedBorder, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(MarkedBorder, Snapshot_Settings),
+    KWM_SNAPSHOT_QUERY(FocusedWindowId, Snapshot_Focus),
+    KWM_SNAPSHOT_QUERY(FocusedWindowName, Snapshot_Focus),
+    KWM_SNAPSHOT_QUERY(FocusedWindowSplit, Snapshot_Focus | Snapshot_Layout),
+    KWM_SNAPSHOT_QUERY(FocusedWindowFloat, Snapshot_Focus | Snapshot_Layout),
+    KWM_SNAPSHOT_QUERY(MarkedWindowId, Snapshot_Marked),
+    KWM_SNAPSHOT_QUERY(MarkedWindowName, Snapshot_Marked),
+    KWM_SNAPSHOT_QUERY(MarkedWindowSplit, Snapshot_Marked | Snapshot_Layout),
+    KWM_SNAPSHOT_QUERY(MarkedWindowFloat, Snapshot_Marked | Snapshot_Layout),
+    KWM_SNAPSHOT_QUERY(WindowList, Snapshot_Windows),
+    KWM_SNAPSHOT_QUERY(Scratchpad, Snapshot_Windows),
+};
+#define KWM_SNAPSHOT_QUERY_COUNT (sizeof(SnapshotQueries) / sizeof(SnapshotQueries[0]))
+
+/* NOTE: Snapshots are published by the event-loop thread through an atomic pointer swap.
+         A reader announces the epoch it entered at before loading the pointer, and a
+         replaced snapshot is only freed once every active reader has entered a later
+         epoch. Readers therefore never block, and never wait behind the event queue. */
+#define KWM_SNAPSHOT_MAX_READERS 16
+
+internal std::atomic<kwm_snapshot *> CurrentSnapshot(NULL);
+internal std::atomic<uint64_t> SnapshotEpoch(1);
+internal std::atomic<uint64_t> ReaderEpoch[KWM_SNAPSHOT_MAX_READERS];
+internal std::atomic<bool> ReaderSlotTaken[KWM_SNAPSHOT_MAX_READERS];
+internal __thread int ReaderSlot = -1;
+internal std::vector<kwm_snapshot *> RetiredSnapshots;
+internal uint32_t SnapshotDirty = Snapshot_All;
+
+internal int
+KwmClaimSnapshotReaderSlot()
+{
+    if(ReaderSlot == -1)
+    {
+        for(int Index = 0; Index < KWM_SNAPSHOT_MAX_READERS; ++Index)
+        {
+            bool Expected = false;
+            if(ReaderSlotTaken[Index].compare_exchange_strong(Expected, true))
+            {
+                ReaderSlot = Index;
+                break;
+            }
+        }
+    }
+
+    return ReaderSlot;
+}
+
+kwm_snapshot *KwmAcquireSnapshot()
+{
+    int Slot = KwmClaimSnapshotReaderSlot();
+    if(Slot == -1)
+        return NULL;
+
+    ReaderEpoch[Slot].store(SnapshotEpoch.load());
+    kwm_snapshot *Snapshot = CurrentSnapshot.load();
+    if(!Snapshot)
+        ReaderEpoch[Slot].store(0);
+
+    return Snapshot;
+}
+
+void KwmReleaseSnapshot()
+{
+    if(ReaderSlot != -1)
+        ReaderEpoch[ReaderSlot].store(0);
+}
+
+internal void
+KwmReclaimSnapshots()
+{
+    uint64_t OldestReader = UINT64_MAX;
+    for(int Index = 0; Index < KWM_SNAPSHOT_MAX_READERS; ++Index)
+    {
+        uint64_t Epoch = ReaderEpoch[Index].load();
+        if(Epoch != 0 && Epoch < OldestReader)
+            OldestReader = Epoch;
+    }
+
+    std::size_t Kept = 0;
+    for(std::size_t Index = 0; Index < RetiredSnapshots.size(); ++Index)
+    {
+        kwm_snapshot *Snapshot = RetiredSnapshots[Index];
+        if(Snapshot->RetiredEpoch < OldestReader)
+            delete Snapshot;
+        else
+            RetiredSnapshots[Kept++] = Snapshot;
+    }
+
+    RetiredSnapshots.resize(Kept);
+}
+
+/* NOTE: Must only be called from the event-loop thread. */
+void KwmInvalidateSnapshot(uint32_t Flags)
+{
+    SnapshotDirty |= Flags;
+}
+
+/* NOTE: Must only be called from the event-loop thread. Responses that were not invalidated since
+         the last snapshot are copied from it, and nothing is published for a batch that did not
+         change any of the queried state. */
+EVENT_QUEUE_DRAINED_CALLBACK(KwmPublishSnapshot)
+{
+    kwm_snapshot *Current = CurrentSnapshot.load();
+    if(Current && !SnapshotDirty)
+        return;
+
+    kwm_snapshot *Snapshot = new kwm_snapshot();
+    Snapshot->Epoch = SnapshotEpoch.load();
+    Snapshot->Responses.resize(KWM_SNAPSHOT_QUERY_COUNT);
+    for(std::size_t Index = 0; Index < KWM_SNAPSHOT_QUERY_COUNT; ++Index)
+    {
+        if(!Current || (SnapshotQueries[Index].Flags & SnapshotDirty))
+            Snapshot->Responses[Index] = (*SnapshotQueries[Index].Query)();
+        else
+            Snapshot->Responses[Index] = Current->Responses[Index];
+    }
+
+    SnapshotDirty = 0;
+    kwm_snapshot *Retired = CurrentSnapshot.exchange(Snapshot);
+    if(Retired)
+    {
+        Retired->RetiredEpoch = SnapshotEpoch.load();
+        RetiredSnapshots.push_back(Retired);
+    }
+
+    SnapshotEpoch.fetch_add(1);
+    KwmReclaimSnapshots();
+}
+
+/* NOTE: Thread-safe. Writes the response and frees the context if the query could be
+         answered from the latest snapshot. Returns false if the query has to be posted
+         to the event-loop instead. */
+bool KwmAnswerQueryFromSnapshot(kwm_event_type Type, void *Context)
+{
+    std::size_t Index = 0;
+    while(Index < KWM_SNAPSHOT_QUERY_COUNT && SnapshotQueries[Index].Type != Type)
+        ++Index;
+
+    if(Index == KWM_SNAPSHOT_QUERY_COUNT)
+        return false;
+
+    kwm_snapshot *Snapshot = KwmAcquireSnapshot();
+    if(!Snapshot)
+        return false;
+
+    int *SockFD = (int *) Context;
+    KwmWriteToSocket(Snapshot->Responses[Index], *SockFD);
+    KwmReleaseSnapshot();
+
     free(SockFD);
+    return true;
 }
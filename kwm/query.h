@@ -0,0 +1,39 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "types.h"
+#include "event.h"
+
+/* NOTE: The state a snapshot query depends on. Handlers that change it invalidate the matching
+         responses, and only those are rebuilt when the next snapshot is published. */
+enum kwm_snapshot_flags
+{
+    Snapshot_Settings = (1 << 0),
+    Snapshot_Spaces = (1 << 1),
+    Snapshot_Focus = (1 << 2),
+    Snapshot_Marked = (1 << 3),
+    Snapshot_Layout = (1 << 4),
+    Snapshot_Windows = (1 << 5),
+
+    Snapshot_All = 0x3f,
+};
+
+struct kwm_snapshot
+{
+    uint64_t Epoch;
+    uint64_t RetiredEpoch;
+    std::vector<std::string> Responses;
+};
+
+kwm_snapshot *KwmAcquireSnapshot();
+void KwmReleaseSnapshot();
+void KwmInvalidateSnapshot(uint32_t Flags);
+
+EVENT_QUEUE_DRAINED_CALLBACK(KwmPublishSnapshot);
+bool KwmAnswerQueryFromSnapshot(kwm_event_type Type, void *Context);
+
+std::string KwmQueryEventLoopStats();
+std::string KwmQueryApplicationLatency();
+std::string KwmQueryStartupStats();
+
+#endif
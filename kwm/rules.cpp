@@ -67,47 +67,56 @@ ParseProperties(tokenizer *Tokenizer, window_properties *Properties)
                 {
                     case Token_SemiColon: { continue; } break;
                     case Token_CloseBrace: { ValidState = false; } break;
+                    case Token_EndOfStream:
+                    {
+                        ReportInvalidRule("Expected token '}'");
+                        return false;
+                    } break;
                     case Token_Identifier:
                     {
+                        std::string Value;
                         if(TokenEquals(Token, "float"))
                         {
-                            std::string Value;
-                            if(ParseIdentifier(Tokenizer, &Value))
-                            {
-                                if(Value == "true")
-                                    Properties->Float = 1;
-                                else if(Value == "false")
-                                    Properties->Float = 0;
-                            }
+                            if(!ParseIdentifier(Tokenizer, &Value))
+                                return false;
+
+                            if(Value == "true")
+                                Properties->Float = 1;
+                            else if(Value == "false")
+                                Properties->Float = 0;
                         }
                         else if(TokenEquals(Token, "display"))
                         {
-                            std::string Value;
-                            if(ParseIdentifier(Tokenizer, &Value))
-                                Properties->Display = ConvertStringToInt(Value);
+                            if(!ParseIdentifier(Tokenizer, &Value))
+                                return false;
+
+                            if(!ConvertStringToInt(Value, &Properties->Display))
+                                ReportInvalidRule("Expected integer value for 'display': '" + Value + "'");
                         }
                         else if(TokenEquals(Token, "space"))
                         {
-                            std::string Value;
-                            if(ParseIdentifier(Tokenizer, &Value))
-                                Properties->Space = ConvertStringToInt(Value);
+                            if(!ParseIdentifier(Tokenizer, &Value))
+                                return false;
+
+                            if(!ConvertStringToInt(Value, &Properties->Space))
+                                ReportInvalidRule("Expected integer value for 'space': '" + Value + "'");
                         }
                         else if(TokenEquals(Token, "scratchpad"))
                         {
-                            std::string Value;
-                            if(ParseIdentifier(Tokenizer, &Value))
-                            {
-                                if(Value == "visible")
-                                    Properties->Scratchpad = 1;
-                                else if(Value == "hidden")
-                                    Properties->Scratchpad = 0;
-                            }
+                            if(!ParseIdentifier(Tokenizer, &Value))
+                                return false;
+
+                            if(Value == "visible")
+                                Properties->Scratchpad = 1;
+                            else if(Value == "hidden")
+                                Properties->Scratchpad = 0;
                         }
                         else if(TokenEquals(Token, "role"))
                         {
-                            std::string Value;
-                            if(ParseIdentifier(Tokenizer, &Value))
-                                    Properties->Role = Value;
+                            if(!ParseIdentifier(Tokenizer, &Value))
+                                return false;
+
+                            Properties->Role = Value;
                         }
                     } break;
                     default: { ReportInvalidRule("Expected token of type Token_Identifier: '" + std::string(Token.Text, Token.TextLength) + "'"); } break;
@@ -130,44 +139,69 @@ ParseProperties(tokenizer *Tokenizer, window_properties *Properties)
 }
 
 internal bool
-KwmParseRule(std::string RuleSym, window_rule *Rule)
+KwmParseRule(token RuleSym, window_rule *Rule)
 {
     tokenizer Tokenizer = {};
-    Tokenizer.At = const_cast<char*>(RuleSym.c_str());
+    Tokenizer.At = RuleSym.Text;
+    Tokenizer.End = RuleSym.Text + RuleSym.TextLength;
 
     bool Result = true;
-    bool Parsing = true;
-    while(Parsing)
+    while(Result)
     {
         token Token = GetToken(&Tokenizer);
+        if(Token.Type == Token_EndOfStream)
+            break;
+
         switch(Token.Type)
         {
-            case Token_EndOfStream:
-            {
-                Parsing = false;
-            } break;
             case Token_Unknown:
             {
+                ReportInvalidRule("Unexpected token: '" + std::string(Token.Text, Token.TextLength) + "'");
+                Result = false;
             } break;
             case Token_Identifier:
             {
                 if(TokenEquals(Token, "owner"))
-                    Result = Result && ParseIdentifier(&Tokenizer, &Rule->Owner);
+                    Result = ParseIdentifier(&Tokenizer, &Rule->Owner);
                 else if(TokenEquals(Token, "name"))
-                    Result = Result && ParseIdentifier(&Tokenizer, &Rule->Name);
+                    Result = ParseIdentifier(&Tokenizer, &Rule->Name);
                 else if(TokenEquals(Token, "role"))
-                    Result = Result && ParseIdentifier(&Tokenizer, &Rule->Role);
+                    Result = ParseIdentifier(&Tokenizer, &Rule->Role);
                 else if(TokenEquals(Token, "crole"))
-                    Result = Result && ParseIdentifier(&Tokenizer, &Rule->CustomRole);
+                    Result = ParseIdentifier(&Tokenizer, &Rule->CustomRole);
                 else if(TokenEquals(Token, "properties"))
-                    Result = Result && ParseProperties(&Tokenizer, &Rule->Properties);
+                    Result = ParseProperties(&Tokenizer, &Rule->Properties);
                 else if(TokenEquals(Token, "except"))
-                    Result = Result && ParseIdentifier(&Tokenizer, &Rule->Except);
+                    Result = ParseIdentifier(&Tokenizer, &Rule->Except);
             } break;
             default: { } break;
         }
     }
 
+    if(!Result)
+        ReportInvalidRule("Ignoring rule '" + std::string(RuleSym.Text, RuleSym.TextLength) + "'");
+
+    return Result;
+}
+
+/* NOTE: The result of matching a pattern against an interned string is remembered by
+         the id of the string, which is never reused. Titles change often, so the
+         memo is simply cleared once it grows past RULE_MEMO_LIMIT entries. */
+#define RULE_MEMO_LIMIT 512
+internal bool
+MatchRulePattern(std::map<uint32_t, bool> *Memo, std::string &Pattern, ax_string *String)
+{
+    std::map<uint32_t, bool>::iterator It = Memo->find(String->ID);
+    if(It != Memo->end())
+        return It->second;
+
+    std::regex Exp(Pattern);
+    bool Result = std::regex_match(String->Text, Exp);
+
+    if(Memo->size() >= RULE_MEMO_LIMIT)
+        Memo->clear();
+
+    (*Memo)[String->ID] = Result;
     return Result;
 }
 
@@ -179,45 +213,33 @@ MatchWindowRule(window_rule *Rule, ax_window *Window)
 
     bool Match = true;
     if(!Rule->Owner.empty())
-    {
-        std::regex Exp(Rule->Owner);
-        Match = std::regex_match(Window->Application->Name, Exp);
-    }
+        Match = MatchRulePattern(&Rule->OwnerMatches, Rule->Owner, Window->Application->Name);
 
     if(!Rule->Name.empty() && Window->Name)
-    {
-        std::regex Exp(Rule->Name);
-        Match = Match && std::regex_match(Window->Name, Exp);
-    }
+        Match = Match && MatchRulePattern(&Rule->NameMatches, Rule->Name, Window->Name);
 
-    if(!Rule->Role.empty())
-    {
-        CFTypeRef AXRole = CFStringCreateWithCString(NULL, Rule->Role.c_str(), kCFStringEncodingMacRoman);
-        Match = Match && AXLibWindowHasRole(Window, AXRole);
-        CFRelease(AXRole);
-    }
+    if(Rule->RoleID)
+        Match = Match && AXLibWindowHasRole(Window, Rule->RoleID);
 
-    if(!Rule->CustomRole.empty())
-    {
-        CFTypeRef AXRole = CFStringCreateWithCString(NULL, Rule->CustomRole.c_str(), kCFStringEncodingMacRoman);
-        Match = Match && AXLibWindowHasCustomRole(Window, AXRole);
-        CFRelease(AXRole);
-    }
+    if(Rule->CustomRoleID)
+        Match = Match && AXLibWindowHasCustomRole(Window, Rule->CustomRoleID);
 
     if(!Rule->Except.empty() && Window->Name)
-    {
-        std::regex Exp(Rule->Except);
-        Match = Match && !std::regex_match(Window->Name, Exp);
-    }
+        Match = Match && !MatchRulePattern(&Rule->ExceptMatches, Rule->Except, Window->Name);
 
     return Match;
 }
 
-void KwmAddRule(std::string RuleSym)
+void KwmAddRule(token RuleSym)
 {
     window_rule Rule = {};
-    if(!RuleSym.empty() && KwmParseRule(RuleSym, &Rule))
+    if(RuleSym.TextLength > 0 && KwmParseRule(RuleSym, &Rule))
+    {
+        Rule.RoleID = AXLibRoleID(Rule.Role.c_str());
+        Rule.CustomRoleID = AXLibRoleID(Rule.CustomRole.c_str());
+        Rule.Properties.RoleID = AXLibRoleID(Rule.Properties.Role.c_str());
         KWMSettings.WindowRules.push_back(Rule);
+    }
 }
 
 /* TODO(koekeishiya): This entire system is just stupid. Reimplement in a proper way. */
@@ -239,10 +261,8 @@ bool ApplyWindowRules(ax_window *Window)
                 }
             }
 
-            if(!Rule->Properties.Role.empty())
-                Window->Type.CustomRole = CFStringCreateWithCString(NULL,
-                                                                    Rule->Properties.Role.c_str(),
-                                                                    kCFStringEncodingMacRoman);
+            if(Rule->Properties.RoleID)
+                AXLibSetWindowCustomRole(Window, Rule->Properties.RoleID);
 
             if(Rule->Properties.Scratchpad != -1)
             {
@@ -2,9 +2,10 @@
 #define RULES_H
 
 #include "types.h"
+#include "tokenizer.h"
 #include "../axlib/axlib.h"
 
 bool ApplyWindowRules(ax_window *Window);
-void KwmAddRule(std::string RuleSym);
+void KwmAddRule(token RuleSym);
 
 #endif
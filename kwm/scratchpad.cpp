@@ -29,7 +29,7 @@ int GetScratchpadSlotOfWindow(ax_window *Window)
     }
 
     if(Window->Name)
-        DEBUG("GetScratchpadSlotOfWindow() " << Window->Name  << " " << Slot);
+        DEBUG("GetScratchpadSlotOfWindow() " << Window->Name->Text  << " " << Slot);
     else
         DEBUG("GetScratchpadSlotOfWindow() " << "[Unknown]" << " " << Slot);
     return Slot;
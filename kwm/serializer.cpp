@@ -5,6 +5,7 @@
 #include "space.h"
 #include "border.h"
 #include "helpers.h"
+#include "tokenizer.h"
 #include "../axlib/display.h"
 
 #define internal static
@@ -52,20 +53,35 @@ DeserializeParentNode(tree_node *Parent, ax_display *Display, std::vector<std::s
     unsigned int LineNumber = Index;
     for(;LineNumber < Serialized.size(); ++LineNumber)
     {
-        std::string Line = Serialized[LineNumber];
-        std::vector<std::string> Tokens = SplitString(Line, ' ');
+        tokenizer Tokenizer = {};
+        Tokenizer.At = const_cast<char *>(Serialized[LineNumber].c_str());
+
+        /* NOTE: Lines look like 'kwmc tree root split-ratio 0.5'; only the last two words matter. */
+        token Tokens[4] = {};
+        int TokenCount = 0;
+        while((TokenCount < 4) && (GetDelimitedToken(&Tokenizer, ' ', &Tokens[TokenCount])))
+            ++TokenCount;
+
+        if(TokenCount < 3)
+            continue;
 
-        if(Tokens[2] == "split-mode")
+        token Value = Tokens[3];
+        if(TokenEquals(Tokens[2], "split-mode"))
         {
-            Parent->SplitMode = (split_type)ConvertStringToInt(Tokens[3]);
-            DEBUG("Root: SplitMode Found " + Tokens[3]);
+            int SplitMode;
+            if(ConvertTextToInt(Value.Text, Value.TextLength, &SplitMode))
+                Parent->SplitMode = (split_type)SplitMode;
+            else
+                std::cerr << "Layout error: invalid split-mode '" << std::string(Value.Text, Value.TextLength) << "'" << std::endl;
+            DEBUG("Root: SplitMode Found " << std::string(Value.Text, Value.TextLength));
         }
-        else if(Tokens[2] == "split-ratio")
+        else if(TokenEquals(Tokens[2], "split-ratio"))
         {
-            Parent->SplitRatio = ConvertStringToDouble(Tokens[3]);
-            DEBUG("Root: SplitRatio Found " + Tokens[3]);
+            if(!ConvertTextToDouble(Value.Text, Value.TextLength, &Parent->SplitRatio))
+                std::cerr << "Layout error: invalid split-ratio '" << std::string(Value.Text, Value.TextLength) << "'" << std::endl;
+            DEBUG("Root: SplitRatio Found " << std::string(Value.Text, Value.TextLength));
         }
-        else if(Tokens[2] == "child")
+        else if(TokenEquals(Tokens[2], "child"))
         {
             DEBUG("Root: Child Found");
             DEBUG("Parent: " << Parent->SplitMode << "|" << Parent->SplitRatio);
@@ -131,6 +147,7 @@ DeserializeNodeTree(std::vector<std::string> &Serialized, ax_display *Display)
     tree_node *RootNode = CreateRootNode();
     SetRootNodeContainer(Display, RootNode);
     DeserializeParentNode(RootNode, Display, Serialized, 1);
+    ThreadLeafNodes(RootNode, NULL, NULL);
     return RootNode;
 }
 
@@ -173,6 +190,7 @@ bool LoadBSPTreeFromFile(ax_display *Display, space_info *SpaceInfo, std::string
     while(std::getline(InFD, Line))
         SerializedTree.push_back(Line);
 
+    InvalidateMinDepthLeaves(SpaceInfo);
     DestroyNodeTree(SpaceInfo->RootNode);
     SpaceInfo->RootNode = DeserializeNodeTree(SerializedTree, Display);
     return true;
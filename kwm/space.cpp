@@ -7,10 +7,30 @@
 #include "helpers.h"
 #include "../axlib/axlib.h"
 
-extern std::map<std::string, space_info> WindowTree;
+extern std::deque<space_info> WindowTree;
 extern ax_application *FocusedApplication;
 extern kwm_settings KWMSettings;
 
+/* NOTE: WindowTree is indexed by ax_space::Handle. A std::deque is used so that
+         space_info pointers stay valid when the registry grows. */
+space_info *CreateSpaceInfo(ax_space *Space)
+{
+    if(Space->Handle >= WindowTree.size())
+        WindowTree.resize(Space->Handle + 1);
+
+    return &WindowTree[Space->Handle];
+}
+
+/* NOTE: Spaces that axlib discovers after startup get their entry on first lookup.
+         Only axlib hands out handles, so this can not create phantom spaces. */
+space_info *GetSpaceInfo(ax_space *Space)
+{
+    if(Space->Handle < WindowTree.size())
+        return &WindowTree[Space->Handle];
+
+    return CreateSpaceInfo(Space);
+}
+
 void GetTagForMonocleSpace(space_info *Space, std::string &Tag)
 {
     tree_node *Node = Space->RootNode;
@@ -50,7 +70,7 @@ void GetTagForMonocleSpace(space_info *Space, std::string &Tag)
 void GetTagForCurrentSpace(std::string &Tag, ax_window *Window)
 {
     ax_display *Display = Window ? AXLibWindowDisplay(Window) : AXLibMainDisplay();
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     if(SpaceInfo->Initialized)
     {
@@ -100,15 +120,15 @@ space_settings *GetSpaceSettingsForDesktopID(int ScreenID, int DesktopID)
         return NULL;
 }
 
-void LoadSpaceSettings(ax_display *Display, space_info *SpaceInfo)
+void LoadSpaceSettings(ax_display *Display, ax_space *Space, space_info *SpaceInfo)
 {
-    int DesktopID = AXLibDesktopIDFromCGSSpaceID(Display, Display->Space->ID);
+    int DesktopID = AXLibDesktopIDFromCGSSpaceID(Display, Space->ID);
 
     /* NOTE(koekeishiya): Load global default display settings. */
     SpaceInfo->Settings.Offset = KWMSettings.DefaultOffset;
     SpaceInfo->Settings.Mode = SpaceModeDefault;
     SpaceInfo->Settings.Layout = "";
-    SpaceInfo->Settings.Name = "";
+    SpaceInfo->Settings.Name = NULL;
 
     /* NOTE(koekeishiya): The space in question may have overloaded settings. */
     space_settings *SpaceSettings = NULL;
@@ -121,14 +141,25 @@ void LoadSpaceSettings(ax_display *Display, space_info *SpaceInfo)
         SpaceInfo->Settings.Mode = KWMSettings.Space;
 }
 
+void LoadSpaceSettings(ax_display *Display, space_info *SpaceInfo)
+{
+    LoadSpaceSettings(Display, Display->Space, SpaceInfo);
+}
+
+/* NOTE: Space names are interned and never released, so comparing them is a pointer
+         compare. A name that has never been interned can not belong to any space. */
 int GetSpaceFromName(ax_display *Display, std::string Name)
 {
+    ax_string *Lookup = AXLibFindString(Name.c_str());
+    if(!Lookup)
+        return -1;
+
     std::map<CGSSpaceID, ax_space>::iterator It;
     for(It = Display->Spaces.begin(); It != Display->Spaces.end(); ++It)
     {
         ax_space *Space = &It->second;
-        space_info *SpaceInfo = &WindowTree[Space->Identifier];
-        if(SpaceInfo->Settings.Name == Name)
+        space_info *SpaceInfo = GetSpaceInfo(Space);
+        if(SpaceInfo->Settings.Name == Lookup)
             return Space->ID;
     }
 
@@ -137,17 +168,17 @@ int GetSpaceFromName(ax_display *Display, std::string Name)
 
 void SetNameOfActiveSpace(ax_display *Display, std::string Name)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
-    if(SpaceInfo) SpaceInfo->Settings.Name = Name;
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
+    if(SpaceInfo) SpaceInfo->Settings.Name = AXLibInternString(Name.c_str());
 }
 
 std::string GetNameOfSpace(ax_display *Display, ax_space *Space)
 {
-    space_info *SpaceInfo = &WindowTree[Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Space);
     std::string Result = "[no tag]";
 
-    if(!SpaceInfo->Settings.Name.empty())
-        Result = SpaceInfo->Settings.Name;
+    if(SpaceInfo->Settings.Name && SpaceInfo->Settings.Name->Length)
+        Result = SpaceInfo->Settings.Name->Text;
 
     return Result;
 }
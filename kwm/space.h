@@ -4,11 +4,15 @@
 #include "types.h"
 #include "../axlib/axlib.h"
 
+space_info *CreateSpaceInfo(ax_space *Space);
+space_info *GetSpaceInfo(ax_space *Space);
+
 void GetTagForMonocleSpace(space_info *Space, std::string &Tag);
 void GetTagForCurrentSpace(std::string &Tag, ax_window *Window);
 
 void GoToPreviousSpace(bool MoveFocusedWindow);
 space_settings *GetSpaceSettingsForDesktopID(int ScreenID, int DesktopID);
+void LoadSpaceSettings(ax_display *Display, ax_space *Space, space_info *SpaceInfo);
 void LoadSpaceSettings(ax_display *Display, space_info *SpaceInfo);
 int GetSpaceFromName(ax_display *Display, std::string Name);
 void SetNameOfActiveSpace(ax_display *Display, std::string Name);
@@ -2,12 +2,23 @@
 
 #define internal static
 
+/* NOTE: Every read goes through here, so that a bounded tokenizer never looks past End. */
+internal inline char
+CharAt(tokenizer *Tokenizer, int Offset)
+{
+    char *At = Tokenizer->At + Offset;
+    if(Tokenizer->End && At >= Tokenizer->End)
+        return '\0';
+
+    return *At;
+}
+
 internal inline void
 EatAllWhiteSpace(tokenizer *Tokenizer)
 {
-    while(Tokenizer->At[0])
+    while(CharAt(Tokenizer, 0))
     {
-        if(IsWhiteSpace(Tokenizer->At[0]))
+        if(IsWhiteSpace(CharAt(Tokenizer, 0)))
             ++Tokenizer->At;
         else
             break;
@@ -21,7 +32,9 @@ bool RequireToken(tokenizer *Tokenizer, token_type DesiredType)
     return Result;
 }
 
-std::string GetTextTilEndOfLine(tokenizer *Tokenizer)
+/* NOTE: The returned token points into the buffer of the tokenizer
+         and is only valid for as long as that buffer is alive. */
+token GetTokenTilEndOfLine(tokenizer *Tokenizer)
 {
     EatAllWhiteSpace(Tokenizer);
 
@@ -29,15 +42,48 @@ std::string GetTextTilEndOfLine(tokenizer *Tokenizer)
     Token.TextLength = 1;
     Token.Text = Tokenizer->At;
 
-    while(Tokenizer->At[0] && !IsEndOfLine(Tokenizer->At[0]))
+    while(CharAt(Tokenizer, 0) && !IsEndOfLine(CharAt(Tokenizer, 0)))
         ++Tokenizer->At;
 
     Token.Type = Token_String;
     Token.TextLength = Tokenizer->At - Token.Text;
 
+    return Token;
+}
+
+std::string GetTextTilEndOfLine(tokenizer *Tokenizer)
+{
+    token Token = GetTokenTilEndOfLine(Tokenizer);
     return std::string(Token.Text, Token.TextLength);
 }
 
+token PeekToken(tokenizer *Tokenizer)
+{
+    tokenizer Peek = *Tokenizer;
+    return GetToken(&Peek);
+}
+
+/* NOTE: Returns the text up to the next Delim, or the end of the text, as a view into the buffer
+         of the tokenizer. Empty pieces between two delimiters are returned as well. Returns false
+         once the text has been consumed. */
+bool GetDelimitedToken(tokenizer *Tokenizer, char Delim, token *Token)
+{
+    if(!CharAt(Tokenizer, 0))
+        return false;
+
+    Token->Type = Token_String;
+    Token->Text = Tokenizer->At;
+
+    while(CharAt(Tokenizer, 0) && CharAt(Tokenizer, 0) != Delim)
+        ++Tokenizer->At;
+
+    Token->TextLength = Tokenizer->At - Token->Text;
+    if(CharAt(Tokenizer, 0) == Delim)
+        ++Tokenizer->At;
+
+    return true;
+}
+
 token GetToken(tokenizer *Tokenizer)
 {
     EatAllWhiteSpace(Tokenizer);
@@ -46,12 +92,16 @@ token GetToken(tokenizer *Tokenizer)
     Token.TextLength = 1;
     Token.Text = Tokenizer->At;
 
-    char C = Tokenizer->At[0];
-    ++Tokenizer->At;
+    char C = CharAt(Tokenizer, 0);
+    if(C == '\0')
+    {
+        Token.Type = Token_EndOfStream;
+        return Token;
+    }
 
+    ++Tokenizer->At;
     switch(C)
     {
-        case '\0': { Token.Type = Token_EndOfStream; } break;
         case ':': { Token.Type = Token_Colon; } break;
         case ';': { Token.Type = Token_SemiColon; } break;
         case '=': { Token.Type = Token_Equals; } break;
@@ -65,21 +115,30 @@ token GetToken(tokenizer *Tokenizer)
         case '"':
         {
             Token.Text = Tokenizer->At;
-            while(Tokenizer->At[0] && Tokenizer->At[0] != '"')
+            while(CharAt(Tokenizer, 0) && CharAt(Tokenizer, 0) != '"')
                 ++Tokenizer->At;
 
-            Token.Type = Token_String;
             Token.TextLength = Tokenizer->At - Token.Text;
 
-            if(Tokenizer->At[0] == '"')
+            /* NOTE: A string without its closing quote is rejected, instead of silently
+                     swallowing the rest of the text. */
+            if(CharAt(Tokenizer, 0) == '"')
+            {
+                Token.Type = Token_String;
                 ++Tokenizer->At;
+            }
+            else
+            {
+                Token.Type = Token_Unknown;
+            }
         } break;
         case '#':
         {
-            ++Tokenizer->At;
+            if(CharAt(Tokenizer, 0))
+                ++Tokenizer->At;
             Token.Text = Tokenizer->At;
 
-            while(Tokenizer->At[0] && !IsEndOfLine(Tokenizer->At[0]))
+            while(CharAt(Tokenizer, 0) && !IsEndOfLine(CharAt(Tokenizer, 0)))
                 ++Tokenizer->At;
 
             Token.Type = Token_Comment;
@@ -87,31 +146,31 @@ token GetToken(tokenizer *Tokenizer)
         } break;
         case '/':
         {
-            if(Tokenizer->At[0] == '*')
+            if(CharAt(Tokenizer, 0) == '*')
             {
                 ++Tokenizer->At;
                 Token.Text = Tokenizer->At;
 
-                while(Tokenizer->At[0] &&
-                      Tokenizer->At[1] &&
-                      !((Tokenizer->At[0] == '*') &&
-                        (Tokenizer->At[1] == '/')))
+                while(CharAt(Tokenizer, 0) &&
+                      CharAt(Tokenizer, 1) &&
+                      !((CharAt(Tokenizer, 0) == '*') &&
+                        (CharAt(Tokenizer, 1) == '/')))
                     ++Tokenizer->At;
 
                 Token.Type = Token_Comment;
                 Token.TextLength = Tokenizer->At - Token.Text;
 
-                if(Tokenizer->At[0] == '*')
+                if(CharAt(Tokenizer, 0) == '*')
                     ++Tokenizer->At;
-                if(Tokenizer->At[0] == '/')
+                if(CharAt(Tokenizer, 0) == '/')
                     ++Tokenizer->At;
             }
-            else if(Tokenizer->At[0] == '/')
+            else if(CharAt(Tokenizer, 0) == '/')
             {
                 ++Tokenizer->At;
                 Token.Text = Tokenizer->At;
 
-                while(Tokenizer->At[0] && !IsEndOfLine(Tokenizer->At[0]))
+                while(CharAt(Tokenizer, 0) && !IsEndOfLine(CharAt(Tokenizer, 0)))
                     ++Tokenizer->At;
 
                 Token.Type = Token_Comment;
@@ -126,10 +185,10 @@ token GetToken(tokenizer *Tokenizer)
         {
             if(IsAlpha(C))
             {
-                while(IsAlpha(Tokenizer->At[0]) ||
-                      IsNumeric(Tokenizer->At[0]) ||
-                      (Tokenizer->At[0] == '+') ||
-                      (Tokenizer->At[0] == '_'))
+                while(IsAlpha(CharAt(Tokenizer, 0)) ||
+                      IsNumeric(CharAt(Tokenizer, 0)) ||
+                      (CharAt(Tokenizer, 0) == '+') ||
+                      (CharAt(Tokenizer, 0) == '_'))
                     ++Tokenizer->At;
 
                 Token.Type = Token_Identifier;
@@ -137,10 +196,10 @@ token GetToken(tokenizer *Tokenizer)
             }
             else if(IsNumeric(C))
             {
-                if(C == '0' && (Tokenizer->At[0] == 'x' || Tokenizer->At[0] == 'X'))
+                if(C == '0' && (CharAt(Tokenizer, 0) == 'x' || CharAt(Tokenizer, 0) == 'X'))
                 {
                     ++Tokenizer->At;
-                    while(IsHexadecimal(Tokenizer->At[0]))
+                    while(IsHexadecimal(CharAt(Tokenizer, 0)))
                         ++Tokenizer->At;
 
                     Token.Type = Token_Hex;
@@ -148,8 +207,8 @@ token GetToken(tokenizer *Tokenizer)
                 }
                 else
                 {
-                    while(IsNumeric(Tokenizer->At[0]) ||
-                          IsDot(Tokenizer->At[0]))
+                    while(IsNumeric(CharAt(Tokenizer, 0)) ||
+                          IsDot(CharAt(Tokenizer, 0)))
                         ++Tokenizer->At;
 
                     Token.Type = Token_Digit;
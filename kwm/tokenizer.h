@@ -35,9 +35,12 @@ struct token
     char *Text;
 };
 
+/* NOTE: A tokenizer with an End treats End as the end of the text, so that a token view
+         into a larger buffer can be tokenized on its own. A NULL End reads up to '\0'. */
 struct tokenizer
 {
     char *At;
+    char *End;
 };
 
 inline bool
@@ -105,7 +108,21 @@ TokenEquals(token Token, const char *Match)
     return Result;
 }
 
+/* NOTE: Strip trailing whitespace from a token without copying the underlying text. */
+inline token
+TrimToken(token Token)
+{
+    while((Token.TextLength > 0) &&
+          (IsWhiteSpace(Token.Text[Token.TextLength - 1])))
+        --Token.TextLength;
+
+    return Token;
+}
+
 std::string GetTextTilEndOfLine(tokenizer *Tokenizer);
+token GetTokenTilEndOfLine(tokenizer *Tokenizer);
+token PeekToken(tokenizer *Tokenizer);
+bool GetDelimitedToken(tokenizer *Tokenizer, char Delim, token *Token);
 token GetToken(tokenizer *Tokenizer);
 bool RequireToken(tokenizer *Tokenizer, token_type DesiredType);
 
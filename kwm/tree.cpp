@@ -10,32 +10,20 @@
 #include "../axlib/axlib.h"
 
 #define internal static
-extern std::map<std::string, space_info> WindowTree;
 
-/* NOTE(koekeishiya): Should not be able to return null as the binary-tree is always proper. */
-tree_node * FindFirstMinDepthLeafNode(tree_node *Root)
+void SetTreeNodeDepth(tree_node *Node, uint32_t Depth)
 {
-    std::queue<tree_node *> Queue;
-    Queue.push(Root);
-
-    while(!Queue.empty())
+    if(Node)
     {
-        tree_node *Node = Queue.front();
-        Queue.pop();
-
-        if(IsLeafNode(Node))
-            return Node;
-
-        if(Node->LeftChild)
-            Queue.push(Node->LeftChild);
-
-        if(Node->RightChild)
-            Queue.push(Node->RightChild);
+        Node->Depth = Depth;
+        SetTreeNodeDepth(Node->LeftChild, Depth + 1);
+        SetTreeNodeDepth(Node->RightChild, Depth + 1);
     }
-
-    return NULL;
 }
 
+/* NOTE: Splitting the first min-depth leaf removes it from the front of the breadth-first
+         order and appends its two children at the back, so a FIFO queue of leaves
+         yields every insertion point in constant time. */
 internal bool
 CreateBSPTree(tree_node *RootNode, ax_display *Display, std::vector<uint32_t> *WindowsPtr)
 {
@@ -44,15 +32,22 @@ CreateBSPTree(tree_node *RootNode, ax_display *Display, std::vector<uint32_t> *W
 
     if(!Windows.empty())
     {
-        tree_node *Root = RootNode;
-        Root->WindowID = Windows[0];
+        std::deque<tree_node *> Leaves;
+        Leaves.push_back(RootNode);
+
+        RootNode->WindowID = Windows[0];
         for(std::size_t Index = 1; Index < Windows.size(); ++Index)
         {
-            Root = FindFirstMinDepthLeafNode(RootNode);
-            Assert(Root != NULL);
+            tree_node *Root = Leaves.front();
+            Leaves.pop_front();
 
             DEBUG("CreateBSPTree() Create pair of leafs");
             CreateLeafNodePair(Display, Root, Root->WindowID, Windows[Index], GetOptimalSplitMode(Root));
+            if(!IsLeafNode(Root))
+            {
+                Leaves.push_back(Root->LeftChild);
+                Leaves.push_back(Root->RightChild);
+            }
         }
 
         Result = true;
@@ -99,7 +94,7 @@ tree_node *CreateTreeFromWindowIDList(ax_display *Display, std::vector<uint32_t>
     SetRootNodeContainer(Display, RootNode);
     bool Result = false;
 
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->Settings.Mode == SpaceModeBSP)
         Result = CreateBSPTree(RootNode, Display, Windows);
     else if(SpaceInfo->Settings.Mode == SpaceModeMonocle)
@@ -127,20 +122,13 @@ tree_node *GetNearestLeafNodeNeighbour(tree_node *Node)
  * every leaf node. */
 tree_node *GetTreeNodeForPoint(tree_node *Node, CGPoint *Point)
 {
-    if(Node)
+    for(tree_node *CurrentNode : TreeLeaves(Node))
     {
-        tree_node *CurrentNode = NULL;
-        GetFirstLeafNode(Node, (void**)&CurrentNode);
-        while(CurrentNode)
-        {
-            if(Point->x >= CurrentNode->Container.X &&
-               Point->x <= CurrentNode->Container.X + CurrentNode->Container.Width &&
-               Point->y >= CurrentNode->Container.Y &&
-               Point->y <= CurrentNode->Container.Y + CurrentNode->Container.Height)
-                return CurrentNode;
-
-            CurrentNode = GetNearestTreeNodeToTheRight(CurrentNode);
-        }
+        if(Point->x >= CurrentNode->Container.X &&
+           Point->x <= CurrentNode->Container.X + CurrentNode->Container.Width &&
+           Point->y >= CurrentNode->Container.Y &&
+           Point->y <= CurrentNode->Container.Y + CurrentNode->Container.Height)
+            return CurrentNode;
     }
 
     return NULL;
@@ -148,17 +136,10 @@ tree_node *GetTreeNodeForPoint(tree_node *Node, CGPoint *Point)
 
 tree_node *GetTreeNodeFromWindowID(tree_node *Node, uint32_t WindowID)
 {
-    if(Node)
+    for(tree_node *CurrentNode : TreeLeaves(Node))
     {
-        tree_node *CurrentNode = NULL;
-        GetFirstLeafNode(Node, (void**)&CurrentNode);
-        while(CurrentNode)
-        {
-            if(CurrentNode->WindowID == WindowID)
-                return CurrentNode;
-
-            CurrentNode = GetNearestTreeNodeToTheRight(CurrentNode);
-        }
+        if(CurrentNode->WindowID == WindowID)
+            return CurrentNode;
     }
 
     return NULL;
@@ -179,18 +160,11 @@ tree_node *GetTreeNodeFromWindowIDOrLinkNode(tree_node *Node, uint32_t WindowID)
 
 link_node *GetLinkNodeFromWindowID(tree_node *Root, uint32_t WindowID)
 {
-    if(Root)
+    for(tree_node *Node : TreeLeaves(Root))
     {
-        tree_node *Node = NULL;
-        GetFirstLeafNode(Root, (void**)&Node);
-        while(Node)
-        {
-            link_node *Link = GetLinkNodeFromTree(Node, WindowID);
-            if(Link)
-                return Link;
-
-            Node = GetNearestTreeNodeToTheRight(Node);
-        }
+        link_node *Link = GetLinkNodeFromTree(Node, WindowID);
+        if(Link)
+            return Link;
     }
 
     return NULL;
@@ -231,52 +205,79 @@ tree_node *GetTreeNodeFromLink(tree_node *Root, link_node *Link)
     return NULL;
 }
 
+/* NOTE: For a node that is not a leaf, this is the nearest leaf to the left of its subtree. */
 tree_node *GetNearestTreeNodeToTheLeft(tree_node *Node)
 {
     if(Node)
     {
-        if(Node->Parent)
-        {
-            tree_node *Root = Node->Parent;
-            if(Root->LeftChild == Node)
-                return GetNearestTreeNodeToTheLeft(Root);
-
-            if(IsLeafNode(Root->LeftChild))
-                return Root->LeftChild;
+        while(Node->LeftChild)
+            Node = Node->LeftChild;
 
-            Root = Root->LeftChild;
-            while(!IsLeafNode(Root->RightChild))
-                Root = Root->RightChild;
-
-            return Root->RightChild;
-        }
+        return Node->PrevLeaf;
     }
 
     return NULL;
 }
 
+/* NOTE: For a node that is not a leaf, this is the nearest leaf to the right of its subtree. */
 tree_node *GetNearestTreeNodeToTheRight(tree_node *Node)
 {
     if(Node)
     {
-        if(Node->Parent)
-        {
-            tree_node *Root = Node->Parent;
-            if(Root->RightChild == Node)
-                return GetNearestTreeNodeToTheRight(Root);
+        while(Node->RightChild)
+            Node = Node->RightChild;
 
-            if(IsLeafNode(Root->RightChild))
-                return Root->RightChild;
+        return Node->NextLeaf;
+    }
 
-            Root = Root->RightChild;
-            while(!IsLeafNode(Root->LeftChild))
-                Root = Root->LeftChild;
+    return NULL;
+}
 
-            return Root->LeftChild;
-        }
+internal void
+ThreadLeafNode(tree_node *Node, tree_node **Last)
+{
+    if(IsLeafNode(Node))
+    {
+        Node->PrevLeaf = *Last;
+        if(*Last)
+            (*Last)->NextLeaf = Node;
+
+        *Last = Node;
     }
+    else
+    {
+        Node->PrevLeaf = NULL;
+        Node->NextLeaf = NULL;
 
-    return NULL;
+        if(Node->LeftChild)
+            ThreadLeafNode(Node->LeftChild, Last);
+
+        if(Node->RightChild)
+            ThreadLeafNode(Node->RightChild, Last);
+    }
+}
+
+/* NOTE: Threads the leaves of the subtree Node in order, between Prev and Next.
+         Must be called after any change to the shape of a tree, with the leaves
+         that used to surround the subtree; NULL when it is the edge of the tree. */
+void ThreadLeafNodes(tree_node *Node, tree_node *Prev, tree_node *Next)
+{
+    if(Node)
+    {
+        tree_node *Last = Prev;
+        ThreadLeafNode(Node, &Last);
+
+        Last->NextLeaf = Next;
+        if(Next)
+            Next->PrevLeaf = Last;
+    }
+}
+
+/* NOTE: The leaves that surround the subtree Node, for use with ThreadLeafNodes(..). */
+void GetSurroundingLeafNodes(tree_node *Node, tree_node **Prev, tree_node **Next)
+{
+    *Prev = GetNearestTreeNodeToTheLeft(Node);
+    *Next = GetNearestTreeNodeToTheRight(Node);
 }
 
 void GetFirstLeafNode(tree_node *Node, void **Result)
@@ -296,6 +297,15 @@ void GetFirstLeafNode(tree_node *Node, void **Result)
     }
 }
 
+tree_leaf_range TreeLeaves(tree_node *Root)
+{
+    tree_leaf_range Result = { Root };
+    while(Result.First && Result.First->LeftChild)
+        Result.First = Result.First->LeftChild;
+
+    return Result;
+}
+
 void GetLastLeafNode(tree_node *Node, void **Result)
 {
     if(Node)
@@ -322,7 +332,7 @@ void FocusFirstLeafNode(ax_display *Display)
 {
     if(Display)
     {
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
         if(!SpaceInfo->RootNode)
             return;
 
@@ -346,7 +356,7 @@ void FocusLastLeafNode(ax_display *Display)
 {
     if(Display)
     {
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
         if(!SpaceInfo->RootNode)
             return;
 
@@ -371,12 +381,13 @@ void FocusLastLeafNode(ax_display *Display)
 
 tree_node *GetFirstPseudoLeafNode(tree_node *Node)
 {
-    tree_node *Leaf = NULL;
-    GetFirstLeafNode(Node, (void**)&Leaf);
-    while(Leaf && Leaf->WindowID != 0)
-        Leaf = GetNearestTreeNodeToTheRight(Leaf);
+    for(tree_node *Leaf : TreeLeaves(Node))
+    {
+        if(Leaf->WindowID == 0)
+            return Leaf;
+    }
 
-    return Leaf;
+    return NULL;
 }
 
 void ApplyLinkNodeContainer(link_node *Link)
@@ -466,10 +477,12 @@ RotateTree(tree_node *Node, int Deg)
 void RotateBSPTree(int Deg)
 {
     ax_display *Display = AXLibMainDisplay();
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->Settings.Mode == SpaceModeBSP)
     {
+        InvalidateMinDepthLeaves(SpaceInfo);
         RotateTree(SpaceInfo->RootNode, Deg);
+        ThreadLeafNodes(SpaceInfo->RootNode, NULL, NULL);
         CreateNodeContainers(Display, SpaceInfo->RootNode, false);
         ApplyTreeNodeContainer(SpaceInfo->RootNode);
     }
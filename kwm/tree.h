@@ -4,10 +4,35 @@
 #include "types.h"
 #include "../axlib/display.h"
 
+/* NOTE: Walks the threaded leaf list in order, see ThreadLeafNodes(..).
+         for(tree_node *Leaf : TreeLeaves(SpaceInfo->RootNode)) { .. } */
+struct tree_leaf_iterator
+{
+    tree_node *Node;
+
+    tree_node *operator*() const { return Node; }
+    tree_leaf_iterator &operator++() { Node = Node->NextLeaf; return *this; }
+    bool operator!=(const tree_leaf_iterator &Other) const { return Node != Other.Node; }
+};
+
+struct tree_leaf_range
+{
+    tree_node *First;
+
+    tree_leaf_iterator begin() const { tree_leaf_iterator Result = { First }; return Result; }
+    tree_leaf_iterator end() const { tree_leaf_iterator Result = { NULL }; return Result; }
+};
+
 tree_node *CreateTreeFromWindowIDList(ax_display *Display, std::vector<uint32_t> *Windows);
 void FillDeserializedTree(tree_node *RootNode, ax_display *Display, std::vector<uint32_t> *WindowsPtr);
 void RotateBSPTree(int Deg);
-tree_node * FindFirstMinDepthLeafNode(tree_node *Root);
+uint32_t NextTreeGeneration();
+tree_node *FindFirstMinDepthLeafNode(space_info *Space);
+void AddMinDepthLeafPair(space_info *Space, tree_node *Parent);
+void AddMinDepthLeaves(space_info *Space, tree_node *Node);
+void RemoveMinDepthLeaves(space_info *Space, tree_node *Node);
+void InvalidateMinDepthLeaves(space_info *Space);
+void SetTreeNodeDepth(tree_node *Node, uint32_t Depth);
 tree_node *GetNearestLeafNodeNeighbour(tree_node *Node);
 tree_node *GetTreeNodeForPoint(tree_node *Node, CGPoint *Point);
 tree_node *GetTreeNodeFromWindowID(tree_node *Node, uint32_t WindowID);
@@ -17,7 +42,10 @@ link_node *GetLinkNodeFromTree(tree_node *Root, uint32_t WindowID);
 tree_node *GetTreeNodeFromLink(tree_node *Root, link_node *Link);
 tree_node *GetNearestTreeNodeToTheLeft(tree_node *Node);
 tree_node *GetNearestTreeNodeToTheRight(tree_node *Node);
+void ThreadLeafNodes(tree_node *Node, tree_node *Prev, tree_node *Next);
+void GetSurroundingLeafNodes(tree_node *Node, tree_node **Prev, tree_node **Next);
 void GetFirstLeafNode(tree_node *Node, void **Result);
+tree_leaf_range TreeLeaves(tree_node *Root);
 void GetLastLeafNode(tree_node *Node, void **Result);
 void FocusFirstLeafNode(ax_display *Display);
 void FocusLastLeafNode(ax_display *Display);
@@ -6,8 +6,10 @@
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <deque>
 #include <stack>
 #include <map>
+#include <set>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -76,6 +78,16 @@ enum space_tiling_option
     SpaceModeDefault
 };
 
+/* NOTE: When the trees of spaces that are not active are built. Lazy builds a tree the
+         first time its space becomes active. Eager builds every tree at startup, and
+         idle builds one tree every time the event-loop has drained its queue. */
+enum space_prewarm_option
+{
+    SpacePrewarmLazy,
+    SpacePrewarmEager,
+    SpacePrewarmIdle
+};
+
 enum split_type
 {
     SPLIT_NONE = 0,
@@ -166,8 +178,28 @@ struct tree_node
     tree_node *LeftChild;
     tree_node *RightChild;
 
+    /* NOTE: Threads every leaf of the tree from left to right.
+             Both are NULL for nodes that are not leaves. */
+    tree_node *PrevLeaf;
+    tree_node *NextLeaf;
+
     split_type SplitMode;
     double SplitRatio;
+
+    /* NOTE: Order is the position among the nodes of the same depth, from left to right. Both
+             are only kept current while the tree has a valid set of min-depth leaves. */
+    uint32_t Depth;
+    uint64_t Order;
+
+    /* NOTE: Set on root nodes only, see NextTreeGeneration(). */
+    uint32_t Generation;
+};
+
+/* NOTE: Orders leaves by depth first, and from left to right within the same depth,
+         which is the order in which a breadth-first search would visit them. */
+struct min_depth_leaf_order
+{
+    bool operator()(const tree_node *A, const tree_node *B) const;
 };
 
 struct window_properties
@@ -177,6 +209,7 @@ struct window_properties
     int Float;
     int Scratchpad;
     std::string Role;
+    uint32_t RoleID;
 };
 
 struct window_rule
@@ -187,9 +220,17 @@ struct window_rule
     std::string Name;
     std::string Role;
     std::string CustomRole;
+
+    uint32_t RoleID;
+    uint32_t CustomRoleID;
+
+    std::map<uint32_t, bool> OwnerMatches;
+    std::map<uint32_t, bool> NameMatches;
+    std::map<uint32_t, bool> ExceptMatches;
 };
 
 struct ax_window;
+struct ax_string;
 struct scratchpad
 {
     std::map<int, ax_window *> Windows;
@@ -202,7 +243,7 @@ struct space_settings
     space_tiling_option Mode;
     CGSize FloatDim;
     std::string Layout;
-    std::string Name;
+    ax_string *Name;
 };
 
 struct space_info
@@ -211,7 +252,18 @@ struct space_info
     bool ResolutionChanged;
     bool Initialized;
 
+    /* NOTE: Set when RootNode was built while the space was not active. The windows
+             are moved into their containers once the space becomes active. */
+    bool Prewarmed;
+
     tree_node *RootNode;
+
+    /* NOTE: Leaves of RootNode in min_depth_leaf_order. Only valid while
+             MinDepthLeavesGeneration equals the generation of RootNode, and
+             rebuilt on demand otherwise. A root allocated at the address of
+             a freed one has a new generation, so it cannot reuse a stale set. */
+    std::set<tree_node *, min_depth_leaf_order> MinDepthLeaves;
+    uint32_t MinDepthLeavesGeneration;
 };
 
 struct kwm_mach
@@ -221,6 +273,15 @@ struct kwm_mach
     CGEventMask EventMask;
 };
 
+struct border_state
+{
+    bool Visible;
+    CGRect Frame;
+    color Color;
+    double Width;
+    double Radius;
+};
+
 struct kwm_border
 {
     bool Enabled;
@@ -230,6 +291,14 @@ struct kwm_border
     double Radius;
     color Color;
     double Width;
+
+    /* NOTE: Requested is the state at the end of the current batch of events,
+             Submitted is the state that the overlay is currently showing. The frame of
+             a border that follows a window is read again when it is submitted. */
+    border_state Requested;
+    border_state Submitted;
+    uint32_t WindowID;
+    bool Queued;
 };
 
 struct kwm_path
@@ -248,6 +317,7 @@ struct kwm_settings
     space_tiling_option Space;
     cycle_focus_option Cycle;
     focus_option Focus;
+    space_prewarm_option Prewarm;
 
     container_offset DefaultOffset;
     split_type SplitMode;
@@ -255,6 +325,9 @@ struct kwm_settings
     double OptimalRatio;
     uint32_t Flags;
 
+    /* NOTE: Commits per second while dragging; 0 follows the refresh rate of the display. */
+    double DragRate;
+
     std::map<unsigned int, space_settings> DisplaySettings;
     std::map<space_identifier, space_settings> SpaceSettings;
     std::vector<window_rule> WindowRules;
@@ -10,6 +10,8 @@
 #include "serializer.h"
 #include "cursor.h"
 #include "scratchpad.h"
+#include "daemon.h"
+#include "query.h"
 #include "../axlib/axlib.h"
 
 #include <cmath>
@@ -17,7 +19,6 @@
 #define internal static
 #define local_persist static
 
-extern std::map<std::string, space_info> WindowTree;
 extern ax_display *FocusedDisplay;
 extern ax_application *FocusedApplication;
 extern ax_window *MarkedWindow;
@@ -26,6 +27,9 @@ extern kwm_settings KWMSettings;
 extern kwm_border MarkedBorder;
 extern kwm_border FocusedBorder;
 
+internal bool DeferWindowDimensions = false;
+internal std::map<uint32_t, CGRect> DeferredWindowDimensions;
+
 internal void
 DrawFocusedBorder(ax_display *Display, ax_window *Window)
 {
@@ -40,6 +44,48 @@ DrawFocusedBorder(ax_display *Display, ax_window *Window)
     }
 }
 
+/* NOTE: Redraw any border that follows this window. */
+internal void
+UpdateWindowBorders(ax_window *Window)
+{
+    if((FocusedApplication == Window->Application) &&
+       (FocusedApplication->Focus == Window))
+        DrawFocusedBorder(AXLibWindowDisplay(Window), Window);
+
+    if(MarkedWindow == Window)
+        UpdateBorder(&MarkedBorder, Window);
+}
+
+internal inline std::string
+DesktopIDOfDisplay(ax_display *Display)
+{
+    return std::to_string(AXLibDesktopIDFromCGSSpaceID(Display, Display->Space->ID));
+}
+
+internal void
+NotifyFocusChanged(ax_window *Window)
+{
+    KwmNotify(NotifyTopic_Focus, "focus " + std::to_string(Window ? Window->ID : 0));
+}
+
+internal void
+NotifySpaceChanged(ax_display *Display)
+{
+    KwmNotify(NotifyTopic_Space, "space " + DesktopIDOfDisplay(Display));
+}
+
+internal void
+NotifyWindowChanged(const char *Change, uint32_t WindowID)
+{
+    KwmNotify(NotifyTopic_Window, std::string("window ") + Change + " " + std::to_string(WindowID));
+}
+
+void NotifyLayoutChanged(ax_display *Display)
+{
+    if(Display)
+        KwmNotify(NotifyTopic_Layout, "layout " + DesktopIDOfDisplay(Display));
+}
+
 internal bool
 FloatNextWindow(ax_display *Display, ax_window *Window)
 {
@@ -104,6 +150,7 @@ TileWindow(ax_display *Display, ax_window *Window)
            (!AXLibStickyWindow(Window)))
         {
             AddWindowToNodeTree(Display, Window->ID);
+            NotifyLayoutChanged(Display);
         }
     }
 }
@@ -118,11 +165,13 @@ ClearBorderIfFullscreenSpace(ax_display *Display)
 /* TODO(koekeishiya): Event context is a pointer to the new display. */
 EVENT_CALLBACK(Callback_AXEvent_DisplayAdded)
 {
+    KwmInvalidateSnapshot(Snapshot_All);
     DEBUG("AXEvent_DisplayAdded");
 }
 
 EVENT_CALLBACK(Callback_AXEvent_DisplayRemoved)
 {
+    KwmInvalidateSnapshot(Snapshot_All);
     DEBUG("AXEvent_DisplayRemoved");
 }
 
@@ -133,7 +182,7 @@ ResizeDisplay(ax_display *Display)
     for(It = Display->Spaces.begin(); It != Display->Spaces.end(); ++It)
     {
         ax_space *Space = &It->second;
-        space_info *SpaceInfo = &WindowTree[Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Space);
         if(Space == Display->Space)
             UpdateSpaceOfDisplay(Display, SpaceInfo);
         else
@@ -144,6 +193,7 @@ ResizeDisplay(ax_display *Display)
 /* NOTE(koekeishiya): Event context is a pointer to the resized display. */
 EVENT_CALLBACK(Callback_AXEvent_DisplayResized)
 {
+    KwmInvalidateSnapshot(Snapshot_All);
     ax_display *Display = (ax_display *) Event->Context;
     DEBUG("AXEvent_DisplayResized");
     ResizeDisplay(Display);
@@ -152,6 +202,7 @@ EVENT_CALLBACK(Callback_AXEvent_DisplayResized)
 /* NOTE(koekeishiya): Event context is a pointer to the moved display. */
 EVENT_CALLBACK(Callback_AXEvent_DisplayMoved)
 {
+    KwmInvalidateSnapshot(Snapshot_All);
     ax_display *Display = (ax_display *) Event->Context;
     DEBUG("AXEvent_DisplayMoved");
     ResizeDisplay(Display);
@@ -160,6 +211,7 @@ EVENT_CALLBACK(Callback_AXEvent_DisplayMoved)
 /* NOTE(koekeishiya): Event context is NULL. */
 EVENT_CALLBACK(Callback_AXEvent_DisplayChanged)
 {
+    KwmInvalidateSnapshot(Snapshot_All);
     ax_display *CurrentDisplay = AXLibMainDisplay();
     if(CurrentDisplay->ID != FocusedDisplay->ID)
     {
@@ -176,6 +228,9 @@ EVENT_CALLBACK(Callback_AXEvent_DisplayChanged)
         CreateWindowNodeTree(FocusedDisplay);
         RebalanceNodeTree(FocusedDisplay);
 
+        NotifySpaceChanged(FocusedDisplay);
+        NotifyLayoutChanged(FocusedDisplay);
+
         ClearBorderIfFullscreenSpace(FocusedDisplay);
     }
 }
@@ -183,6 +238,7 @@ EVENT_CALLBACK(Callback_AXEvent_DisplayChanged)
 /* NOTE(koekeishiya): Event context is a pointer to the display whos space was changed. */
 EVENT_CALLBACK(Callback_AXEvent_SpaceChanged)
 {
+    KwmInvalidateSnapshot(Snapshot_All);
     ax_display *Display = (ax_display *) Event->Context;
     DEBUG("AXEvent_SpaceChanged");
 
@@ -194,7 +250,7 @@ EVENT_CALLBACK(Callback_AXEvent_SpaceChanged)
     ClearMarkedWindow();
 
     FocusedDisplay = Display;
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     AXLibRunningApplications();
     CreateWindowNodeTree(Display);
@@ -202,6 +258,9 @@ EVENT_CALLBACK(Callback_AXEvent_SpaceChanged)
     if(SpaceInfo->ResolutionChanged)
         UpdateSpaceOfDisplay(Display, SpaceInfo);
 
+    NotifySpaceChanged(Display);
+    NotifyLayoutChanged(Display);
+
     /* NOTE(koekeishiya): If we trigger a space changed event through cmd+tab, we receive the 'didApplicationActivate'
                           notification before the 'didActiveSpaceChange' notification. If a space has not been visited
                           before, this will cause us to end up on that space with an unsynchronized focused application state.
@@ -220,6 +279,7 @@ EVENT_CALLBACK(Callback_AXEvent_SpaceChanged)
             AXLibSetFocusedWindow(Window);
             DrawFocusedBorder(Display, Window);
             MoveCursorToCenterOfWindow(Window);
+            NotifyFocusChanged(Window);
         }
         else
         {
@@ -240,6 +300,7 @@ EVENT_CALLBACK(Callback_AXEvent_SpaceChanged)
                 DrawFocusedBorder(Display, FocusedApplication->Focus);
                 MoveCursorToCenterOfWindow(FocusedApplication->Focus);
                 Display->Space->FocusedWindow = FocusedApplication->Focus->ID;
+                NotifyFocusChanged(FocusedApplication->Focus);
             }
         }
     }
@@ -250,13 +311,14 @@ EVENT_CALLBACK(Callback_AXEvent_SpaceChanged)
 /* NOTE(koekeishiya): Event context is a pointer to the PID of the launched application. */
 EVENT_CALLBACK(Callback_AXEvent_ApplicationLaunched)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Layout | Snapshot_Windows);
     pid_t *ApplicationPID = (pid_t *) Event->Context;
     ax_application *Application = AXLibGetApplicationByPID(*ApplicationPID);
     free(ApplicationPID);
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationLaunched: " << Application->Name);
+        DEBUG("AXEvent_ApplicationLaunched: " << Application->Name->Text);
 
         ax_display *Display = AXLibCursorDisplay();
         for(ax_window_map_iter It = Application->Windows.begin();
@@ -270,19 +332,22 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationLaunched)
             FloatNonResizable(Window);
             TileWindow(Display, Window);
         }
+
+        NotifyLayoutChanged(Display);
     }
 }
 
 /* NOTE(koekeishiya): Event context is a pointer to the PID of the application. */
 EVENT_CALLBACK(Callback_AXEvent_ApplicationHidden)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Marked | Snapshot_Layout | Snapshot_Windows);
     pid_t *ApplicationPID = (pid_t *) Event->Context;
     ax_application *Application = AXLibGetApplicationByPID(*ApplicationPID);
     free(ApplicationPID);
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationHidden: " << Application->Name);
+        DEBUG("AXEvent_ApplicationHidden: " << Application->Name->Text);
 
         for(ax_window_map_iter It = Application->Windows.begin();
             It != Application->Windows.end();
@@ -292,19 +357,22 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationHidden)
             if(AXLibSpaceHasWindow(Window, FocusedDisplay->Space->ID))
                 RemoveWindowFromNodeTree(FocusedDisplay, Window->ID);
         }
+
+        NotifyLayoutChanged(FocusedDisplay);
     }
 }
 
 /* NOTE(koekeishiya): Event context is a pointer to the PID of the application. */
 EVENT_CALLBACK(Callback_AXEvent_ApplicationVisible)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Marked | Snapshot_Layout | Snapshot_Windows);
     pid_t *ApplicationPID = (pid_t *) Event->Context;
     ax_application *Application = AXLibGetApplicationByPID(*ApplicationPID);
     free(ApplicationPID);
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationVisible: " << Application->Name);
+        DEBUG("AXEvent_ApplicationVisible: " << Application->Name->Text);
 
         for(ax_window_map_iter It = Application->Windows.begin();
             It != Application->Windows.end();
@@ -314,12 +382,15 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationVisible)
             if(AXLibSpaceHasWindow(Window, FocusedDisplay->Space->ID))
                 TileWindow(FocusedDisplay, Window);
         }
+
+        NotifyLayoutChanged(FocusedDisplay);
     }
 }
 
 /* NOTE(koekeishiya): Event context is NULL */
 EVENT_CALLBACK(Callback_AXEvent_ApplicationTerminated)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Marked | Snapshot_Layout | Snapshot_Windows);
     pid_t *ApplicationPID = (pid_t *) Event->Context;
     ax_application *Application = AXLibGetApplicationByPID(*ApplicationPID);
     free(ApplicationPID);
@@ -333,11 +404,12 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationTerminated)
         ax_display *Display = AXLibMainDisplay();
         Assert(Display != NULL);
         RebalanceNodeTree(Display);
+        NotifyLayoutChanged(Display);
 
        if(FocusedApplication == Application)
            ClearBorder(&FocusedBorder);
 
-        ax_application_map *Applications = BeginAXLibApplications();
+        ax_application_map *Applications = BeginAXLibApplicationsWrite();
         Applications->erase(Application->PID);
         EndAXLibApplications();
 
@@ -348,13 +420,14 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationTerminated)
 /* NOTE(koekeishiya): Event context is a pointer to the PID of the activated application. */
 EVENT_CALLBACK(Callback_AXEvent_ApplicationActivated)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus);
     pid_t *ApplicationPID = (pid_t *) Event->Context;
     ax_application *Application = AXLibGetApplicationByPID(*ApplicationPID);
     free(ApplicationPID);
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationActivated: " << Application->Name);
+        DEBUG("AXEvent_ApplicationActivated: " << Application->Name->Text);
 
         FocusedApplication = Application;
         if(Application->Focus)
@@ -365,6 +438,7 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationActivated)
                 StandbyOnFloat(Application->Focus);
                 DrawFocusedBorder(Display, Application->Focus);
                 Display->Space->FocusedWindow = Application->Focus->ID;
+                NotifyFocusChanged(Application->Focus);
             }
         }
     }
@@ -373,6 +447,7 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationActivated)
 /* NOTE(koekeishiya): Event context is a pointer to the CGWindowID of the new window. */
 EVENT_CALLBACK(Callback_AXEvent_WindowCreated)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Marked | Snapshot_Layout | Snapshot_Windows);
     uint32_t *WindowID = (uint32_t *) Event->Context;
     ax_window *Window = GetWindowByID(*WindowID);
     free(WindowID);
@@ -380,10 +455,11 @@ EVENT_CALLBACK(Callback_AXEvent_WindowCreated)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowCreated: " << Window->Application->Name << " - " << Window->Name);
+            DEBUG("AXEvent_WindowCreated: " << Window->Application->Name->Text << " - " << Window->Name->Text);
         else
-            DEBUG("AXEvent_WindowCreated: " << Window->Application->Name << " - [Unknown]");
+            DEBUG("AXEvent_WindowCreated: " << Window->Application->Name->Text << " - [Unknown]");
 
+        NotifyWindowChanged("created", Window->ID);
         if(ApplyWindowRules(Window))
             return;
 
@@ -394,6 +470,7 @@ EVENT_CALLBACK(Callback_AXEvent_WindowCreated)
             if(!FloatNextWindow(Display, Window))
             {
                 TileWindow(Display, Window);
+                NotifyLayoutChanged(Display);
             }
         }
     }
@@ -403,6 +480,7 @@ EVENT_CALLBACK(Callback_AXEvent_WindowCreated)
                       Must call AXLibRemoveApplicationWindow() and AXLibDestroyWindow() */
 EVENT_CALLBACK(Callback_AXEvent_WindowDestroyed)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Marked | Snapshot_Layout | Snapshot_Windows);
     uint32_t *WindowID = (uint32_t *) Event->Context;
     ax_window *Window = GetWindowByID(*WindowID);
     free(WindowID);
@@ -410,15 +488,18 @@ EVENT_CALLBACK(Callback_AXEvent_WindowDestroyed)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowDestroyed: " << Window->Application->Name << " - " << Window->Name);
+            DEBUG("AXEvent_WindowDestroyed: " << Window->Application->Name->Text << " - " << Window->Name->Text);
         else
-            DEBUG("AXEvent_WindowDestroyed: " << Window->Application->Name << " - [Unknown]");
+            DEBUG("AXEvent_WindowDestroyed: " << Window->Application->Name->Text << " - [Unknown]");
 
         ax_display *Display = AXLibWindowDisplay(Window);
         RemoveWindowFromScratchpad(Window);
         RemoveWindowFromNodeTree(Display, Window->ID);
         RebalanceNodeTree(Display);
 
+        NotifyWindowChanged("destroyed", Window->ID);
+        NotifyLayoutChanged(Display);
+
         if(FocusedApplication == Window->Application)
         {
             if(FocusedApplication->Focus == Window)
@@ -439,6 +520,7 @@ EVENT_CALLBACK(Callback_AXEvent_WindowDestroyed)
 /* NOTE(koekeishiya): Event context is a pointer to the CGWindowID of the minimized window. */
 EVENT_CALLBACK(Callback_AXEvent_WindowMinimized)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Marked | Snapshot_Layout | Snapshot_Windows);
     uint32_t *WindowID = (uint32_t *) Event->Context;
     ax_window *Window = GetWindowByID(*WindowID);
     free(WindowID);
@@ -446,12 +528,13 @@ EVENT_CALLBACK(Callback_AXEvent_WindowMinimized)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowMinimized: " << Window->Application->Name << " - " << Window->Name);
+            DEBUG("AXEvent_WindowMinimized: " << Window->Application->Name->Text << " - " << Window->Name->Text);
         else
-            DEBUG("AXEvent_WindowMinimized: " << Window->Application->Name << " - [Unknown]");
+            DEBUG("AXEvent_WindowMinimized: " << Window->Application->Name->Text << " - [Unknown]");
 
         ax_display *Display = AXLibWindowDisplay(Window);
         RemoveWindowFromNodeTree(Display, Window->ID);
+        NotifyLayoutChanged(Display);
 
         ClearBorder(&FocusedBorder);
         if(MarkedWindow == Window)
@@ -462,6 +545,7 @@ EVENT_CALLBACK(Callback_AXEvent_WindowMinimized)
 /* NOTE(koekeishiya): Event context is a pointer to the CGWindowID of the deminimized window. */
 EVENT_CALLBACK(Callback_AXEvent_WindowDeminimized)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Marked | Snapshot_Layout | Snapshot_Windows);
     uint32_t *WindowID = (uint32_t *) Event->Context;
     ax_window *Window = GetWindowByID(*WindowID);
     free(WindowID);
@@ -469,9 +553,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowDeminimized)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowDeminimized: " << Window->Application->Name << " - " << Window->Name);
+            DEBUG("AXEvent_WindowDeminimized: " << Window->Application->Name->Text << " - " << Window->Name->Text);
         else
-            DEBUG("AXEvent_WindowDeminimized: " << Window->Application->Name << " - [Unknown]");
+            DEBUG("AXEvent_WindowDeminimized: " << Window->Application->Name->Text << " - [Unknown]");
 
         ax_display *Display = AXLibWindowDisplay(Window);
         if((AXLibIsWindowStandard(Window) || AXLibIsWindowCustom(Window)) &&
@@ -485,6 +569,7 @@ EVENT_CALLBACK(Callback_AXEvent_WindowDeminimized)
 /* NOTE(koekeishiya): Event context is a pointer to the CGWindowID of the focused window. */
 EVENT_CALLBACK(Callback_AXEvent_WindowFocused)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus);
     uint32_t *WindowID = (uint32_t *) Event->Context;
     ax_window *Window = GetWindowByID(*WindowID);
     free(WindowID);
@@ -492,9 +577,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowFocused)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowFocused: " << Window->Application->Name << " - " << Window->Name);
+            DEBUG("AXEvent_WindowFocused: " << Window->Application->Name->Text << " - " << Window->Name->Text);
         else
-            DEBUG("AXEvent_WindowFocused: " << Window->Application->Name << " - [Unknown]");
+            DEBUG("AXEvent_WindowFocused: " << Window->Application->Name->Text << " - [Unknown]");
 
         if((AXLibIsWindowStandard(Window) || AXLibIsWindowCustom(Window)))
         {
@@ -505,6 +590,7 @@ EVENT_CALLBACK(Callback_AXEvent_WindowFocused)
                 StandbyOnFloat(Window);
                 DrawFocusedBorder(Display, Window);
                 Display->Space->FocusedWindow = Window->ID;
+                NotifyFocusChanged(Window);
             }
         }
     }
@@ -513,6 +599,7 @@ EVENT_CALLBACK(Callback_AXEvent_WindowFocused)
 /* NOTE(koekeishiya): Event context is a pointer to the CGWindowID of the moved window. */
 EVENT_CALLBACK(Callback_AXEvent_WindowMoved)
 {
+    KwmInvalidateSnapshot(Snapshot_Layout);
     uint32_t *WindowID = (uint32_t *) Event->Context;
     ax_window *Window = GetWindowByID(*WindowID);
     free(WindowID);
@@ -520,9 +607,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowMoved)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowMoved: " << Window->Application->Name << " - " << Window->Name);
+            DEBUG("AXEvent_WindowMoved: " << Window->Application->Name->Text << " - " << Window->Name->Text);
         else
-            DEBUG("AXEvent_WindowMoved: " << Window->Application->Name << " - [Unknown]");
+            DEBUG("AXEvent_WindowMoved: " << Window->Application->Name->Text << " - [Unknown]");
 
         if(!Event->Intrinsic)
         {
@@ -531,19 +618,14 @@ EVENT_CALLBACK(Callback_AXEvent_WindowMoved)
                 LockWindowToContainerSize(Window);
         }
 
-        ax_display *Display = AXLibWindowDisplay(Window);
-        if((FocusedApplication == Window->Application) &&
-           (FocusedApplication->Focus == Window))
-            DrawFocusedBorder(Display, Window);
-
-        if(MarkedWindow == Window)
-            UpdateBorder(&MarkedBorder, Window);
+        UpdateWindowBorders(Window);
     }
 }
 
 /* NOTE(koekeishiya): Event context is a pointer to the CGWindowID of the resized window. */
 EVENT_CALLBACK(Callback_AXEvent_WindowResized)
 {
+    KwmInvalidateSnapshot(Snapshot_Layout);
     uint32_t *WindowID = (uint32_t *) Event->Context;
     ax_window *Window = GetWindowByID(*WindowID);
     free(WindowID);
@@ -551,39 +633,56 @@ EVENT_CALLBACK(Callback_AXEvent_WindowResized)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowResized: " << Window->Application->Name << " - " << Window->Name);
+            DEBUG("AXEvent_WindowResized: " << Window->Application->Name->Text << " - " << Window->Name->Text);
         else
-            DEBUG("AXEvent_WindowResized: " << Window->Application->Name << " - [Unknown]");
+            DEBUG("AXEvent_WindowResized: " << Window->Application->Name->Text << " - [Unknown]");
 
         if(!Event->Intrinsic && HasFlags(&KWMSettings, Settings_LockToContainer))
             LockWindowToContainerSize(Window);
 
-        ax_display *Display = AXLibWindowDisplay(Window);
-        if((FocusedApplication == Window->Application) &&
-           (FocusedApplication->Focus == Window))
-            DrawFocusedBorder(Display, Window);
+        UpdateWindowBorders(Window);
+    }
+}
 
-        if(MarkedWindow == Window)
-            UpdateBorder(&MarkedBorder, Window);
+/* NOTE: Event context is a pointer to an ax_window_frame. The cached frame is either the one we
+         requested, or already the corrected one if the echo of the application came first. Any
+         other frame is newer than the correction, which is dropped. */
+EVENT_CALLBACK(Callback_AXEvent_WindowFrameCorrected)
+{
+    ax_window_frame *Frame = (ax_window_frame *) Event->Context;
+    ax_window *Window = GetWindowByID(Frame->ID);
+
+    if((Window) &&
+       ((CGPointEqualToPoint(Window->Position, Frame->Requested.origin)) ||
+        (CGPointEqualToPoint(Window->Position, Frame->Position))) &&
+       ((CGSizeEqualToSize(Window->Size, Frame->Requested.size)) ||
+        (CGSizeEqualToSize(Window->Size, Frame->Size))))
+    {
+        DEBUG("AXEvent_WindowFrameCorrected: " << Window->Application->Name->Text);
+        KwmInvalidateSnapshot(Snapshot_Layout);
+        Window->Position = Frame->Position;
+        Window->Size = Frame->Size;
+        UpdateWindowBorders(Window);
     }
+
+    free(Frame);
 }
 
 /* NOTE(koekeishiya): Event context is a pointer to the CGWindowID of the window. */
 EVENT_CALLBACK(Callback_AXEvent_WindowTitleChanged)
 {
+    KwmInvalidateSnapshot(Snapshot_Focus | Snapshot_Marked | Snapshot_Windows);
     uint32_t *WindowID = (uint32_t *) Event->Context;
     ax_window *Window = GetWindowByID(*WindowID);
     free(WindowID);
 
     if(Window)
     {
-        if(Window->Name)
-        {
-            free(Window->Name);
-            Window->Name = NULL;
-        }
-
-        Window->Name = AXLibGetWindowTitle(Window->Ref);
+        /* NOTE: Titles are interned, so an update that does not actually change
+                 the title is only a lookup and does not allocate. */
+        ax_string *Name = AXLibGetWindowTitle(Window->Ref);
+        AXLibReleaseString(Window->Name);
+        Window->Name = Name;
     }
 }
 
@@ -650,6 +749,7 @@ internal std::vector<ax_window *>
 GetAllAXWindowsNotInTree(ax_display *Display, std::vector<ax_window *> &VisibleWindows, std::vector<uint32_t> &WindowIDsInTree)
 {
     std::vector<ax_window *> Windows;
+    ax_window_spaces WindowSpaces = AXLibSpacesForWindows(Display->Space->ID, &VisibleWindows);
     for(std::size_t WindowIndex = 0; WindowIndex < VisibleWindows.size(); ++WindowIndex)
     {
         bool Found = false;
@@ -664,8 +764,8 @@ GetAllAXWindowsNotInTree(ax_display *Display, std::vector<ax_window *> &VisibleW
         }
 
         if((!Found) &&
-           (AXLibSpaceHasWindow(Window, Display->Space->ID)) &&
-           (!AXLibStickyWindow(Window)))
+           (AXLibWindowSpacesHasWindow(&WindowSpaces, Window->ID)) &&
+           (!AXLibWindowSpacesSticky(&WindowSpaces, Window->ID)))
             Windows.push_back(Window);
     }
 
@@ -677,6 +777,7 @@ GetAllWindowIDSOnDisplay(ax_display *Display)
 {
     std::vector<uint32_t> Windows;
     std::vector<ax_window*> VisibleWindows = AXLibGetAllVisibleWindows();
+    ax_window_spaces WindowSpaces = AXLibSpacesForWindows(Display->Space->ID, &VisibleWindows);
     for(int Index = 0; Index < VisibleWindows.size(); ++Index)
     {
         ax_window *Window = VisibleWindows[Index];
@@ -685,7 +786,7 @@ GetAllWindowIDSOnDisplay(ax_display *Display)
         {
             if(DisplayOfWindow != Display)
             {
-                space_info *SpaceOfWindow = &WindowTree[DisplayOfWindow->Space->Identifier];
+                space_info *SpaceOfWindow = GetSpaceInfo(DisplayOfWindow->Space);
                 if(!SpaceOfWindow->Initialized ||
                    SpaceOfWindow->Settings.Mode == SpaceModeFloating ||
                    GetTreeNodeFromWindowID(SpaceOfWindow->RootNode, Window->ID) ||
@@ -693,8 +794,8 @@ GetAllWindowIDSOnDisplay(ax_display *Display)
                     continue;
             }
 
-            if((AXLibSpaceHasWindow(Window, Display->Space->ID)) &&
-               (!AXLibStickyWindow(Window)))
+            if((AXLibWindowSpacesHasWindow(&WindowSpaces, Window->ID)) &&
+               (!AXLibWindowSpacesSticky(&WindowSpaces, Window->ID)))
                 Windows.push_back(Window->ID);
         }
     }
@@ -732,7 +833,7 @@ AddWindowToBSPTree(ax_display *Display, space_info *SpaceInfo, uint32_t WindowID
             CurrentNode = GetTreeNodeFromWindowIDOrLinkNode(RootNode, Window->ID);
 
         if(!CurrentNode)
-            CurrentNode = FindFirstMinDepthLeafNode(RootNode);
+            CurrentNode = FindFirstMinDepthLeafNode(SpaceInfo);
 
         if(CurrentNode)
         {
@@ -743,6 +844,7 @@ AddWindowToBSPTree(ax_display *Display, space_info *SpaceInfo, uint32_t WindowID
             {
                 split_type SplitMode = KWMSettings.SplitMode == SPLIT_OPTIMAL ? GetOptimalSplitMode(CurrentNode) : KWMSettings.SplitMode;
                 CreateLeafNodePair(Display, CurrentNode, CurrentNode->WindowID, WindowID, SplitMode);
+                AddMinDepthLeafPair(SpaceInfo, CurrentNode);
                 ApplyTreeNodeContainer(CurrentNode);
             }
             else if(CurrentNode->Type == NodeTypeLink)
@@ -783,7 +885,7 @@ AddWindowToBSPTree(ax_display *Display, space_info *SpaceInfo, uint32_t WindowID
 internal void
 RemoveWindowFromBSPTree(ax_display *Display, uint32_t WindowID)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(!SpaceInfo->RootNode)
         return;
 
@@ -801,6 +903,10 @@ RemoveWindowFromBSPTree(ax_display *Display, uint32_t WindowID)
               (SpaceInfo->RootNode->WindowID == Parent->RightChild->WindowID))
                SpaceInfo->RootNode->WindowID = 0;
 
+            tree_node *PrevLeaf, *NextLeaf;
+            GetSurroundingLeafNodes(Parent, &PrevLeaf, &NextLeaf);
+            RemoveMinDepthLeaves(SpaceInfo, Parent);
+
             tree_node *AccessChild = IsRightChild(WindowNode) ? Parent->LeftChild : Parent->RightChild;
             Parent->LeftChild = NULL;
             Parent->RightChild = NULL;
@@ -817,9 +923,12 @@ RemoveWindowFromBSPTree(ax_display *Display, uint32_t WindowID)
                 Parent->RightChild = AccessChild->RightChild;
                 Parent->RightChild->Parent = Parent;
 
+                SetTreeNodeDepth(Parent, Parent->Depth);
                 CreateNodeContainers(Display, Parent, true);
             }
 
+            ThreadLeafNodes(Parent, PrevLeaf, NextLeaf);
+            AddMinDepthLeaves(SpaceInfo, Parent);
             ResizeLinkNodeContainers(Parent);
             ApplyTreeNodeContainer(Parent);
             free(AccessChild);
@@ -827,6 +936,7 @@ RemoveWindowFromBSPTree(ax_display *Display, uint32_t WindowID)
         }
         else if(!Parent)
         {
+            InvalidateMinDepthLeaves(SpaceInfo);
             free(SpaceInfo->RootNode);
             SpaceInfo->RootNode = NULL;
         }
@@ -886,7 +996,7 @@ AddWindowToMonocleTree(ax_display *Display, space_info *SpaceInfo, uint32_t Wind
 internal void
 RemoveWindowFromMonocleTree(ax_display *Display, uint32_t WindowID)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->RootNode && SpaceInfo->RootNode->List)
     {
         link_node *Link = GetLinkNodeFromTree(SpaceInfo->RootNode, WindowID);
@@ -907,6 +1017,7 @@ RemoveWindowFromMonocleTree(ax_display *Display, uint32_t WindowID)
 
                 if(!SpaceInfo->RootNode->List)
                 {
+                    InvalidateMinDepthLeaves(SpaceInfo);
                     free(SpaceInfo->RootNode);
                     SpaceInfo->RootNode = NULL;
                 }
@@ -917,12 +1028,13 @@ RemoveWindowFromMonocleTree(ax_display *Display, uint32_t WindowID)
 }
 
 internal void
-CreateSpaceInfoWithWindowTree(ax_display *Display, space_info *SpaceInfo, std::vector<uint32_t> *Windows)
+BuildSpaceInfoWindowTree(ax_display *Display, space_info *SpaceInfo, std::vector<uint32_t> *Windows)
 {
     if((SpaceInfo->Settings.Mode == SpaceModeFloating) ||
        (Display->Space->Type != kCGSSpaceUser))
         return;
 
+    InvalidateMinDepthLeaves(SpaceInfo);
     if(SpaceInfo->Settings.Mode == SpaceModeBSP && !SpaceInfo->Settings.Layout.empty())
     {
         if(LoadBSPTreeFromFile(Display, SpaceInfo, SpaceInfo->Settings.Layout))
@@ -938,23 +1050,58 @@ CreateSpaceInfoWithWindowTree(ax_display *Display, space_info *SpaceInfo, std::v
     {
         SpaceInfo->RootNode = CreateTreeFromWindowIDList(Display, Windows);
     }
+}
 
+internal void
+CreateSpaceInfoWithWindowTree(ax_display *Display, space_info *SpaceInfo, std::vector<uint32_t> *Windows)
+{
+    BuildSpaceInfoWindowTree(Display, SpaceInfo, Windows);
     if(SpaceInfo->RootNode)
         ApplyTreeNodeContainer(SpaceInfo->RootNode);
 }
 
+internal void
+ApplyKnownWindowRules()
+{
+    std::vector<ax_window *> KnownWindows = AXLibGetAllKnownWindows();
+    for(std::size_t Index = 0; Index < KnownWindows.size(); ++Index)
+    {
+        ax_window *Window = KnownWindows[Index];
+        ApplyWindowRules(Window);
+    }
+}
+
+/* NOTE: Window rules are not applied while a tree is prewarmed, because they can move or hide
+         windows. They are applied on the first visit instead, after which RebalanceNodeTree
+         reconciles the windows that were floated, closed, moved or created in the meantime.
+         Only then is every window moved into place, once. A space that was prewarmed without
+         any windows is built the way a first visit would build it. */
 void CreateWindowNodeTree(ax_display *Display)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
-    if(!SpaceInfo->Initialized && !SpaceInfo->RootNode)
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
+    if(SpaceInfo->Prewarmed)
     {
-        std::vector<ax_window *> KnownWindows = AXLibGetAllKnownWindows();
-        for(std::size_t Index = 0; Index < KnownWindows.size(); ++Index)
+        SpaceInfo->Prewarmed = false;
+        ApplyKnownWindowRules();
+        if(SpaceInfo->RootNode)
         {
-            ax_window *Window = KnownWindows[Index];
-            ApplyWindowRules(Window);
+            RebalanceNodeTree(Display);
+            if(SpaceInfo->RootNode)
+                ApplyTreeNodeContainer(SpaceInfo->RootNode);
+        }
+        else
+        {
+            LoadSpaceSettings(Display, SpaceInfo);
+            std::vector<uint32_t> Windows = GetAllWindowIDSOnDisplay(Display);
+            CreateSpaceInfoWithWindowTree(Display, SpaceInfo, &Windows);
         }
 
+        return;
+    }
+
+    if(!SpaceInfo->Initialized && !SpaceInfo->RootNode)
+    {
+        ApplyKnownWindowRules();
         SpaceInfo->Initialized = true;
         LoadSpaceSettings(Display, SpaceInfo);
         std::vector<uint32_t> Windows = GetAllWindowIDSOnDisplay(Display);
@@ -967,11 +1114,113 @@ void CreateWindowNodeTree(ax_display *Display)
     }
 }
 
+internal std::vector<uint32_t>
+GetAllWindowIDSOnInactiveSpace(ax_space *Space, std::vector<ax_window *> *KnownWindows, ax_window_spaces *WindowSpaces)
+{
+    std::vector<uint32_t> Windows;
+    for(std::size_t Index = 0; Index < KnownWindows->size(); ++Index)
+    {
+        ax_window *Window = (*KnownWindows)[Index];
+        if((AXLibIsWindowStandard(Window) || AXLibIsWindowCustom(Window)) &&
+           (!AXLibHasFlags(Window, AXWindow_Floating)) &&
+           (!AXLibHasFlags(Window, AXWindow_Minimized)) &&
+           (AXLibWindowSpacesHasWindow(WindowSpaces, Window->ID)) &&
+           (!AXLibWindowSpacesSticky(WindowSpaces, Window->ID)) &&
+           (!AXLibIsApplicationHidden(Window->Application)))
+            Windows.push_back(Window->ID);
+    }
+
+    return Windows;
+}
+
+internal inline bool
+ShouldPrewarmSpace(ax_display *Display, ax_space *Space)
+{
+    space_info *SpaceInfo = GetSpaceInfo(Space);
+    return (Space != Display->Space) &&
+           (Space->Type == kCGSSpaceUser) &&
+           (!SpaceInfo->Initialized) &&
+           (!SpaceInfo->RootNode);
+}
+
+/* NOTE: Builds the tree of a space that is not active, without moving any windows or applying any
+         window rules. Display->Space is also written by the main thread, so the tree is built against
+         a copy of the display that points to the space instead. Returns the number of trees that
+         were built, which is at most Limit. */
+internal std::size_t
+PrewarmWindowNodeTrees(ax_display *Display, std::size_t Limit)
+{
+    std::vector<ax_space *> Spaces;
+    std::map<CGSSpaceID, ax_space>::iterator It;
+    for(It = Display->Spaces.begin(); It != Display->Spaces.end() && Spaces.size() < Limit; ++It)
+    {
+        if(ShouldPrewarmSpace(Display, &It->second))
+            Spaces.push_back(&It->second);
+    }
+
+    if(Spaces.empty())
+        return 0;
+
+    std::vector<ax_window *> KnownWindows = AXLibGetAllKnownWindows();
+    for(std::size_t Index = 0; Index < Spaces.size(); ++Index)
+    {
+        ax_space *Space = Spaces[Index];
+        space_info *SpaceInfo = GetSpaceInfo(Space);
+        ax_window_spaces WindowSpaces = AXLibSpacesForWindows(Space->ID, &KnownWindows);
+
+        ax_display Shadow = {};
+        Shadow.ArrangementID = Display->ArrangementID;
+        Shadow.Identifier = Display->Identifier;
+        Shadow.ID = Display->ID;
+        Shadow.Frame = Display->Frame;
+        Shadow.Space = Space;
+
+        SpaceInfo->Initialized = true;
+        SpaceInfo->Prewarmed = true;
+        LoadSpaceSettings(Display, Space, SpaceInfo);
+
+        std::vector<uint32_t> Windows = GetAllWindowIDSOnInactiveSpace(Space, &KnownWindows, &WindowSpaces);
+        BuildSpaceInfoWindowTree(&Shadow, SpaceInfo, &Windows);
+        DEBUG("PrewarmWindowNodeTrees() " << Display->ArrangementID << " " << Space->ID << " windows " << Windows.size());
+    }
+
+    return Spaces.size();
+}
+
+/* NOTE: Must only be called from the event-loop thread. Builds at most one tree, so that
+         an event that arrives in the meantime is not kept waiting for long. */
+void PrewarmNextWindowNodeTree()
+{
+    if(AXLibIsSpaceTransitionInProgress())
+        return;
+
+    ax_display *MainDisplay = AXLibMainDisplay();
+    ax_display *Display = MainDisplay;
+    do
+    {
+        if(PrewarmWindowNodeTrees(Display, 1))
+            return;
+
+        Display = AXLibNextDisplay(Display);
+    } while(Display != MainDisplay);
+}
+
+void PrewarmAllWindowNodeTrees()
+{
+    ax_display *MainDisplay = AXLibMainDisplay();
+    ax_display *Display = MainDisplay;
+    do
+    {
+        PrewarmWindowNodeTrees(Display, Display->Spaces.size());
+        Display = AXLibNextDisplay(Display);
+    } while(Display != MainDisplay);
+}
+
 void LoadWindowNodeTree(ax_display *Display, std::string Layout)
 {
     if(Display)
     {
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
         if(SpaceInfo->Settings.Mode == SpaceModeBSP)
         {
             std::vector<uint32_t> Windows = GetAllWindowIDSOnDisplay(Display);
@@ -991,21 +1240,29 @@ void ResetWindowNodeTree(ax_display *Display, space_tiling_option Mode)
         if(AXLibIsSpaceTransitionInProgress())
             return;
 
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
         if(SpaceInfo->Settings.Mode == Mode)
             return;
 
+        InvalidateMinDepthLeaves(SpaceInfo);
         DestroyNodeTree(SpaceInfo->RootNode);
         SpaceInfo->RootNode = NULL;
         SpaceInfo->Initialized = true;
         SpaceInfo->Settings.Mode = Mode;
         CreateWindowNodeTree(Display);
+
+        if(Mode == SpaceModeBSP)
+            KwmNotify(NotifyTopic_Mode, "mode " + DesktopIDOfDisplay(Display) + " bsp");
+        else if(Mode == SpaceModeMonocle)
+            KwmNotify(NotifyTopic_Mode, "mode " + DesktopIDOfDisplay(Display) + " monocle");
+        else if(Mode == SpaceModeFloating)
+            KwmNotify(NotifyTopic_Mode, "mode " + DesktopIDOfDisplay(Display) + " float");
     }
 }
 
 void AddWindowToNodeTree(ax_display *Display, uint32_t WindowID)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(!SpaceInfo->RootNode)
         CreateWindowNodeTree(Display);
     else if((SpaceInfo->Settings.Mode == SpaceModeBSP) &&
@@ -1018,7 +1275,7 @@ void AddWindowToNodeTree(ax_display *Display, uint32_t WindowID)
 
 void RemoveWindowFromNodeTree(ax_display *Display, uint32_t WindowID)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->Settings.Mode == SpaceModeBSP)
         RemoveWindowFromBSPTree(Display, WindowID);
     else if(SpaceInfo->Settings.Mode == SpaceModeMonocle)
@@ -1028,7 +1285,7 @@ void RemoveWindowFromNodeTree(ax_display *Display, uint32_t WindowID)
 internal void
 RebalanceBSPTree(ax_display *Display)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->RootNode)
     {
         std::vector<ax_window *> VisibleWindows = AXLibGetAllVisibleWindows();
@@ -1053,7 +1310,7 @@ RebalanceBSPTree(ax_display *Display)
 internal void
 RebalanceMonocleTree(ax_display *Display)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->RootNode && SpaceInfo->RootNode->List)
     {
         std::vector<ax_window *> VisibleWindows = AXLibGetAllVisibleWindows();
@@ -1080,7 +1337,7 @@ RebalanceMonocleTree(ax_display *Display)
  * Also attempt to tile any untiled window that is not marked as  floating. */
 void RebalanceNodeTree(ax_display *Display)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(!SpaceInfo->Initialized)
         return;
 
@@ -1092,7 +1349,7 @@ void RebalanceNodeTree(ax_display *Display)
 
 void CreateInactiveWindowNodeTree(ax_display *Display, std::vector<uint32_t> *Windows)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(!SpaceInfo->Initialized && !SpaceInfo->RootNode)
     {
         SpaceInfo->Initialized = true;
@@ -1107,7 +1364,7 @@ void CreateInactiveWindowNodeTree(ax_display *Display, std::vector<uint32_t> *Wi
 
 void AddWindowToInactiveNodeTree(ax_display *Display, uint32_t WindowID)
 {
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(!SpaceInfo->RootNode)
     {
         std::vector<uint32_t> Windows;
@@ -1117,10 +1374,11 @@ void AddWindowToInactiveNodeTree(ax_display *Display, uint32_t WindowID)
     else if(SpaceInfo->Settings.Mode == SpaceModeBSP)
     {
         DEBUG("AddWindowToInactiveNodeTree() BSP Space");
-        tree_node *CurrentNode = FindFirstMinDepthLeafNode(SpaceInfo->RootNode);
+        tree_node *CurrentNode = FindFirstMinDepthLeafNode(SpaceInfo);
         split_type SplitMode = KWMSettings.SplitMode == SPLIT_OPTIMAL ? GetOptimalSplitMode(CurrentNode) : KWMSettings.SplitMode;
 
         CreateLeafNodePair(Display, CurrentNode, CurrentNode->WindowID, WindowID, SplitMode);
+        AddMinDepthLeafPair(SpaceInfo, CurrentNode);
         ApplyTreeNodeContainer(CurrentNode);
     }
     else if(SpaceInfo->Settings.Mode == SpaceModeMonocle)
@@ -1182,7 +1440,7 @@ void ToggleFocusedWindowParentContainer()
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *Space = &WindowTree[Display->Space->Identifier];
+    space_info *Space = GetSpaceInfo(Display->Space);
 
     if(Space->Settings.Mode != SpaceModeBSP)
         return;
@@ -1212,7 +1470,7 @@ void ToggleFocusedWindowFullscreen()
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *Space = &WindowTree[Display->Space->Identifier];
+    space_info *Space = GetSpaceInfo(Display->Space);
 
     if(Space->Settings.Mode != SpaceModeBSP)
         return;
@@ -1243,7 +1501,7 @@ void ToggleFocusedWindowFullscreen()
 bool IsWindowFullscreen(ax_window *Window)
 {
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     return SpaceInfo->RootNode && SpaceInfo->RootNode->WindowID == Window->ID;
 }
@@ -1251,7 +1509,7 @@ bool IsWindowFullscreen(ax_window *Window)
 bool IsWindowParentContainer(ax_window *Window)
 {
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     tree_node *Node = GetTreeNodeFromWindowID(SpaceInfo->RootNode, Window->ID);
     return Node && Node->Parent && Node->Parent->WindowID == Window->ID;
@@ -1262,7 +1520,7 @@ void LockWindowToContainerSize(ax_window *Window)
     if(Window)
     {
         ax_display *Display = AXLibWindowDisplay(Window);
-        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
         tree_node *Node = GetTreeNodeFromWindowID(SpaceInfo->RootNode, Window->ID);
         if(Node)
@@ -1324,7 +1582,7 @@ void SwapFocusedWindowWithMarked()
         return;
 
     ax_display *Display = AXLibWindowDisplay(FocusedWindow);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
 
     tree_node *TreeNode = GetTreeNodeFromWindowIDOrLinkNode(SpaceInfo->RootNode, FocusedWindow->ID);
     if(TreeNode)
@@ -1347,7 +1605,7 @@ void SwapFocusedWindowWithNearest(int Shift)
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->Settings.Mode == SpaceModeMonocle)
     {
         link_node *Link = GetLinkNodeFromTree(SpaceInfo->RootNode, Window->ID);
@@ -1411,7 +1669,7 @@ void SwapFocusedWindowDirected(int Degrees)
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *Space = &WindowTree[Display->Space->Identifier];
+    space_info *Space = GetSpaceInfo(Display->Space);
     if(Space->Settings.Mode == SpaceModeBSP)
     {
         tree_node *Node = GetTreeNodeFromWindowIDOrLinkNode(Space->RootNode, Window->ID);
@@ -1441,7 +1699,7 @@ void SwapFocusedWindowDirected(int Degrees)
 bool WindowIsInDirection(ax_window *WindowA, ax_window *WindowB, int Degrees)
 {
     ax_display *Display = AXLibWindowDisplay(WindowA);
-    space_info *Space = &WindowTree[Display->Space->Identifier];
+    space_info *Space = GetSpaceInfo(Display->Space);
     tree_node *NodeA = GetTreeNodeFromWindowIDOrLinkNode(Space->RootNode, WindowA->ID);
     tree_node *NodeB = GetTreeNodeFromWindowIDOrLinkNode(Space->RootNode, WindowB->ID);
 
@@ -1462,7 +1720,7 @@ bool WindowIsInDirection(ax_window *WindowA, ax_window *WindowB, int Degrees)
 void GetCenterOfWindow(ax_window *Window, int *X, int *Y)
 {
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *Space = &WindowTree[Display->Space->Identifier];
+    space_info *Space = GetSpaceInfo(Display->Space);
     tree_node *Node = GetTreeNodeFromWindowIDOrLinkNode(Space->RootNode, Window->ID);
     if(Node)
     {
@@ -1569,7 +1827,7 @@ void ShiftWindowFocusDirected(int Degrees)
     }
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->Settings.Mode == SpaceModeBSP)
     {
         ax_window *ClosestWindow = NULL;
@@ -1606,7 +1864,7 @@ void ShiftWindowFocus(int Shift)
     }
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->Settings.Mode == SpaceModeMonocle)
     {
         link_node *Link = GetLinkNodeFromTree(SpaceInfo->RootNode, Window->ID);
@@ -1677,7 +1935,7 @@ void ShiftSubTreeWindowFocus(int Shift)
         return;
 
     ax_display *Display = AXLibWindowDisplay(Window);
-    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_info *SpaceInfo = GetSpaceInfo(Display->Space);
     if(SpaceInfo->Settings.Mode == SpaceModeBSP)
     {
         link_node *Link = GetLinkNodeFromWindowID(SpaceInfo->RootNode, Window->ID);
@@ -1763,12 +2021,12 @@ void MarkWindowContainer(ax_window *Window)
     {
         if(MarkedWindow && MarkedWindow->ID == Window->ID)
         {
-            DEBUG("MarkWindowContainer() Unmarked " << Window->Name);
+            DEBUG("MarkWindowContainer() Unmarked " << AXLibStringText(Window->Name));
             ClearMarkedWindow();
         }
         else
         {
-            DEBUG("MarkWindowContainer() Marked " << Window->Name);
+            DEBUG("MarkWindowContainer() Marked " << AXLibStringText(Window->Name));
             MarkedWindow = Window;
             UpdateBorder(&MarkedBorder, MarkedWindow);
         }
@@ -1806,62 +2064,80 @@ void SetWindowFocusByNode(link_node *Link)
     }
 }
 
-void CenterWindowInsideNodeContainer(ax_window *Window, int *Xptr, int *Yptr, int *Wptr, int *Hptr)
+void SetWindowDimensions(ax_window *Window, int X, int Y, int Width, int Height)
 {
-    CGPoint WindowOrigin = AXLibGetWindowPosition(Window->Ref);
-    CGSize WindowOGSize = AXLibGetWindowSize(Window->Ref);
-
-    int &X = *Xptr, &Y = *Yptr, &Width = *Wptr, &Height = *Hptr;
-    int XDiff = (X + Width) - (WindowOrigin.x + WindowOGSize.width);
-    int YDiff = (Y + Height) - (WindowOrigin.y + WindowOGSize.height);
-
-    if(abs(XDiff) > 0 || abs(YDiff) > 0)
+    /* NOTE: The fullscreen state is cached by axlib, so that a slow application never
+             blocks the event-loop here. */
+    if(!AXLibHasFlags(Window, AXWindow_Fullscreen))
     {
-        double XOff = XDiff / 2.0f;
-        X += XOff > 0 ? XOff : 0;
-        Width -= XOff > 0 ? XOff : 0;
+        bool Moved = (Window->Position.x != X) || (Window->Position.y != Y);
+        bool Resized = (Window->Size.width != Width) || (Window->Size.height != Height);
+        if(!Moved && !Resized)
+            return;
 
-        double YOff = YDiff / 2.0f;
-        Y += YOff > 0 ? YOff : 0;
-        Height -= YOff > 0 ? YOff : 0;
+        if(DeferWindowDimensions)
+        {
+            /* NOTE: The cached frame is updated right away so that later commands in the batch see
+                     the same geometry they would if they ran one at a time. The frame that was last
+                     sent to the application is kept to decide what to commit at the end. */
+            if(DeferredWindowDimensions.find(Window->ID) == DeferredWindowDimensions.end())
+                DeferredWindowDimensions[Window->ID] = CGRectMake(Window->Position.x, Window->Position.y,
+                                                                  Window->Size.width, Window->Size.height);
+
+            Window->Position = CGPointMake(X, Y);
+            Window->Size = CGSizeMake(Width, Height);
+            return;
+        }
+
+        if(Moved)
+            AXLibMoveWindow(Window, X, Y);
 
-        AXLibAddFlags(Window, AXWindow_MoveIntrinsic);
-        if(!AXLibSetWindowPosition(Window->Ref, X, Y))
-            AXLibClearFlags(Window, AXWindow_MoveIntrinsic);
+        if(Resized)
+            AXLibResizeWindow(Window, Width, Height);
 
-        AXLibAddFlags(Window, AXWindow_SizeIntrinsic);
-        if(!AXLibSetWindowSize(Window->Ref, Width, Height))
-            AXLibClearFlags(Window, AXWindow_SizeIntrinsic);
+        /* NOTE: The echo of this change is suppressed when the application accepts the
+                 requested frame, so the borders are updated here instead. A window
+                 that does not accept the size is centered by the worker of the
+                 application, see Callback_AXEvent_WindowFrameCorrected. */
+        UpdateWindowBorders(Window);
     }
 }
 
-void SetWindowDimensions(ax_window *Window, int X, int Y, int Width, int Height)
+/* NOTE: While deferred, SetWindowDimensions only updates the cached frame of a window. Ending the
+         deferral sends the final frame of every changed window to its application exactly once,
+         so that a batch of commands results in a single layout pass. Must only be used from the
+         event-loop thread. Returns true if any window was given new dimensions. */
+void BeginDeferredWindowDimensions()
 {
-    if(!AXLibIsWindowFullscreen(Window->Ref))
-    {
-        bool Changed = false;
+    DeferWindowDimensions = true;
+}
 
-        if((Window->Position.x != X) ||
-           (Window->Position.y != Y))
-        {
-            Changed = true;
-            AXLibAddFlags(Window, AXWindow_MoveIntrinsic);
-            if(!AXLibSetWindowPosition(Window->Ref, X, Y))
-                AXLibClearFlags(Window, AXWindow_MoveIntrinsic);
-        }
+bool EndDeferredWindowDimensions()
+{
+    DeferWindowDimensions = false;
+    bool Result = false;
 
-        if((Window->Size.width != Width) ||
-           (Window->Size.height != Height))
-        {
-            Changed = true;
-            AXLibAddFlags(Window, AXWindow_SizeIntrinsic);
-            if(!AXLibSetWindowSize(Window->Ref, Width, Height))
-                AXLibClearFlags(Window, AXWindow_SizeIntrinsic);
-        }
+    std::map<uint32_t, CGRect>::iterator It;
+    for(It = DeferredWindowDimensions.begin(); It != DeferredWindowDimensions.end(); ++It)
+    {
+        ax_window *Window = GetWindowByID(It->first);
+        if(!Window)
+            continue;
 
-        if(Changed)
-            CenterWindowInsideNodeContainer(Window, &X, &Y, &Width, &Height);
+        CGRect Target = CGRectMake(Window->Position.x, Window->Position.y,
+                                   Window->Size.width, Window->Size.height);
+        if(CGRectEqualToRect(Target, It->second))
+            continue;
+
+        Window->Position = It->second.origin;
+        Window->Size = It->second.size;
+        SetWindowDimensions(Window, Target.origin.x, Target.origin.y,
+                            Target.size.width, Target.size.height);
+        Result = true;
     }
+
+    DeferredWindowDimensions.clear();
+    return Result;
 }
 
 void CenterWindow(ax_display *Display, ax_window *Window)
@@ -1893,23 +2169,7 @@ void CenterWindow(ax_display *Display, ax_window *Window)
 
 ax_window *GetWindowByID(uint32_t WindowID)
 {
-    ax_window *Result = NULL;
-
-    ax_application_map *Applications = BeginAXLibApplications();
-    for(ax_application_map_iter It = Applications->begin();
-        It != Applications->end();
-        ++It)
-    {
-        ax_application *Application = It->second;
-        Result = AXLibFindApplicationWindow(Application, WindowID);
-        if(Result)
-        {
-            break;
-        }
-    }
-
-    EndAXLibApplications();
-    return Result;
+    return AXLibFindWindow(WindowID);
 }
 
 void MoveFloatingWindow(int X, int Y)
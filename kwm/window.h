@@ -7,12 +7,15 @@
 
 void CreateWindowNodeTree(ax_display *Display);
 void CreateInactiveWindowNodeTree(ax_display *Display, std::vector<uint32_t> *Windows);
+void PrewarmNextWindowNodeTree();
+void PrewarmAllWindowNodeTrees();
 void LoadWindowNodeTree(ax_display *Display, std::string Layout);
 void ResetWindowNodeTree(ax_display *Display, space_tiling_option Mode);
 void AddWindowToNodeTree(ax_display *Display, uint32_t WindowID);
 void RemoveWindowFromNodeTree(ax_display *Display, uint32_t WindowID);
 void RebalanceNodeTree(ax_display *Display);
 void AddWindowToInactiveNodeTree(ax_display *Display, uint32_t WindowID);
+void NotifyLayoutChanged(ax_display *Display);
 
 ax_window *GetWindowByID(uint32_t WindowID);
 void GetCenterOfWindow(ax_window *Window, int *X, int *Y);
@@ -37,8 +40,9 @@ void MarkWindowContainer(ax_window *Window);
 void MarkFocusedWindowContainer();
 void SetWindowFocusByNode(tree_node *Node);
 void SetWindowFocusByNode(link_node *Link);
-void CenterWindowInsideNodeContainer(ax_window *Window, int *Xptr, int *Yptr, int *Wptr, int *Hptr);
 void SetWindowDimensions(ax_window *Window, int X, int Y, int Width, int Height);
+void BeginDeferredWindowDimensions();
+bool EndDeferredWindowDimensions();
 bool IsWindowFullscreen(ax_window *Window);
 bool IsWindowParentContainer(ax_window *Window);
 void LockWindowToContainerSize(ax_window *Window);
@@ -42,7 +42,7 @@ void WriteToSocket(std::string Msg)
     close(KwmcSockFD);
 }
 
-void KwmcForwardMessageThroughSocket(int argc, char **argv)
+std::string KwmcMessageFromArguments(int argc, char **argv)
 {
     std::string Msg;
     for(int i = 1; i < argc; ++i)
@@ -53,7 +53,41 @@ void KwmcForwardMessageThroughSocket(int argc, char **argv)
             Msg += " ";
     }
 
-    WriteToSocket(Msg);
+    return Msg;
+}
+
+void KwmcForwardMessageThroughSocket(int argc, char **argv)
+{
+    WriteToSocket(KwmcMessageFromArguments(argc, argv));
+}
+
+/* NOTE: Kwm keeps the connection open and pushes one line per notification.
+         Print every line as soon as it is complete, until Kwm closes the connection. */
+void KwmcSubscribe(int argc, char **argv)
+{
+    std::string Msg = KwmcMessageFromArguments(argc, argv) + "\n";
+    send(KwmcSockFD, Msg.c_str(), Msg.size(), 0);
+
+    std::string Line;
+    char Buffer[512];
+    ssize_t Received;
+    while((Received = recv(KwmcSockFD, Buffer, sizeof(Buffer), 0)) > 0)
+    {
+        for(ssize_t i = 0; i < Received; ++i)
+        {
+            if(Buffer[i] == '\n')
+            {
+                std::cout << Line << std::endl;
+                Line.clear();
+            }
+            else
+            {
+                Line += Buffer[i];
+            }
+        }
+    }
+
+    close(KwmcSockFD);
 }
 
 void KwmcConnectToDaemon()
@@ -94,7 +128,14 @@ int main(int argc, char **argv)
     {
         std::string Command = argv[1];
         if(Command == "interpret")
+        {
             KwmcInterpreter();
+        }
+        else if(Command == "subscribe")
+        {
+            KwmcConnectToDaemon();
+            KwmcSubscribe(argc, argv);
+        }
         else
         {
             KwmcConnectToDaemon();
@@ -0,0 +1,154 @@
+#include "test.h"
+#include "../axlib/display.h"
+#include "../axlib/window.h"
+
+#include <pthread.h>
+
+/* NOTE: A simulated rig of four 2560x1440 displays side by side, with eight spaces each and 64
+         windows spread over them. Every lookup is done the way axlib did before the index, by
+         scanning the map of displays, and through the ax_display_index. kwm resolves the display
+         of the same window several times per event, which the window lookups repeat four times.
+         AXLibArrangementDisplay and AXLibSpaceDisplay take SpaceTopologyLock around the index,
+         which is measured separately with an uncontended mutex. */
+#define DISPLAY_COUNT 4
+#define SPACES_PER_DISPLAY 8
+#define WINDOW_COUNT 64
+#define LOOKUPS 4000000
+
+static std::map<CGDirectDisplayID, ax_display> Displays;
+static ax_display_index Index = { 1 };
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+
+static ax_display *
+ScanArrangementDisplay(unsigned int ArrangementID)
+{
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays.begin(); It != Displays.end(); ++It)
+    {
+        if(It->second.ArrangementID == ArrangementID)
+            return &It->second;
+    }
+
+    return NULL;
+}
+
+static ax_display *
+ScanSpaceDisplay(CGSSpaceID SpaceID)
+{
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays.begin(); It != Displays.end(); ++It)
+    {
+        if(It->second.Spaces.find(SpaceID) != It->second.Spaces.end())
+            return &It->second;
+    }
+
+    return NULL;
+}
+
+static ax_display *
+ScanFrameDisplay(CGRect Frame)
+{
+    CGFloat HighestVolume = 0;
+    ax_display *BestDisplay = NULL;
+
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays.begin(); It != Displays.end(); ++It)
+    {
+        CGRect Intersection = CGRectIntersection(Frame, It->second.Frame);
+        CGFloat Volume = Intersection.size.width * Intersection.size.height;
+        if(Volume > HighestVolume)
+        {
+            HighestVolume = Volume;
+            BestDisplay = &It->second;
+        }
+    }
+
+    return BestDisplay;
+}
+
+static double
+NanosecondsPerLookup(uint64_t Start)
+{
+    return (double)(BenchTime() - Start) / LOOKUPS;
+}
+
+int main()
+{
+    for(unsigned int DisplayIndex = 0; DisplayIndex < DISPLAY_COUNT; ++DisplayIndex)
+    {
+        ax_display *Display = &Displays[0x4280 + DisplayIndex * 0x1d];
+        Display->ArrangementID = DisplayIndex;
+        Display->ID = 0x4280 + DisplayIndex * 0x1d;
+        Display->Frame = CGRectMake(DisplayIndex * 2560, 0, 2560, 1440);
+
+        for(int Space = 0; Space < SPACES_PER_DISPLAY; ++Space)
+        {
+            CGSSpaceID SpaceID = 1 + DisplayIndex * 100 + Space;
+            Display->Spaces[SpaceID].ID = SpaceID;
+        }
+    }
+
+    AXLibBuildDisplayIndex(&Index, &Displays, DISPLAY_COUNT, 1);
+
+    CGRect Frames[WINDOW_COUNT];
+    ax_window_display Caches[WINDOW_COUNT] = {};
+    for(int Window = 0; Window < WINDOW_COUNT; ++Window)
+        Frames[Window] = CGRectMake((Window * 617) % (DISPLAY_COUNT * 2560 - 800), (Window * 131) % 800, 800, 600);
+
+    uintptr_t Sink = 0;
+    uint64_t Start = BenchTime();
+    for(int Lookup = 0; Lookup < LOOKUPS; ++Lookup)
+        Sink += (uintptr_t) ScanArrangementDisplay(Lookup % DISPLAY_COUNT);
+    double ScanArrangement = NanosecondsPerLookup(Start);
+
+    Start = BenchTime();
+    for(int Lookup = 0; Lookup < LOOKUPS; ++Lookup)
+        Sink += (uintptr_t) AXLibIndexArrangementDisplay(&Index, Lookup % DISPLAY_COUNT);
+    double IndexArrangement = NanosecondsPerLookup(Start);
+
+    Start = BenchTime();
+    for(int Lookup = 0; Lookup < LOOKUPS; ++Lookup)
+    {
+        pthread_mutex_lock(&Lock);
+        Sink += (uintptr_t) AXLibIndexArrangementDisplay(&Index, Lookup % DISPLAY_COUNT);
+        pthread_mutex_unlock(&Lock);
+    }
+    double LockedArrangement = NanosecondsPerLookup(Start);
+
+    Start = BenchTime();
+    for(int Lookup = 0; Lookup < LOOKUPS; ++Lookup)
+        Sink += (uintptr_t) ScanSpaceDisplay(1 + (Lookup % DISPLAY_COUNT) * 100 + (Lookup / DISPLAY_COUNT) % SPACES_PER_DISPLAY);
+    double ScanSpace = NanosecondsPerLookup(Start);
+
+    Start = BenchTime();
+    for(int Lookup = 0; Lookup < LOOKUPS; ++Lookup)
+        Sink += (uintptr_t) AXLibIndexSpaceDisplay(&Index, &Displays, 1 + (Lookup % DISPLAY_COUNT) * 100 + (Lookup / DISPLAY_COUNT) % SPACES_PER_DISPLAY, 1);
+    double IndexSpace = NanosecondsPerLookup(Start);
+
+    Start = BenchTime();
+    for(int Lookup = 0; Lookup < LOOKUPS; ++Lookup)
+    {
+        pthread_mutex_lock(&Lock);
+        Sink += (uintptr_t) AXLibIndexSpaceDisplay(&Index, &Displays, 1 + (Lookup % DISPLAY_COUNT) * 100 + (Lookup / DISPLAY_COUNT) % SPACES_PER_DISPLAY, 1);
+        pthread_mutex_unlock(&Lock);
+    }
+    double LockedSpace = NanosecondsPerLookup(Start);
+
+    Start = BenchTime();
+    for(int Lookup = 0; Lookup < LOOKUPS; ++Lookup)
+        Sink += (uintptr_t) ScanFrameDisplay(Frames[(Lookup / 4) % WINDOW_COUNT]);
+    double ScanFrame = NanosecondsPerLookup(Start);
+
+    Start = BenchTime();
+    for(int Lookup = 0; Lookup < LOOKUPS; ++Lookup)
+    {
+        int Window = (Lookup / 4) % WINDOW_COUNT;
+        Sink += (uintptr_t) AXLibIndexFrameDisplay(&Index, &Displays, &Caches[Window], Frames[Window]);
+    }
+    double IndexFrame = NanosecondsPerLookup(Start);
+
+    printf("display arrangement: scan %6.2f ns, index %6.2f ns, locked %6.2f ns\n", ScanArrangement, IndexArrangement, LockedArrangement);
+    printf("display space:       scan %6.2f ns, index %6.2f ns, locked %6.2f ns\n", ScanSpace, IndexSpace, LockedSpace);
+    printf("display window:      scan %6.2f ns, index %6.2f ns\n", ScanFrame, IndexFrame);
+    return Sink == 0;
+}
@@ -0,0 +1,115 @@
+#include "test.h"
+#include "../axlib/intern.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+/* NOTE: Only reached through AXLibInternCFString, which needs a CFString and is not tested here. */
+char *CopyCFStringToC(CFStringRef String, bool UTF8)
+{
+    return NULL;
+}
+
+static void
+CheckIdentity()
+{
+    ax_string *A = AXLibInternString("Terminal");
+    ax_string *B = AXLibInternString("Terminal");
+    ax_string *C = AXLibInternString("iTerm2");
+
+    Check(A && B && C);
+    Check(A == B);
+    Check(A != C);
+    Check(AXLibStringID(A) == AXLibStringID(B));
+    Check(AXLibStringID(A) != AXLibStringID(C));
+    Check(AXLibStringID(A) != 0);
+    Check(strcmp(AXLibStringText(A), "Terminal") == 0);
+    Check(A->References == 2);
+
+    /* NOTE: Only the given length is interned, and the copy is terminated. */
+    ax_string *Prefix = AXLibInternString("Terminal", 4);
+    Check(Prefix != A);
+    Check(Prefix->Length == 4);
+    Check(strcmp(AXLibStringText(Prefix), "Term") == 0);
+    Check(AXLibInternString("Term") == Prefix);
+
+    /* NOTE: Looking a string up does not take a reference. */
+    Check(AXLibFindString("Terminal") == A);
+    Check(A->References == 2);
+    Check(AXLibFindString("Finder") == NULL);
+
+    Check(AXLibInternString(NULL) == NULL);
+    Check(AXLibFindString(NULL) == NULL);
+    Check(AXLibStringText(NULL) == NULL);
+    Check(AXLibStringID(NULL) == 0);
+
+    AXLibReleaseString(Prefix);
+    AXLibReleaseString(Prefix);
+    AXLibReleaseString(C);
+    AXLibReleaseString(B);
+    AXLibReleaseString(A);
+}
+
+static void
+CheckRelease()
+{
+    ax_string *A = AXLibInternString("Safari");
+    uint32_t ID = AXLibStringID(A);
+    AXLibRetainString(A);
+    Check(A->References == 2);
+
+    AXLibReleaseString(A);
+    Check(AXLibFindString("Safari") == A);
+
+    /* NOTE: The last reference removes the string, and ids are never handed out twice. */
+    AXLibReleaseString(A);
+    Check(AXLibFindString("Safari") == NULL);
+
+    ax_string *B = AXLibInternString("Safari");
+    Check(AXLibStringID(B) != ID);
+    AXLibReleaseString(B);
+}
+
+static void
+CheckGrowth()
+{
+    /* NOTE: Enough strings to grow the table several times, each must still be found afterwards. */
+    std::vector<ax_string *> Strings;
+    for(int Index = 0; Index < 5000; ++Index)
+    {
+        std::string Text = "window title " + std::to_string(Index);
+        Strings.push_back(AXLibInternString(Text.c_str()));
+    }
+
+    for(int Index = 0; Index < 5000; ++Index)
+    {
+        std::string Text = "window title " + std::to_string(Index);
+        Check(AXLibFindString(Text.c_str()) == Strings[Index]);
+        Check(AXLibInternString(Text.c_str()) == Strings[Index]);
+        AXLibReleaseString(Strings[Index]);
+    }
+
+    /* NOTE: Every other string is released, the rest must survive the unlinking of its neighbours. */
+    for(int Index = 0; Index < 5000; Index += 2)
+        AXLibReleaseString(Strings[Index]);
+
+    for(int Index = 0; Index < 5000; ++Index)
+    {
+        std::string Text = "window title " + std::to_string(Index);
+        Check(AXLibFindString(Text.c_str()) == (Index % 2 ? Strings[Index] : NULL));
+    }
+
+    for(int Index = 1; Index < 5000; Index += 2)
+        AXLibReleaseString(Strings[Index]);
+
+    Check(AXLibFindString("window title 4999") == NULL);
+}
+
+int main()
+{
+    CheckIdentity();
+    CheckRelease();
+    CheckGrowth();
+    return TestResult("intern");
+}
@@ -0,0 +1,195 @@
+#include "test.h"
+#include "../kwm/container.h"
+
+#include <stdlib.h>
+
+kwm_settings KWMSettings;
+
+static uint32_t Seed = 2463534242u;
+
+static uint32_t
+Random()
+{
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    return Seed;
+}
+
+static tree_node *
+CreateNode(tree_node *Parent)
+{
+    tree_node *Node = (tree_node *) calloc(1, sizeof(tree_node));
+    Node->Parent = Parent;
+    Node->SplitRatio = (Random() % 4) ? 0.1 + (Random() % 800) / 1000.0 : 0;
+
+    uint32_t Mode = Random() % 3;
+    Node->SplitMode = Mode == 0 ? SPLIT_NONE : (Mode == 1 ? SPLIT_VERTICAL : SPLIT_HORIZONTAL);
+    return Node;
+}
+
+/* NOTE: Grows a random tree by splitting random leaves. A few nodes only get a left child, which
+         the layout must leave alone together with everything below it. */
+static tree_node *
+CreateRandomTree(int Splits)
+{
+    tree_node *Root = CreateNode(NULL);
+    Root->Container.X = 0;
+    Root->Container.Y = 22;
+    Root->Container.Width = 2560;
+    Root->Container.Height = 1418;
+    Root->SplitRatio = 0.5;
+
+    std::vector<tree_node *> Leaves(1, Root);
+    for(int Split = 0; Split < Splits; ++Split)
+    {
+        std::size_t Index = Random() % Leaves.size();
+        tree_node *Node = Leaves[Index];
+        Leaves[Index] = Leaves.back();
+        Leaves.pop_back();
+
+        Node->LeftChild = CreateNode(Node);
+        Leaves.push_back(Node->LeftChild);
+        if(Random() % 16)
+        {
+            Node->RightChild = CreateNode(Node);
+            Leaves.push_back(Node->RightChild);
+        }
+    }
+
+    return Root;
+}
+
+static tree_node *
+CopyTree(tree_node *Node, tree_node *Parent)
+{
+    if(!Node)
+        return NULL;
+
+    tree_node *Copy = (tree_node *) malloc(sizeof(tree_node));
+    *Copy = *Node;
+    Copy->Parent = Parent;
+    Copy->LeftChild = CopyTree(Node->LeftChild, Copy);
+    Copy->RightChild = CopyTree(Node->RightChild, Copy);
+    return Copy;
+}
+
+static void
+FreeTree(tree_node *Node)
+{
+    if(Node)
+    {
+        FreeTree(Node->LeftChild);
+        FreeTree(Node->RightChild);
+        free(Node);
+    }
+}
+
+static split_type
+ReferenceOptimalSplit(node_container *Container)
+{
+    return (Container->Width / Container->Height) >= KWMSettings.OptimalRatio ? SPLIT_VERTICAL : SPLIT_HORIZONTAL;
+}
+
+static void
+ReferenceDefaults(tree_node *Node)
+{
+    if(Node->SplitRatio == 0)
+        Node->SplitRatio = KWMSettings.SplitRatio;
+
+    if(Node->SplitMode == SPLIT_NONE)
+        Node->SplitMode = ReferenceOptimalSplit(&Node->Container);
+}
+
+/* NOTE: CreateNodeContainerPair(..) applied to every split node, top-down. */
+static void
+ReferenceLayout(tree_node *Node, double VerticalGap, double HorizontalGap, bool OptimalSplit)
+{
+    if(!Node->LeftChild || !Node->RightChild)
+        return;
+
+    node_container *C = &Node->Container;
+    node_container *L = &Node->LeftChild->Container;
+    node_container *R = &Node->RightChild->Container;
+    double Ratio = Node->SplitRatio;
+
+    if(OptimalSplit)
+        Node->SplitMode = ReferenceOptimalSplit(C);
+
+    if(Node->SplitMode == SPLIT_VERTICAL)
+    {
+        L->X = C->X;
+        L->Y = C->Y;
+        L->Width = (C->Width * Ratio) - VerticalGap;
+        L->Height = C->Height;
+        L->Type = CONTAINER_LEFT;
+
+        R->X = C->X + (C->Width * Ratio) + VerticalGap;
+        R->Y = C->Y;
+        R->Width = (C->Width * (1 - Ratio)) - VerticalGap;
+        R->Height = C->Height;
+        R->Type = CONTAINER_RIGHT;
+    }
+    else
+    {
+        L->X = C->X;
+        L->Y = C->Y;
+        L->Width = C->Width;
+        L->Height = (C->Height * Ratio) - HorizontalGap;
+        L->Type = CONTAINER_UPPER;
+
+        R->X = C->X;
+        R->Y = C->Y + (C->Height * Ratio) + HorizontalGap;
+        R->Width = C->Width;
+        R->Height = (C->Height * (1 - Ratio)) - HorizontalGap;
+        R->Type = CONTAINER_LOWER;
+    }
+
+    ReferenceDefaults(Node->LeftChild);
+    ReferenceDefaults(Node->RightChild);
+    ReferenceLayout(Node->LeftChild, VerticalGap, HorizontalGap, OptimalSplit);
+    ReferenceLayout(Node->RightChild, VerticalGap, HorizontalGap, OptimalSplit);
+}
+
+static bool
+IsSameTree(tree_node *A, tree_node *B)
+{
+    if(!A || !B)
+        return A == B;
+
+    return (memcmp(&A->Container, &B->Container, sizeof(node_container)) == 0) &&
+           (A->SplitMode == B->SplitMode) &&
+           (A->SplitRatio == B->SplitRatio) &&
+           IsSameTree(A->LeftChild, B->LeftChild) &&
+           IsSameTree(A->RightChild, B->RightChild);
+}
+
+static void
+CheckAgainstReference(int Splits, bool OptimalSplit)
+{
+    tree_node *Root = CreateRandomTree(Splits);
+    tree_node *Reference = CopyTree(Root, NULL);
+
+    double VerticalGap = 7.5, HorizontalGap = 5;
+    ReferenceLayout(Reference, VerticalGap, HorizontalGap, OptimalSplit);
+
+    SplitNodeContainers(Root, VerticalGap, HorizontalGap, OptimalSplit);
+
+    Check(IsSameTree(Root, Reference));
+    FreeTree(Root);
+    FreeTree(Reference);
+}
+
+int main()
+{
+    KWMSettings.SplitRatio = 0.5;
+    KWMSettings.OptimalRatio = 1.618;
+
+    for(int Run = 0; Run < 200; ++Run)
+    {
+        CheckAgainstReference(Run * 5, false);
+        CheckAgainstReference(Run * 5, true);
+    }
+
+    return TestResult("layout");
+}
@@ -0,0 +1,248 @@
+#include "test.h"
+#include "../kwm/container.h"
+
+#include <stdlib.h>
+
+kwm_settings KWMSettings;
+
+/* NOTE: Lays out a tree of n leaves with SplitNodeContainers(..), with the split that
+         CreateNodeContainers used to run, which looked the space up by name for every container,
+         and with a breadth-first sweep over a flat structure-of-arrays copy of the tree. The flat
+         tree is timed with and without building it and writing it back to the nodes; the latter
+         is the best case of a flat tree that is kept in sync with tree_node. */
+static tree_node *
+CreateTree(int Leaves)
+{
+    std::vector<tree_node *> Nodes;
+    tree_node *Root = (tree_node *) calloc(1, sizeof(tree_node));
+    Root->Container.Width = 2560;
+    Root->Container.Height = 1418;
+    Nodes.push_back(Root);
+
+    for(int Index = 0; Index + 1 < Leaves; ++Index)
+    {
+        tree_node *Node = Nodes[Index];
+        Node->SplitRatio = 0.5;
+        Node->SplitMode = Index % 2 ? SPLIT_HORIZONTAL : SPLIT_VERTICAL;
+        Node->LeftChild = (tree_node *) calloc(1, sizeof(tree_node));
+        Node->RightChild = (tree_node *) calloc(1, sizeof(tree_node));
+        Node->LeftChild->Parent = Node;
+        Node->RightChild->Parent = Node;
+        Nodes.push_back(Node->LeftChild);
+        Nodes.push_back(Node->RightChild);
+    }
+
+    return Root;
+}
+
+static void
+FreeTree(tree_node *Node)
+{
+    if(Node)
+    {
+        FreeTree(Node->LeftChild);
+        FreeTree(Node->RightChild);
+        free(Node);
+    }
+}
+
+static std::map<std::string, space_info> WindowTree;
+
+#define FLAT_TREE_NONE 0xFFFFFFFF
+struct flat_tree
+{
+    std::vector<tree_node *> Node;
+    std::vector<uint32_t> LeftChild;
+    std::vector<uint32_t> RightChild;
+
+    std::vector<double> SplitRatio;
+    std::vector<split_type> SplitMode;
+
+    std::vector<double> X, Y;
+    std::vector<double> Width, Height;
+    std::vector<container_type> Type;
+};
+
+static uint32_t
+PushFlatTreeNode(flat_tree *Tree, tree_node *Node)
+{
+    uint32_t Index = Tree->Node.size();
+    Tree->Node.push_back(Node);
+    Tree->LeftChild.push_back(FLAT_TREE_NONE);
+    Tree->RightChild.push_back(FLAT_TREE_NONE);
+    Tree->SplitRatio.push_back(Node->SplitRatio);
+    Tree->SplitMode.push_back(Node->SplitMode);
+    Tree->X.push_back(Node->Container.X);
+    Tree->Y.push_back(Node->Container.Y);
+    Tree->Width.push_back(Node->Container.Width);
+    Tree->Height.push_back(Node->Container.Height);
+    Tree->Type.push_back(Node->Container.Type);
+    return Index;
+}
+
+static void
+FlattenTree(flat_tree *Tree, tree_node *Root)
+{
+    Tree->Node.clear();
+    Tree->LeftChild.clear();
+    Tree->RightChild.clear();
+    Tree->SplitRatio.clear();
+    Tree->SplitMode.clear();
+    Tree->X.clear();
+    Tree->Y.clear();
+    Tree->Width.clear();
+    Tree->Height.clear();
+    Tree->Type.clear();
+
+    PushFlatTreeNode(Tree, Root);
+    for(uint32_t Index = 0; Index < Tree->Node.size(); ++Index)
+    {
+        tree_node *Node = Tree->Node[Index];
+        if(Node->LeftChild && Node->RightChild)
+        {
+            uint32_t Left = PushFlatTreeNode(Tree, Node->LeftChild);
+            uint32_t Right = PushFlatTreeNode(Tree, Node->RightChild);
+            Tree->LeftChild[Index] = Left;
+            Tree->RightChild[Index] = Right;
+        }
+    }
+}
+
+static void
+SweepFlatTree(flat_tree *Tree, double VerticalGap, double HorizontalGap)
+{
+    for(uint32_t Index = 0; Index < Tree->Node.size(); ++Index)
+    {
+        uint32_t Left = Tree->LeftChild[Index];
+        uint32_t Right = Tree->RightChild[Index];
+        if(Left == FLAT_TREE_NONE)
+            continue;
+
+        double Ratio = Tree->SplitRatio[Index];
+        if(Tree->SplitMode[Index] == SPLIT_VERTICAL)
+        {
+            Tree->X[Left] = Tree->X[Index];
+            Tree->Y[Left] = Tree->Y[Index];
+            Tree->Width[Left] = (Tree->Width[Index] * Ratio) - VerticalGap;
+            Tree->Height[Left] = Tree->Height[Index];
+            Tree->Type[Left] = CONTAINER_LEFT;
+
+            Tree->X[Right] = Tree->X[Index] + (Tree->Width[Index] * Ratio) + VerticalGap;
+            Tree->Y[Right] = Tree->Y[Index];
+            Tree->Width[Right] = (Tree->Width[Index] * (1 - Ratio)) - VerticalGap;
+            Tree->Height[Right] = Tree->Height[Index];
+            Tree->Type[Right] = CONTAINER_RIGHT;
+        }
+        else
+        {
+            Tree->X[Left] = Tree->X[Index];
+            Tree->Y[Left] = Tree->Y[Index];
+            Tree->Width[Left] = Tree->Width[Index];
+            Tree->Height[Left] = (Tree->Height[Index] * Ratio) - HorizontalGap;
+            Tree->Type[Left] = CONTAINER_UPPER;
+
+            Tree->X[Right] = Tree->X[Index];
+            Tree->Y[Right] = Tree->Y[Index] + (Tree->Height[Index] * Ratio) + HorizontalGap;
+            Tree->Width[Right] = Tree->Width[Index];
+            Tree->Height[Right] = (Tree->Height[Index] * (1 - Ratio)) - HorizontalGap;
+            Tree->Type[Right] = CONTAINER_LOWER;
+        }
+    }
+}
+
+static void
+ApplyFlatTree(flat_tree *Tree)
+{
+    for(uint32_t Index = 0; Index < Tree->Node.size(); ++Index)
+    {
+        node_container *Container = &Tree->Node[Index]->Container;
+        Container->X = Tree->X[Index];
+        Container->Y = Tree->Y[Index];
+        Container->Width = Tree->Width[Index];
+        Container->Height = Tree->Height[Index];
+        Container->Type = Tree->Type[Index];
+    }
+}
+
+static void
+MapLookupLayout(tree_node *Node, std::string *Space)
+{
+    if(!Node->LeftChild || !Node->RightChild)
+        return;
+
+    node_container *C = &Node->Container;
+    node_container *L = &Node->LeftChild->Container;
+    node_container *R = &Node->RightChild->Container;
+    double Ratio = Node->SplitRatio;
+
+    if(Node->SplitMode == SPLIT_VERTICAL)
+    {
+        L->X = C->X; L->Y = C->Y; L->Height = C->Height;
+        L->Width = (C->Width * Ratio) - (WindowTree[*Space].Settings.Offset.VerticalGap / 2);
+        R->Y = C->Y; R->Height = C->Height;
+        R->X = C->X + (C->Width * Ratio) + (WindowTree[*Space].Settings.Offset.VerticalGap / 2);
+        R->Width = (C->Width * (1 - Ratio)) - (WindowTree[*Space].Settings.Offset.VerticalGap / 2);
+    }
+    else
+    {
+        L->X = C->X; L->Y = C->Y; L->Width = C->Width;
+        L->Height = (C->Height * Ratio) - (WindowTree[*Space].Settings.Offset.HorizontalGap / 2);
+        R->X = C->X; R->Width = C->Width;
+        R->Y = C->Y + (C->Height * Ratio) + (WindowTree[*Space].Settings.Offset.HorizontalGap / 2);
+        R->Height = (C->Height * (1 - Ratio)) - (WindowTree[*Space].Settings.Offset.HorizontalGap / 2);
+    }
+
+    MapLookupLayout(Node->LeftChild, Space);
+    MapLookupLayout(Node->RightChild, Space);
+}
+
+int main()
+{
+    KWMSettings.SplitRatio = 0.5;
+    KWMSettings.OptimalRatio = 1.618;
+
+    /* NOTE: A handful of spaces, with identifiers shaped like the real ones. */
+    for(int Index = 0; Index < 8; ++Index)
+        WindowTree["4E2D5A7C-1F3B-4C6D-9E8F-00000000000" + std::to_string(Index)].Settings.Offset.VerticalGap = 15;
+    std::string Space = "4E2D5A7C-1F3B-4C6D-9E8F-000000000003";
+
+    int Sizes[] = { 16, 1000, 10000 };
+    for(int SizeIndex = 0; SizeIndex < 3; ++SizeIndex)
+    {
+        int Leaves = Sizes[SizeIndex];
+        int Iterations = 2000000 / Leaves;
+        tree_node *Root = CreateTree(Leaves);
+
+        uint64_t Start = BenchTime();
+        for(int Iteration = 0; Iteration < Iterations; ++Iteration)
+            MapLookupLayout(Root, &Space);
+        double MapLookup = (double)(BenchTime() - Start) / Iterations / 1000.0;
+
+        Start = BenchTime();
+        for(int Iteration = 0; Iteration < Iterations; ++Iteration)
+            SplitNodeContainers(Root, 7.5, 5, false);
+        double Split = (double)(BenchTime() - Start) / Iterations / 1000.0;
+
+        flat_tree Tree;
+        Start = BenchTime();
+        for(int Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            FlattenTree(&Tree, Root);
+            SweepFlatTree(&Tree, 7.5, 5);
+            ApplyFlatTree(&Tree);
+        }
+        double Flat = (double)(BenchTime() - Start) / Iterations / 1000.0;
+
+        Start = BenchTime();
+        for(int Iteration = 0; Iteration < Iterations; ++Iteration)
+            SweepFlatTree(&Tree, 7.5, 5);
+        double Sweep = (double)(BenchTime() - Start) / Iterations / 1000.0;
+
+        printf("layout %5d leaves: lookup per container %8.2f us, SplitNodeContainers %8.2f us, "
+               "flat tree %8.2f us, flat sweep only %8.2f us\n",
+               Leaves, MapLookup, Split, Flat, Sweep);
+        FreeTree(Root);
+    }
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include "test.h"
+#include "../kwm/tree.h"
+
+#include <stdlib.h>
+
+static tree_node *
+CreateRoot()
+{
+    tree_node *Root = (tree_node *) calloc(1, sizeof(tree_node));
+    Root->Generation = NextTreeGeneration();
+    return Root;
+}
+
+/* NOTE: Mirrors CreateLeafNodePair(..) followed by AddMinDepthLeafPair(..). */
+static void
+Split(space_info *Space, tree_node *Node)
+{
+    Node->LeftChild = (tree_node *) calloc(1, sizeof(tree_node));
+    Node->RightChild = (tree_node *) calloc(1, sizeof(tree_node));
+    Node->LeftChild->Parent = Node;
+    Node->RightChild->Parent = Node;
+    Node->LeftChild->Depth = Node->Depth + 1;
+    Node->RightChild->Depth = Node->Depth + 1;
+    AddMinDepthLeafPair(Space, Node);
+}
+
+static void
+FreeTree(tree_node *Node)
+{
+    if(Node)
+    {
+        FreeTree(Node->LeftChild);
+        FreeTree(Node->RightChild);
+        free(Node);
+    }
+}
+
+/* NOTE: The breadth-first search that the set replaced. */
+static tree_node *
+ReferenceFirstMinDepthLeaf(tree_node *Root)
+{
+    std::vector<tree_node *> Queue(1, Root);
+    for(std::size_t Index = 0; Index < Queue.size(); ++Index)
+    {
+        tree_node *Node = Queue[Index];
+        if(!Node->LeftChild && !Node->RightChild)
+            return Node;
+
+        if(Node->LeftChild)
+            Queue.push_back(Node->LeftChild);
+
+        if(Node->RightChild)
+            Queue.push_back(Node->RightChild);
+    }
+
+    return NULL;
+}
+
+static std::vector<tree_node *>
+ReferenceLeaves(tree_node *Root)
+{
+    std::vector<tree_node *> Result;
+    std::vector<tree_node *> Queue(1, Root);
+    for(std::size_t Index = 0; Index < Queue.size(); ++Index)
+    {
+        tree_node *Node = Queue[Index];
+        if(!Node->LeftChild && !Node->RightChild)
+            Result.push_back(Node);
+
+        if(Node->LeftChild)
+            Queue.push_back(Node->LeftChild);
+
+        if(Node->RightChild)
+            Queue.push_back(Node->RightChild);
+    }
+
+    return Result;
+}
+
+static bool
+MatchesReference(space_info *Space)
+{
+    std::vector<tree_node *> Expected = ReferenceLeaves(Space->RootNode);
+    std::vector<tree_node *> Actual(Space->MinDepthLeaves.begin(), Space->MinDepthLeaves.end());
+    return Expected == Actual;
+}
+
+static void
+CheckInsertionOrder()
+{
+    space_info Space = {};
+    Space.RootNode = CreateRoot();
+
+    for(int Window = 1; Window < 1000; ++Window)
+    {
+        tree_node *Leaf = FindFirstMinDepthLeafNode(&Space);
+        Check(Leaf == ReferenceFirstMinDepthLeaf(Space.RootNode));
+        Split(&Space, Leaf);
+    }
+
+    Check(MatchesReference(&Space));
+    FreeTree(Space.RootNode);
+}
+
+/* NOTE: Removes the window of Leaf the way RemoveWindowFromBSPTree does: its sibling takes over
+         the parent, and the leaves of the collapsed subtree are re-inserted. */
+static void
+RemoveLeaf(space_info *Space, tree_node *Leaf)
+{
+    tree_node *Parent = Leaf->Parent;
+    RemoveMinDepthLeaves(Space, Parent);
+
+    tree_node *Sibling = Parent->LeftChild == Leaf ? Parent->RightChild : Parent->LeftChild;
+    Parent->LeftChild = Sibling->LeftChild;
+    Parent->RightChild = Sibling->RightChild;
+    if(Parent->LeftChild)
+        Parent->LeftChild->Parent = Parent;
+    if(Parent->RightChild)
+        Parent->RightChild->Parent = Parent;
+
+    free(Sibling);
+    free(Leaf);
+    AddMinDepthLeaves(Space, Parent);
+}
+
+static void
+CheckRemoval()
+{
+    space_info Space = {};
+    Space.RootNode = CreateRoot();
+    for(int Window = 1; Window < 200; ++Window)
+        Split(&Space, FindFirstMinDepthLeafNode(&Space));
+
+    uint32_t Seed = 12345;
+    for(int Removed = 0; Removed < 150; ++Removed)
+    {
+        std::vector<tree_node *> Leaves = ReferenceLeaves(Space.RootNode);
+        Seed = Seed * 1103515245 + 12345;
+        RemoveLeaf(&Space, Leaves[(Seed >> 8) % Leaves.size()]);
+        Check(MatchesReference(&Space));
+
+        Split(&Space, FindFirstMinDepthLeafNode(&Space));
+        Check(MatchesReference(&Space));
+    }
+
+    FreeTree(Space.RootNode);
+}
+
+static void
+CheckDeepTree()
+{
+    /* NOTE: Always splitting the right-most leaf builds a tree deeper than the 64 levels that fit
+             in Order, which falls back to comparing ancestors. */
+    space_info Space = {};
+    Space.RootNode = CreateRoot();
+    FindFirstMinDepthLeafNode(&Space);
+
+    tree_node *Node = Space.RootNode;
+    for(int Level = 0; Level < 100; ++Level)
+    {
+        Split(&Space, Node);
+        Node = Node->RightChild;
+    }
+
+    Check(Node->Depth == 100);
+    Check(MatchesReference(&Space));
+
+    InvalidateMinDepthLeaves(&Space);
+    Check(FindFirstMinDepthLeafNode(&Space) == Space.RootNode->LeftChild);
+    Check(MatchesReference(&Space));
+    FreeTree(Space.RootNode);
+}
+
+static void
+CheckReusedRoot()
+{
+    space_info Space = {};
+    Space.RootNode = CreateRoot();
+    for(int Window = 1; Window < 8; ++Window)
+        Split(&Space, FindFirstMinDepthLeafNode(&Space));
+
+    /* NOTE: Replace the tree with a new single-node tree at the same address, without
+             invalidating the set. */
+    tree_node *Root = Space.RootNode;
+    FreeTree(Root->LeftChild);
+    FreeTree(Root->RightChild);
+    memset(Root, 0, sizeof(tree_node));
+    Root->Generation = NextTreeGeneration();
+
+    Check(FindFirstMinDepthLeafNode(&Space) == Root);
+    Check(Space.MinDepthLeaves.size() == 1);
+    free(Root);
+}
+
+int main()
+{
+    CheckInsertionOrder();
+    CheckRemoval();
+    CheckDeepTree();
+    CheckReusedRoot();
+    return TestResult("leaves");
+}
@@ -0,0 +1,137 @@
+#include "test.h"
+#include "../kwm/tree.h"
+
+#include <stdlib.h>
+
+/* NOTE: Inserting n windows one at a time into the first min-depth leaf, as done when windows are
+         added to an existing tree. Compares the breadth-first search, a set ordered by walking up
+         to the common ancestor, and the set ordered by depth and Order. */
+struct ancestor_walk_order
+{
+    bool operator()(const tree_node *A, const tree_node *B) const
+    {
+        if(A->Depth != B->Depth)
+            return A->Depth < B->Depth;
+
+        if(A == B)
+            return false;
+
+        while(A->Parent != B->Parent)
+        {
+            A = A->Parent;
+            B = B->Parent;
+        }
+
+        return A->Parent->LeftChild == A;
+    }
+};
+
+static void
+SplitNode(tree_node *Node)
+{
+    Node->LeftChild = (tree_node *) calloc(1, sizeof(tree_node));
+    Node->RightChild = (tree_node *) calloc(1, sizeof(tree_node));
+    Node->LeftChild->Parent = Node;
+    Node->RightChild->Parent = Node;
+    Node->LeftChild->Depth = Node->Depth + 1;
+    Node->RightChild->Depth = Node->Depth + 1;
+}
+
+static void
+FreeTree(tree_node *Node)
+{
+    if(Node)
+    {
+        FreeTree(Node->LeftChild);
+        FreeTree(Node->RightChild);
+        free(Node);
+    }
+}
+
+static tree_node *
+FirstLeafBreadthFirst(tree_node *Root, std::vector<tree_node *> *Queue)
+{
+    Queue->clear();
+    Queue->push_back(Root);
+    for(std::size_t Index = 0; Index < Queue->size(); ++Index)
+    {
+        tree_node *Node = (*Queue)[Index];
+        if(!Node->LeftChild && !Node->RightChild)
+            return Node;
+
+        Queue->push_back(Node->LeftChild);
+        Queue->push_back(Node->RightChild);
+    }
+
+    return NULL;
+}
+
+static double
+BenchBreadthFirst(int Windows)
+{
+    tree_node *Root = (tree_node *) calloc(1, sizeof(tree_node));
+    std::vector<tree_node *> Queue;
+
+    uint64_t Start = BenchTime();
+    for(int Window = 1; Window < Windows; ++Window)
+        SplitNode(FirstLeafBreadthFirst(Root, &Queue));
+    uint64_t Time = BenchTime() - Start;
+
+    FreeTree(Root);
+    return Time / 1e6;
+}
+
+static double
+BenchAncestorWalk(int Windows)
+{
+    tree_node *Root = (tree_node *) calloc(1, sizeof(tree_node));
+    std::set<tree_node *, ancestor_walk_order> Leaves;
+    Leaves.insert(Root);
+
+    uint64_t Start = BenchTime();
+    for(int Window = 1; Window < Windows; ++Window)
+    {
+        tree_node *Node = *Leaves.begin();
+        Leaves.erase(Leaves.begin());
+        SplitNode(Node);
+        Leaves.insert(Node->LeftChild);
+        Leaves.insert(Node->RightChild);
+    }
+    uint64_t Time = BenchTime() - Start;
+
+    FreeTree(Root);
+    return Time / 1e6;
+}
+
+static double
+BenchOrderKey(int Windows)
+{
+    space_info Space = {};
+    Space.RootNode = (tree_node *) calloc(1, sizeof(tree_node));
+    Space.RootNode->Generation = NextTreeGeneration();
+
+    uint64_t Start = BenchTime();
+    for(int Window = 1; Window < Windows; ++Window)
+    {
+        tree_node *Node = FindFirstMinDepthLeafNode(&Space);
+        SplitNode(Node);
+        AddMinDepthLeafPair(&Space, Node);
+    }
+    uint64_t Time = BenchTime() - Start;
+
+    FreeTree(Space.RootNode);
+    return Time / 1e6;
+}
+
+int main()
+{
+    int Sizes[] = { 1000, 10000 };
+    for(int Index = 0; Index < 2; ++Index)
+    {
+        int Windows = Sizes[Index];
+        printf("min-depth insert %5d windows: breadth-first %8.2f ms, ancestor-walk %6.2f ms, order-key %6.2f ms\n",
+               Windows, BenchBreadthFirst(Windows), BenchAncestorWalk(Windows), BenchOrderKey(Windows));
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "test.h"
+#include "../kwm/helpers.h"
+
+#include <float.h>
+
+static bool
+ParseDouble(const char *Text, double *Result)
+{
+    return ConvertTextToDouble(Text, strlen(Text), Result);
+}
+
+static void
+CheckRoundTrip()
+{
+    /* NOTE: Every value printed with 17 significant digits must parse back to the same bits. */
+    const double Values[] = { 0.1, 0.2, 0.3, 0.5, 1.0 / 3.0, 0.6180339887498949,
+                              DBL_MIN, DBL_MAX, DBL_EPSILON, 4.9406564584124654e-324,
+                              123456789.123456789, 9007199254740993.0 };
+
+    for(size_t Index = 0; Index < sizeof(Values) / sizeof(Values[0]); ++Index)
+    {
+        char Text[64];
+        snprintf(Text, sizeof(Text), "%.17g", Values[Index]);
+
+        double Result = 0;
+        Check(ParseDouble(Text, &Result));
+        Check(memcmp(&Result, &Values[Index], sizeof(double)) == 0);
+    }
+
+    uint64_t Seed = 0x9e3779b97f4a7c15ULL;
+    for(int Index = 0; Index < 100000; ++Index)
+    {
+        Seed ^= Seed << 13;
+        Seed ^= Seed >> 7;
+        Seed ^= Seed << 17;
+
+        double Value = (double)(Seed >> 11) / (double)(1ULL << 53);
+        char Text[64];
+        snprintf(Text, sizeof(Text), "%.17g", Value);
+
+        double Result = -1;
+        Check(ParseDouble(Text, &Result) && (Result == Value));
+    }
+}
+
+static void
+CheckAgainstStrtod()
+{
+    /* NOTE: Short inputs take the exact fast path; compare them with the C library. */
+    uint64_t Seed = 0x2545f4914f6cdd1dULL;
+    for(int Index = 0; Index < 100000; ++Index)
+    {
+        Seed ^= Seed << 13;
+        Seed ^= Seed >> 7;
+        Seed ^= Seed << 17;
+
+        char Text[64];
+        int Exponent = (int)((Seed >> 48) % 61) - 30;
+        snprintf(Text, sizeof(Text), "%llu.%llue%d", (unsigned long long)(Seed % 100000000ULL),
+                 (unsigned long long)((Seed >> 27) % 10000000ULL), Exponent);
+
+        double Result = -1;
+        Check(ParseDouble(Text, &Result) && (Result == strtod(Text, NULL)));
+    }
+}
+
+static void
+CheckDigits()
+{
+    double Result = 0;
+    Check(ParseDouble("0.1", &Result) && (Result == 0.1));
+    Check(ParseDouble("0.30000000000000004", &Result) && (Result == 0.1 + 0.2));
+    Check(ParseDouble("+2.5", &Result) && (Result == 2.5));
+    Check(ParseDouble("5.", &Result) && (Result == 5.0));
+    Check(ParseDouble(".5", &Result) && (Result == 0.5));
+    Check(ParseDouble("0.1000000000000000055511151231257827021181583404541015625", &Result) && (Result == 0.1));
+}
+
+static void
+CheckSignedZero()
+{
+    double Result = 1;
+    Check(ParseDouble("-0", &Result) && (Result == 0) && signbit(Result));
+    Check(ParseDouble("-0.0", &Result) && (Result == 0) && signbit(Result));
+    Check(ParseDouble("0", &Result) && (Result == 0) && !signbit(Result));
+}
+
+static void
+CheckExponent()
+{
+    double Result = 0;
+    Check(ParseDouble("1e3", &Result) && (Result == 1000.0));
+    Check(ParseDouble("2.5E-1", &Result) && (Result == 0.25));
+    Check(ParseDouble("1e+2", &Result) && (Result == 100.0));
+    Check(ParseDouble("1e-400", &Result) && (Result == 0));
+    Check(!ParseDouble("1e", &Result));
+    Check(!ParseDouble("1e+", &Result));
+    Check(!ParseDouble("e5", &Result));
+}
+
+static void
+CheckRejected()
+{
+    double Result = 42;
+    Check(!ParseDouble("1e309", &Result));
+    Check(!ParseDouble("-1e309", &Result));
+    Check(!ParseDouble("", &Result));
+    Check(!ParseDouble("-", &Result));
+    Check(!ParseDouble(".", &Result));
+    Check(!ParseDouble("0.5x", &Result));
+    Check(!ParseDouble("0.5 ", &Result));
+    Check(!ParseDouble(" 0.5", &Result));
+    Check(!ParseDouble("1.2.3", &Result));
+    Check(!ParseDouble("inf", &Result));
+    Check(!ParseDouble("nan", &Result));
+    Check(!ParseDouble("0x1p3", &Result));
+    Check(Result == 42);
+
+    /* NOTE: Only the given range is read, even when more digits follow it. */
+    Check(ConvertTextToDouble("0.55", 3, &Result) && (Result == 0.5));
+}
+
+static void
+CheckIntegers()
+{
+    int Int = 0;
+    Check(ConvertStringToInt("-2147483648", &Int) && (Int == INT_MIN));
+    Check(ConvertStringToInt("2147483647", &Int) && (Int == INT_MAX));
+    Check(!ConvertStringToInt("2147483648", &Int));
+    Check(!ConvertStringToInt("", &Int));
+    Check(!ConvertStringToInt("12a", &Int));
+
+    unsigned int Hex = 0;
+    Check(ConvertTextToHex("0xff00ff00", 10, &Hex) && (Hex == 0xff00ff00));
+    Check(!ConvertTextToHex("0x", 2, &Hex));
+    Check(!ConvertTextToHex("123456789", 9, &Hex));
+}
+
+int main()
+{
+    CheckRoundTrip();
+    CheckAgainstStrtod();
+    CheckDigits();
+    CheckSignedZero();
+    CheckExponent();
+    CheckRejected();
+    CheckIntegers();
+    return TestResult("numbers");
+}
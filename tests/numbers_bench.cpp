@@ -0,0 +1,40 @@
+#include "test.h"
+#include "../kwm/helpers.h"
+
+/* NOTE: Parses the kind of values found in kwmrc and saved trees, and compares the cost of
+         ConvertTextToDouble with the std::stod path it replaced. */
+int main()
+{
+    const char *Values[] = { "0.5", "0.35", "0.618033988749895", "1.75", "10", "0.05",
+                             "0.1", "2", "0.333333333333333", "12.5" };
+    const int Count = sizeof(Values) / sizeof(Values[0]);
+    int Lengths[Count];
+    for(int Index = 0; Index < Count; ++Index)
+        Lengths[Index] = strlen(Values[Index]);
+
+    const int Iterations = 1000000;
+    double Sum = 0;
+
+    uint64_t Start = BenchTime();
+    for(int Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        double Value;
+        int Index = Iteration % Count;
+        if(ConvertTextToDouble(Values[Index], Lengths[Index], &Value))
+            Sum += Value;
+    }
+    uint64_t Convert = BenchTime() - Start;
+
+    Start = BenchTime();
+    for(int Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        int Index = Iteration % Count;
+        std::string Value(Values[Index], Lengths[Index]);
+        Sum += std::stod(Value);
+    }
+    uint64_t Stod = BenchTime() - Start;
+
+    printf("ConvertTextToDouble %6.1f ns/value\n", (double) Convert / Iterations);
+    printf("std::stod           %6.1f ns/value\n", (double) Stod / Iterations);
+    return Sum > 0 ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#ifndef TESTS_TEST_H
+#define TESTS_TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/* NOTE: Minimal harness for the standalone checks run by 'make test'. A failed check is reported
+         and counted, and the test binary exits with a non-zero status. */
+static int TestFailures = 0;
+
+#define Check(Expression) do \
+                          { if(!(Expression)) \
+                              { \
+                                  printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #Expression); \
+                                  ++TestFailures; \
+                              } \
+                          } while(0)
+
+static inline int
+TestResult(const char *Name)
+{
+    printf("%-24s %s\n", Name, TestFailures ? "FAILED" : "ok");
+    return TestFailures ? 1 : 0;
+}
+
+/* NOTE: Wall-clock time in nanoseconds, for the benchmarks run by 'make bench'. */
+static inline uint64_t
+BenchTime()
+{
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (uint64_t) Time.tv_sec * 1000000000ULL + Time.tv_nsec;
+}
+
+#endif
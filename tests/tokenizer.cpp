@@ -0,0 +1,273 @@
+#include "test.h"
+#include "../kwm/tokenizer.h"
+#include "../kwm/interpreter.h"
+#include "../kwm/config.h"
+#include "../kwm/rules.h"
+#include "../kwm/daemon.h"
+#include "../kwm/query.h"
+#include "../kwm/window.h"
+#include "../kwm/kwm.h"
+#include "../axlib/axlib.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <new>
+
+/* NOTE: Every allocation made through operator new is counted, so that the checks below can
+         assert that tokenizing a command does not copy it. */
+static int Allocations = 0;
+
+void *operator new(std::size_t Size)
+{
+    ++Allocations;
+    void *Result = malloc(Size ? Size : 1);
+    if(!Result)
+        throw std::bad_alloc();
+
+    return Result;
+}
+
+void operator delete(void *Memory) noexcept
+{
+    free(Memory);
+}
+
+void operator delete(void *Memory, std::size_t Size) noexcept
+{
+    free(Memory);
+}
+
+static tokenizer
+BoundedTokenizer(char *Text, int Length)
+{
+    tokenizer Tokenizer = {};
+    Tokenizer.At = Text;
+    Tokenizer.End = Text + Length;
+    return Tokenizer;
+}
+
+/* NOTE: The handlers that the interpreter dispatches to. Each one records the tokens it was given,
+         and none of them allocate, so that the checks below only see the command path itself. */
+ax_display *FocusedDisplay = NULL;
+static token HandledCommand;
+static int HandledTokens;
+
+static void
+RecordHandledCommand(tokenizer *Tokenizer)
+{
+    HandledCommand = GetToken(Tokenizer);
+    HandledTokens = HandledCommand.Type == Token_EndOfStream ? 0 : 1;
+    while(GetToken(Tokenizer).Type != Token_EndOfStream)
+        ++HandledTokens;
+}
+
+bool KwmParseKwmc(tokenizer *Tokenizer, int ClientSockFD)
+{
+    RecordHandledCommand(Tokenizer);
+    return ClientSockFD != INVALID_SOCKFD;
+}
+
+void KwmAddRule(token RuleSym)
+{
+    tokenizer Tokenizer = BoundedTokenizer(RuleSym.Text, RuleSym.TextLength);
+    RecordHandledCommand(&Tokenizer);
+}
+
+void KwmQuit() { }
+void CarbonWhitelistProcess(std::string Name) { }
+void KwmWriteToSocket(std::string Msg, int ClientSockFD) { }
+void KwmAddSubscriber(int ClientSockFD, uint32_t Topics) { }
+void KwmInvalidateSnapshot(uint32_t Flags) { }
+void BeginDeferredWindowDimensions() { }
+bool EndDeferredWindowDimensions() { return false; }
+void NotifyLayoutChanged(ax_display *Display) { }
+void AXLibAddEvent(ax_event Event) { }
+
+static void
+CheckTokensStopAtEnd()
+{
+    char Text[] = "owner=\"iTerm2\" properties={float=\"true\"}";
+    tokenizer Tokenizer = BoundedTokenizer(Text, 5);
+
+    token Token = GetToken(&Tokenizer);
+    Check(Token.Type == Token_Identifier);
+    Check(Token.TextLength == 5);
+    Check(TokenEquals(Token, "owner"));
+    Check(GetToken(&Tokenizer).Type == Token_EndOfStream);
+    Check(GetToken(&Tokenizer).Type == Token_EndOfStream);
+    Check(Tokenizer.At == Text + 5);
+}
+
+static void
+CheckUnterminatedString()
+{
+    char Text[] = "name=\"unterminated\nkwmc rule owner=\"Steam\"";
+    int LineLength = strchr(Text, '\n') - Text;
+
+    tokenizer Tokenizer = BoundedTokenizer(Text, LineLength);
+    Check(GetToken(&Tokenizer).Type == Token_Identifier);
+    Check(GetToken(&Tokenizer).Type == Token_Equals);
+
+    token Token = GetToken(&Tokenizer);
+    Check(Token.Type == Token_Unknown);
+    Check(Tokenizer.At == Text + LineLength);
+    Check(GetToken(&Tokenizer).Type == Token_EndOfStream);
+
+    tokenizer Unbounded = {};
+    Unbounded.At = Text;
+    GetToken(&Unbounded);
+    GetToken(&Unbounded);
+    Check(GetToken(&Unbounded).Type == Token_String);
+}
+
+static void
+CheckMissingBrace()
+{
+    char Text[] = "properties={float=\"true\"\nkwmc config tiling bsp";
+    int LineLength = strchr(Text, '\n') - Text;
+    tokenizer Tokenizer = BoundedTokenizer(Text, LineLength);
+
+    int Tokens = 0;
+    token Token;
+    while((Token = GetToken(&Tokenizer)).Type != Token_EndOfStream)
+    {
+        Check(Token.Text + Token.TextLength <= Text + LineLength);
+        ++Tokens;
+    }
+
+    Check(Tokens == 6);
+}
+
+static void
+CheckCommentAtEnd()
+{
+    char Text[] = "#";
+    tokenizer Tokenizer = {};
+    Tokenizer.At = Text;
+
+    token Token = GetToken(&Tokenizer);
+    Check(Token.Type == Token_Comment);
+    Check(Token.TextLength == 0);
+    Check(GetToken(&Tokenizer).Type == Token_EndOfStream);
+}
+
+static void
+CheckDelimitedTokens()
+{
+    char Text[] = "shift+ctrl++alt";
+    tokenizer Tokenizer = {};
+    Tokenizer.At = Text;
+
+    const char *Expected[] = { "shift", "ctrl", "", "alt" };
+    int Count = 0;
+    token Token;
+    while(GetDelimitedToken(&Tokenizer, '+', &Token))
+    {
+        Check(Count < 4);
+        if(Count < 4)
+            Check(TokenEquals(Token, Expected[Count]));
+        ++Count;
+    }
+
+    Check(Count == 4);
+
+    char Line[] = "kwmc tree root split-ratio 0.5 trailing";
+    tokenizer Bounded = BoundedTokenizer(Line, strlen("kwmc tree root split-ratio 0.5"));
+    Count = 0;
+    while(GetDelimitedToken(&Bounded, ' ', &Token))
+        ++Count;
+
+    Check(Count == 5);
+    Check(TokenEquals(Token, "0.5"));
+}
+
+static void
+CheckNoAllocations()
+{
+    std::string Command("rule owner=\"iTerm2\" properties={role=\"AXDialog\"}   ");
+    tokenizer Tokenizer = {};
+    Tokenizer.At = const_cast<char *>(Command.c_str());
+
+    int Before = Allocations;
+    token Word = PeekToken(&Tokenizer);
+    GetToken(&Tokenizer);
+    token Rule = TrimToken(GetTokenTilEndOfLine(&Tokenizer));
+
+    tokenizer RuleTokenizer = BoundedTokenizer(Rule.Text, Rule.TextLength);
+    while(GetToken(&RuleTokenizer).Type != Token_EndOfStream);
+
+    Check(Allocations == Before);
+    Check(TokenEquals(Word, "rule"));
+    Check(Rule.Text[Rule.TextLength - 1] == '}');
+}
+
+static token
+CommandToken(char *Text, int Length)
+{
+    token Token = {};
+    Token.Type = Token_String;
+    Token.Text = Text;
+    Token.TextLength = Length;
+    return Token;
+}
+
+/* NOTE: Common commands are interpreted in the buffer of the caller. A command that ends at a
+         newline, like a line of the config, must not see the lines that follow it. */
+static void
+CheckInterpretNoAllocations()
+{
+    char Config[] = "config focus-follows-mouse on\n"
+                    "window -f east\n"
+                    "tree rotate 90\n"
+                    "space -t bsp\n"
+                    "rule owner=\"iTerm2\" properties={float=\"true\"}\n"
+                    "whitelist\n"
+                    "quit";
+
+    const char *Handled[] = { "config", "window", "tree", "space", "owner", NULL, NULL };
+    int Tokens[] = { 7, 4, 3, 4, 10, 0, 0 };
+
+    tokenizer Lines = {};
+    Lines.At = Config;
+    token Line;
+    int Count = 0;
+    while(GetDelimitedToken(&Lines, '\n', &Line))
+    {
+        HandledCommand = {};
+        HandledTokens = 0;
+
+        int Before = Allocations;
+        KwmInterpretCommand(CommandToken(Line.Text, Line.TextLength), INVALID_SOCKFD);
+        Check(Allocations == Before);
+
+        if(Count < 7)
+        {
+            Check(HandledTokens == Tokens[Count]);
+            if(Handled[Count])
+                Check(TokenEquals(HandledCommand, Handled[Count]));
+        }
+        ++Count;
+    }
+
+    Check(Count == 7);
+
+    /* NOTE: Queries are answered on the calling thread, so the daemon does not copy them either. */
+    std::string Query("query window focused id");
+    HandledCommand = {};
+    int Before = Allocations;
+    KwmQueueCommand(Query, INVALID_SOCKFD);
+    Check(Allocations == Before);
+    Check(TokenEquals(HandledCommand, "query"));
+}
+
+int main()
+{
+    CheckTokensStopAtEnd();
+    CheckUnterminatedString();
+    CheckMissingBrace();
+    CheckCommentAtEnd();
+    CheckDelimitedTokens();
+    CheckNoAllocations();
+    CheckInterpretNoAllocations();
+    return TestResult("tokenizer");
+}
@@ -0,0 +1,71 @@
+#include "test.h"
+#include "../axlib/worker.h"
+
+static void
+CheckQuarantineBackoff()
+{
+    /* NOTE: Half a second for the first strike, doubling up to the maximum, and never past it. */
+    Check(AXLibQuarantineBackoff(0) == AX_QUARANTINE_MIN);
+    Check(AXLibQuarantineBackoff(1) == 2 * AX_QUARANTINE_MIN);
+    Check(AXLibQuarantineBackoff(2) == 4 * AX_QUARANTINE_MIN);
+    Check(AXLibQuarantineBackoff(3) == 8 * AX_QUARANTINE_MIN);
+    Check(AXLibQuarantineBackoff(4) == AX_QUARANTINE_MAX);
+    Check(AXLibQuarantineBackoff(5) == AX_QUARANTINE_MAX);
+    Check(AXLibQuarantineBackoff(0xFFFFFFFF) == AX_QUARANTINE_MAX);
+
+    for(uint32_t Strikes = 1; Strikes < 64; ++Strikes)
+        Check(AXLibQuarantineBackoff(Strikes) >= AXLibQuarantineBackoff(Strikes - 1));
+}
+
+static void
+CheckCenterWindowFrame()
+{
+    CGSize Requested = { 800, 600 };
+
+    /* NOTE: A window that accepted the requested size stays where it was put. */
+    CGPoint Position = { 100, 50 };
+    CGSize Actual = { 800, 600 };
+    Check(!AXLibCenterWindowFrame(&Position, Requested, Actual));
+    Check(Position.x == 100 && Position.y == 50);
+
+    /* NOTE: Less than a pixel is a rounding difference, not a refused size. */
+    Actual.width = 799.5;
+    Check(!AXLibCenterWindowFrame(&Position, Requested, Actual));
+    Check(Position.x == 100 && Position.y == 50);
+
+    /* NOTE: A minimum width is centered horizontally only. */
+    Actual.width = 700;
+    Actual.height = 600;
+    Check(AXLibCenterWindowFrame(&Position, Requested, Actual));
+    Check(Position.x == 150 && Position.y == 50);
+
+    /* NOTE: A size increment in both directions, the offset is truncated to whole pixels. */
+    Position.x = 100;
+    Position.y = 50;
+    Actual.width = 795;
+    Actual.height = 581;
+    Check(AXLibCenterWindowFrame(&Position, Requested, Actual));
+    Check(Position.x == 102 && Position.y == 59);
+
+    /* NOTE: A window that ended up larger than requested keeps its position along that axis. */
+    Position.x = 100;
+    Position.y = 50;
+    Actual.width = 900;
+    Actual.height = 500;
+    Check(AXLibCenterWindowFrame(&Position, Requested, Actual));
+    Check(Position.x == 100 && Position.y == 100);
+
+    Position.x = 100;
+    Position.y = 50;
+    Actual.width = 900;
+    Actual.height = 700;
+    Check(!AXLibCenterWindowFrame(&Position, Requested, Actual));
+    Check(Position.x == 100 && Position.y == 50);
+}
+
+int main()
+{
+    CheckQuarantineBackoff();
+    CheckCenterWindowFrame();
+    return TestResult("worker");
+}